@@ -0,0 +1,370 @@
+/*
+ * File: apibench.c
+ *
+ * Description: Times the inventory library called directly, the way a
+ *              program linking libinventory would use it. A request file
+ *              (such as one from gencatalog) is split into calls once, up
+ *              front, and then replayed through the typed request functions
+ *              against several inventories open side by side, so no text
+ *              is read, tokenized or converted while the clock runs. Each
+ *              inventory's output is kept, and every inventory has to
+ *              print exactly the same thing as the first.
+ *
+ *              Useage: ./apibench [-i inventories] filename
+ *
+ *              -i  number of inventories to replay into (default 4)
+ *
+ * @author: Frank Abbey (fra1489)
+ * @version: 10/19/2026
+ */
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "libinventory.h"
+
+//a request with its arguments already converted
+struct call {
+    int code;      // REQUEST_ code
+    char * line;   // the request line, the IDs point into it
+    char * id;     // ID argument, NULL for none
+    int number;    // capacity (addAssembly), amount (stock/stockPart) or mode
+                   // (restock --forecast, inventory --all-sites)
+    char * site;   // site name (fulfillOrder/stock), NULL for the default
+    int count;     // number of ID/quantity pairs
+    char ** ids;
+    int * amounts;
+};
+
+//struct typedef declarations for ease of use
+typedef struct call call_t;
+
+/*
+ * Nanoseconds between two times
+ *
+ * @param struct timespec* from - the earlier time
+ * @param struct timespec* to - the later time
+ *
+ * @return double - the nanoseconds between them
+ */
+static double elapsed(struct timespec* from, struct timespec* to) {
+    return (to -> tv_sec - from -> tv_sec) * 1e9
+    + (to -> tv_nsec - from -> tv_nsec);
+}
+
+/*
+ * Split the ID/quantity pairs of a request into the arrays of a call. A
+ * missing last quantity counts as 0, as it does for a text request.
+ *
+ * @param call_t* call - the call the pairs go to
+ * @param char* array[] - the request's tokens
+ * @param int first - the index of the first pair
+ * @param int last - the index after the last token that can be in a pair
+ */
+static void split_call_pairs(call_t* call, char* array[], int first,
+                             int last) {
+
+    call -> count = (last > first) ? (last - first + 1) / 2 : 0;
+    call -> ids = malloc((call -> count + 1) * sizeof(char*));
+    call -> amounts = malloc((call -> count + 1) * sizeof(int));
+    int i;
+    for(i = 0; i < call -> count; i++) {
+        call -> ids[i] = array[first + 2 * i];
+        call -> amounts[i] = (first + 2 * i + 1 < last)
+        ? strtol(array[first + 2 * i + 1], NULL, 10) : 0;
+    }
+}
+
+/*
+ * Convert a request line into a call, with the same arguments the text
+ * request would be carried out with
+ *
+ * @param call_t* call - filled with the call
+ * @param char* line - the request line (kept by the call)
+ *
+ * @return int - 1: the line is a call, 0: it is blank, a comment, or a
+ *               request that would be ignored
+ */
+static int parse_call(call_t* call, char* line) {
+
+    char* array[MAX_LENGTH];
+    int size = tokenize(line, array);
+
+    memset(call, 0, sizeof(call_t));
+    call -> line = line;
+    if(size == 0) {
+        return 0;
+    }
+    call -> code = lookup_command(array[0]);
+    char* first = (size > 1) ? array[1] : "";
+    int at;    // 1 if the request names a site ('@site')
+
+    switch(call -> code) {
+    case REQUEST_ADD_PART:
+    case REQUEST_EMPTY:
+        call -> id = first;
+        return 1;
+    case REQUEST_ADD_ASSEMBLY:
+        call -> id = first;
+        call -> number = strtol((size > 2) ? array[2] : "", NULL, 10);
+        split_call_pairs(call, array, 3, size - ((size - 3) % 2 != 0));
+        return 1;
+    case REQUEST_FULFILL_ORDER:
+        at = (first[0] == '@');
+        call -> site = at ? first + 1 : NULL;
+        split_call_pairs(call, array, 1 + at,
+        (size >= 3 + at) ? size : 1 + at);
+        return 1;
+    case REQUEST_QUOTE:
+        split_call_pairs(call, array, 1, (size >= 3) ? size : 1);
+        return 1;
+    case REQUEST_STOCK:
+        at = (first[0] == '@');
+        call -> site = at ? first + 1 : NULL;
+        call -> id = (size > 1 + at) ? array[1 + at] : "";
+        call -> number = strtol((size > 2 + at) ? array[2 + at] : "", NULL,
+        10);
+        return size >= 3 + at;
+    case REQUEST_STOCK_PART:
+        call -> id = first;
+        call -> number = strtol((size > 2) ? array[2] : "", NULL, 10);
+        return size >= 3;
+    case REQUEST_RESTOCK:
+        //'number' is set for a forecast restock
+        call -> number = (size > 1 && strcmp(array[1], "--forecast") == 0);
+        call -> id = (size == 2 + call -> number)
+        ? array[1 + call -> number] : NULL;
+        return size <= 2 + call -> number;
+    case REQUEST_INVENTORY:
+        call -> id = (size == 1) ? NULL : array[1];
+        call -> number = (strcmp(first, "--all-sites") == 0);
+        return 1;
+    case REQUEST_PARTS:
+        call -> id = (size == 1) ? NULL : array[1];
+        return 1;
+    case REQUEST_HELP:
+    case REQUEST_CLEAR:
+    case REQUEST_QUIT:
+        return 1;
+    default:
+        //statistics and unknown commands are not library calls
+        return 0;
+    }
+}
+
+/*
+ * Carry out a call on an inventory
+ *
+ * @param inventory_t* invp - the inventory
+ * @param call_t* call - the call
+ *
+ * @return int - 0: if the call was 'quit'
+ *               1: all other cases
+ */
+static int run_call(inventory_t* invp, call_t* call) {
+
+    int site = (call -> site != NULL) ? lookup_site(invp, call -> site) : 0;
+    if(site < 0) {
+        return 1;
+    }
+
+    switch(call -> code) {
+    case REQUEST_ADD_PART:
+        add_part_request(invp, call -> id);
+        break;
+    case REQUEST_ADD_ASSEMBLY:
+        add_assembly_request(invp, call -> id, call -> number, call -> count,
+        call -> ids, call -> amounts, NULL);
+        break;
+    case REQUEST_FULFILL_ORDER:
+        fulfill_order_request(invp, site, call -> count, call -> ids,
+        call -> amounts);
+        break;
+    case REQUEST_QUOTE:
+        quote_request(invp, call -> count, call -> ids, call -> amounts);
+        break;
+    case REQUEST_STOCK:
+        stock_request(invp, site, call -> id, call -> number);
+        break;
+    case REQUEST_STOCK_PART:
+        stock_part_request(invp, call -> id, call -> number);
+        break;
+    case REQUEST_RESTOCK:
+        restock_request(invp, call -> id, call -> number);
+        break;
+    case REQUEST_EMPTY:
+        empty_request(invp, call -> id);
+        break;
+    case REQUEST_INVENTORY:
+        if(call -> number) {
+            all_sites_request(invp);
+        }
+        else {
+            inventory_request(invp, call -> id);
+        }
+        break;
+    case REQUEST_PARTS:
+        parts_request(invp, call -> id);
+        break;
+    case REQUEST_HELP:
+        help_request(invp);
+        break;
+    case REQUEST_CLEAR:
+        clear_inventory(invp);
+        break;
+    case REQUEST_QUIT:
+        return 0;
+    }
+    return 1;
+}
+
+/*
+ * Read every request of a file and convert it into a call
+ *
+ * @param FILE* fp - the file
+ * @param long* count - set to the number of calls
+ *
+ * @return call_t* - the calls
+ */
+static call_t* read_calls(FILE* fp, long* count) {
+
+    long size = 1024;
+    call_t* calls = malloc(size * sizeof(call_t));
+    char* buffer = NULL;
+    size_t n = 0;
+
+    *count = 0;
+    while(getline(&buffer, &n, fp) != -1) {
+        if(*count == size) {
+            size *= 2;
+            calls = realloc(calls, size * sizeof(call_t));
+        }
+        char* line = strdup(buffer);
+        if(parse_call(&calls[*count], line)) {
+            (*count)++;
+        }
+        else {
+            free(line);
+        }
+    }
+
+    free(buffer);
+    return calls;
+}
+
+/*
+ * Main function replays a request file into several inventories through
+ * the library and prints how fast they went
+ *
+ * @param int argc - the amount of arguments given
+ * @param char* argv[] - the arguments given
+ *
+ * @return int - EXIT_FAILURE: bad arguments, the file could not be read, or
+ *                             the inventories did not agree
+ *               EXIT_SUCCESS: the benchmark ran
+ */
+int main(int argc, char* argv[]) {
+
+    int inventories = 4;
+    int option;
+
+    while((option = getopt(argc, argv, "i:")) != -1) {
+        switch(option) {
+        case 'i': inventories = atoi(optarg); break;
+        default:
+            inventories = 0;
+            break;
+        }
+    }
+    if(inventories < 1 || optind != argc - 1) {
+        fprintf(stderr, "Useage: ./apibench [-i inventories] filename\n");
+        return EXIT_FAILURE;
+    }
+
+    FILE* fp = fopen(argv[optind], "r");
+    if(!fp) {
+        perror(argv[optind]);
+        return EXIT_FAILURE;
+    }
+    long count;
+    call_t* calls = read_calls(fp, &count);
+    fclose(fp);
+
+    //every inventory is open at once, each with its own output
+    inventory_t** invps = malloc(inventories * sizeof(inventory_t*));
+    char** out_buffers = calloc(inventories, sizeof(char*));
+    size_t* out_sizes = calloc(inventories, sizeof(size_t));
+    FILE** outs = malloc(inventories * sizeof(FILE*));
+    int i;
+    for(i = 0; i < inventories; i++) {
+        invps[i] = new_inventory();
+        outs[i] = open_memstream(&out_buffers[i], &out_sizes[i]);
+        set_output(invps[i], outs[i], outs[i]);
+    }
+
+    double load = 0;
+    double orders = 0;
+    long order_count = 0;
+    struct timespec start, end, begin, finish;
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for(i = 0; i < inventories; i++) {
+        long c;
+        for(c = 0; c < count; c++) {
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            int request_return = run_call(invps[i], &calls[c]);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+
+            if(calls[c].code == REQUEST_FULFILL_ORDER) {
+                orders += elapsed(&start, &end);
+                order_count++;
+            }
+            else if(calls[c].code == REQUEST_ADD_PART
+                    || calls[c].code == REQUEST_ADD_ASSEMBLY) {
+                load += elapsed(&start, &end);
+            }
+            if(!request_return) {
+                c = count;
+            }
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &finish);
+
+    int agree = 1;
+    for(i = 0; i < inventories; i++) {
+        fclose(outs[i]);
+        if(out_sizes[i] != out_sizes[0]
+           || memcmp(out_buffers[i], out_buffers[0], out_sizes[0]) != 0) {
+            agree = 0;
+        }
+    }
+
+    printf("inventories:  %d\n", inventories);
+    printf("calls:        %ld each\n", count);
+    printf("seconds:      %.3f\n", elapsed(&begin, &finish) / 1e9);
+    printf("load seconds: %.3f per inventory\n", load / 1e9 / inventories);
+    printf("orders/sec:   %.0f\n",
+    (orders > 0) ? order_count / (orders / 1e9) : 0.0);
+    printf("outputs:      %s\n", agree ? "identical" : "DIFFERENT");
+
+    for(i = 0; i < inventories; i++) {
+        free_inventory(invps[i]);
+        free(out_buffers[i]);
+    }
+    long c;
+    for(c = 0; c < count; c++) {
+        free(calls[c].line);
+        free(calls[c].ids);
+        free(calls[c].amounts);
+    }
+    free(calls);
+    free(invps);
+    free(out_buffers);
+    free(out_sizes);
+    free(outs);
+
+    return agree ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,371 @@
+/*
+ * File: batch.c
+ *
+ * Description: Runs a request file with its orders filled in batches. Runs
+ *              of consecutive fulfillOrder requests are held back, up to
+ *              a batch size, and handed to process_batch together, which
+ *              expands them down the BOM graph at once. Any other request
+ *              first fills the orders waiting, so it sees them done just
+ *              as it would have one at a time.
+ *
+ *              The sweep times a file filled one order at a time and then
+ *              in batches of 1, 2, 4, ... BATCH_MAX orders, each on a new
+ *              inventory, and checks every run printed the same rows (the
+ *              makes of an order may come in any order, since a batch
+ *              lists each assembly once with its total).
+ *
+ * @author: Frank Abbey (fra1489)
+ * @version: 10/19/2026
+ */
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "libinventory.h"
+#include "batch.h"
+
+/*
+ * Seconds between two times
+ *
+ * @param struct timespec* from - the earlier time
+ * @param struct timespec* to - the later time
+ *
+ * @return double - the seconds between them
+ */
+static double elapsed(struct timespec* from, struct timespec* to) {
+    return (to -> tv_sec - from -> tv_sec)
+    + (to -> tv_nsec - from -> tv_nsec) / 1e9;
+}
+
+/*
+ * Fill the orders waiting
+ *
+ * @param inventory_t* invp - the inventory the orders are filled from
+ * @param batch_queue_t* queue - the orders waiting
+ */
+static void fill_batch(inventory_t* invp, batch_queue_t* queue) {
+
+    if(queue -> count == 0) {
+        return;
+    }
+    process_batch(invp, queue -> requests, queue -> sizes, queue -> count);
+    queue -> orders += queue -> count;
+    queue -> batches++;
+
+    int i;
+    for(i = 0; i < queue -> count; i++) {
+        free(queue -> requests[i]);
+        free(queue -> lines[i]);
+    }
+    queue -> count = 0;
+}
+
+/*
+ * Hold an order back to be filled with the next batch, filling the batch
+ * first if it is full
+ *
+ * @param inventory_t* invp - the inventory orders are filled from
+ * @param batch_queue_t* queue - the orders waiting
+ * @param char* line - the order line (kept until the order is filled)
+ * @param char* array[] - the tokens of the line
+ * @param int size - the number of tokens
+ */
+static void queue_batch(inventory_t* invp, batch_queue_t* queue, char* line,
+                        char* array[], int size) {
+
+    if(queue -> count == queue -> size) {
+        fill_batch(invp, queue);
+    }
+    queue -> lines[queue -> count] = line;
+    queue -> requests[queue -> count] = malloc(size * sizeof(char*));
+    memcpy(queue -> requests[queue -> count], array, size * sizeof(char*));
+    queue -> sizes[queue -> count] = size;
+    queue -> count++;
+}
+
+/*
+ * Set up an empty queue of orders
+ *
+ * @param batch_queue_t* queue - the queue
+ * @param int size - the most orders filled together
+ */
+static void new_queue(batch_queue_t* queue, int size) {
+
+    memset(queue, 0, sizeof(*queue));
+    queue -> size = (size < 1) ? 1 : (size > BATCH_MAX) ? BATCH_MAX : size;
+    queue -> lines = malloc(queue -> size * sizeof(char*));
+    queue -> requests = malloc(queue -> size * sizeof(char**));
+    queue -> sizes = malloc(queue -> size * sizeof(int));
+}
+
+/*
+ * Free a queue of orders (with none waiting)
+ *
+ * @param batch_queue_t* queue - the queue
+ */
+static void free_queue(batch_queue_t* queue) {
+    free(queue -> lines);
+    free(queue -> requests);
+    free(queue -> sizes);
+}
+
+/*
+ * Carry out a request line, holding it back if it is an order
+ *
+ * @param inventory_t* invp - the inventory the request is carried out on
+ * @param batch_queue_t* queue - the orders waiting
+ * @param char* line - the request line (taken by this function)
+ *
+ * @return int - 0: the request was 'quit', 1: it was not
+ */
+static int batch_line(inventory_t* invp, batch_queue_t* queue, char* line) {
+
+    char* request_array[MAX_LENGTH];
+    int size = tokenize(line, request_array);
+    if(size == 0) {
+        free(line);
+        return 1;
+    }
+    if(lookup_command(request_array[0]) == REQUEST_FULFILL_ORDER) {
+        queue_batch(invp, queue, line, request_array, size);
+        return 1;
+    }
+    //anything else happens after every order read before it
+    fill_batch(invp, queue);
+    int request_return = process_request(invp, request_array, size);
+    free(line);
+    return request_return;
+}
+
+/*
+ * Run a request file with its orders filled in batches, and print the
+ * throughput to stderr (stdout has what the requests print)
+ *
+ * @param inventory_t* invp - the inventory the requests are carried out on
+ * @param FILE* fp - the file the requests are read from
+ * @param int size - the most orders filled together (at most BATCH_MAX)
+ *
+ * @return int - EXIT_SUCCESS: every request was run
+ */
+int run_batch(inventory_t* invp, FILE* fp, int size) {
+
+    batch_queue_t queue;
+    new_queue(&queue, size);
+
+    char* buffer = NULL;
+    size_t n = 0;
+    int request_return = 1;
+    struct timespec begin, finish;
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    while(request_return && getline(&buffer, &n, fp) != -1) {
+        //the tokens point into the line, so each line is kept until it runs
+        request_return = batch_line(invp, &queue, strdup(buffer));
+    }
+    fill_batch(invp, &queue);
+    clock_gettime(CLOCK_MONOTONIC, &finish);
+    //the report follows what the requests printed
+    fflush(stdout);
+
+    double seconds = elapsed(&begin, &finish);
+    fprintf(stderr, "orders:       %ld (batch %d)\n", queue.orders,
+    queue.size);
+    fprintf(stderr, "batches:      %ld\n", queue.batches);
+    fprintf(stderr, "seconds:      %.3f\n", seconds);
+    fprintf(stderr, "orders/sec:   %.0f\n",
+    (seconds > 0) ? queue.orders / seconds : 0.0);
+
+    free_queue(&queue);
+    free(buffer);
+
+    return EXIT_SUCCESS;
+}
+
+/*
+ * Add a row a request printed to a run's check
+ *
+ * @param void* context - the run's batch_check_t
+ * @param int type - the RECORD_ type of the row
+ * @param char* text - the ID or message of the row
+ * @param long long a - the first number of the row
+ * @param long long b - the second number of the row
+ */
+static void check_row(void* context, int type, char* text, long long a,
+                      long long b) {
+
+    batch_check_t* check = context;
+    //FNV-1a over the row
+    unsigned long long hash = 14695981039346656037ULL;
+    for(; *text != '\0'; text++) {
+        hash = (hash ^ (unsigned char)*text) * 1099511628211ULL;
+    }
+    if(type == RECORD_MADE) {
+        //a batch lists what an order made in its own order, so the makes
+        //are only summed
+        check -> made += hash * (unsigned long long)a;
+        return;
+    }
+    hash = (hash ^ (unsigned long long)type) * 1099511628211ULL;
+    hash = (hash ^ (unsigned long long)a) * 1099511628211ULL;
+    hash = (hash ^ (unsigned long long)b) * 1099511628211ULL;
+    check -> sequence = (check -> sequence ^ hash) * 1099511628211ULL;
+}
+
+/*
+ * Time one run of the requests of a file on a new inventory
+ *
+ * @param char* lines[] - the request lines
+ * @param long count - the number of lines
+ * @param int size - the most orders filled together, 0 to fill them with
+ *                   process_request one at a time
+ * @param FILE* sink - where the requests print to
+ * @param batch_check_t* check - set to what the run printed
+ *
+ * @return double - the seconds the requests took
+ */
+static double time_run(char* lines[], long count, int size, FILE* sink,
+                       batch_check_t* check) {
+
+    inventory_t* invp = new_inventory();
+    memset(check, 0, sizeof(*check));
+    set_output(invp, sink, sink);
+    set_record(invp, check_row, check);
+
+    //the lines are copied first so only the requests are timed
+    char** copies = malloc(count * sizeof(char*));
+    long i;
+    for(i = 0; i < count; i++) {
+        copies[i] = strdup(lines[i]);
+    }
+
+    batch_queue_t queue;
+    new_queue(&queue, size);
+    char* request_array[MAX_LENGTH];
+    int request_return = 1;
+    struct timespec begin, finish;
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for(i = 0; i < count && request_return; i++) {
+        if(size > 0) {
+            request_return = batch_line(invp, &queue, copies[i]);
+            copies[i] = NULL;
+        }
+        else {
+            int tokens = tokenize(copies[i], request_array);
+            request_return = (tokens == 0)
+            || process_request(invp, request_array, tokens);
+        }
+    }
+    fill_batch(invp, &queue);
+    clock_gettime(CLOCK_MONOTONIC, &finish);
+
+    //what was left in stock has to match too
+    inventory_request(invp, NULL);
+    all_sites_request(invp);
+    print_parts(invp);
+
+    for(i = 0; i < count; i++) {
+        free(copies[i]);
+    }
+    free(copies);
+    free_queue(&queue);
+    free_inventory(invp);
+    return elapsed(&begin, &finish);
+}
+
+/*
+ * Time the requests of a file a few times, each on a new inventory
+ *
+ * @param char* lines[] - the request lines
+ * @param long count - the number of lines
+ * @param int size - the most orders filled together, 0 for one at a time
+ * @param FILE* sink - where the requests print to
+ * @param batch_check_t* check - set to what the last run printed
+ *
+ * @return double - the seconds the fastest run took
+ */
+static double best_run(char* lines[], long count, int size, FILE* sink,
+                       batch_check_t* check) {
+
+    double best = time_run(lines, count, size, sink, check);
+    int run;
+    for(run = 1; run < BATCH_SWEEP_RUNS; run++) {
+        double seconds = time_run(lines, count, size, sink, check);
+        best = (seconds < best) ? seconds : best;
+    }
+    return best;
+}
+
+/*
+ * Time a request file filled one order at a time and in batches of 1, 2,
+ * 4, ... BATCH_MAX orders, and print a table of the speedups (what the
+ * requests print is thrown away). Each is the fastest of BATCH_SWEEP_RUNS
+ * runs.
+ *
+ * @param FILE* fp - the file the requests are read from
+ *
+ * @return int - EXIT_SUCCESS: every run printed the same rows,
+ *               EXIT_FAILURE: one did not, or /dev/null could not be opened
+ */
+int sweep_batch(FILE* fp) {
+
+    FILE* sink = fopen("/dev/null", "w");
+    if(!sink) {
+        perror("/dev/null");
+        return EXIT_FAILURE;
+    }
+
+    char** lines = NULL;
+    long count = 0;
+    long size = 0;
+    long orders = 0;
+    char* buffer = NULL;
+    size_t n = 0;
+    char* request_array[MAX_LENGTH];
+    while(getline(&buffer, &n, fp) != -1) {
+        if(count == size) {
+            size = (size == 0) ? 1024 : size * 2;
+            lines = realloc(lines, size * sizeof(char*));
+        }
+        lines[count] = strdup(buffer);
+        //the copy is only tokenized to count the orders
+        int tokens = tokenize(buffer, request_array);
+        orders += (tokens > 0 && lookup_command(request_array[0])
+                   == REQUEST_FULFILL_ORDER);
+        count++;
+    }
+    free(buffer);
+
+    batch_check_t expected, check;
+    double base = best_run(lines, count, 0, sink, &expected);
+    int status = EXIT_SUCCESS;
+
+    printf("%-8s %9s %12s %8s  %s\n", "Batch", "seconds", "orders/sec",
+    "speedup", "results");
+    printf("======== ========= ============ ========  =======\n");
+    printf("%-8s %9.3f %12.0f %8.2f  %s\n", "none", base,
+    (base > 0) ? orders / base : 0.0, 1.0, "-");
+
+    int batch;
+    for(batch = 1; batch <= BATCH_MAX; batch *= 2) {
+        double seconds = best_run(lines, count, batch, sink, &check);
+        int same = (check.sequence == expected.sequence
+                    && check.made == expected.made);
+        if(!same) {
+            status = EXIT_FAILURE;
+        }
+        printf("%-8d %9.3f %12.0f %8.2f  %s\n", batch, seconds,
+        (seconds > 0) ? orders / seconds : 0.0,
+        (seconds > 0) ? base / seconds : 0.0, same ? "same" : "DIFFERENT");
+    }
+
+    long i;
+    for(i = 0; i < count; i++) {
+        free(lines[i]);
+    }
+    free(lines);
+    fclose(sink);
+    return status;
+}
@@ -0,0 +1,50 @@
+/*
+ * File: batch.h
+ *
+ * Description: Function and struct definitions for filling orders in
+ *              batches, which hands runs of fulfillOrder requests to
+ *              process_batch together
+ *
+ * @author: Frank Abbey (fra1489)
+ * @version: 10/19/2026
+ */
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdio.h>
+#include "libinventory.h"
+
+//most orders filled together by default
+#define BATCH_DEFAULT 64
+//times each batch size is run in a sweep (the fastest run counts)
+#define BATCH_SWEEP_RUNS 3
+
+//the orders waiting to be filled together
+struct batch_queue {
+    char ** lines;           // the request lines, the tokens point into them
+    char *** requests;       // the tokens of each order
+    int * sizes;             // number of tokens of each order
+    int count;               // orders waiting
+    int size;                // most orders filled together
+    long orders;             // orders filled so far
+    long batches;            // batches filled so far
+};
+
+//what a run of requests printed, for comparing runs
+struct batch_check {
+    unsigned long long sequence; // every row but makes, in order
+    unsigned long long made;     // the makes, in any order
+};
+
+//struct typedef declarations for ease of use
+typedef struct batch_queue batch_queue_t;
+typedef struct batch_check batch_check_t;
+
+//run a request file with its orders filled in batches of 'size', and
+//print the throughput to stderr
+int run_batch(inventory_t * invp, FILE * fp, int size);
+//time a request file filled one order at a time and in batches of
+//1 to BATCH_MAX orders, and print the speedups
+int sweep_batch(FILE * fp);
+
+#endif // BATCH_H
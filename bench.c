@@ -0,0 +1,365 @@
+/*
+ * File: bench.c
+ *
+ * Description: Runs every request of a request file the same way the
+ *              serial loop does, but with the output thrown away and each
+ *              request timed. Afterwards the load time (addPart and
+ *              addAssembly), orders per second, latency percentiles of
+ *              each command and the peak memory use are printed.
+ *
+ *              The parse benchmark times only splitting request lines up
+ *              and reading their numbers, with the scanner of the library
+ *              and with the trim/strtok_r/strtol it replaced, and checks
+ *              the two agree on every line.
+ *
+ * @author: Frank Abbey (fra1489)
+ * @version: 10/19/2026
+ */
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+#include "libinventory.h"
+#include "trimit.h"
+#include "bench.h"
+
+/*
+ * Nanoseconds between two times
+ *
+ * @param struct timespec* from - the earlier time
+ * @param struct timespec* to - the later time
+ *
+ * @return double - the nanoseconds between them
+ */
+static double elapsed(struct timespec* from, struct timespec* to) {
+    return (to -> tv_sec - from -> tv_sec) * 1e9
+    + (to -> tv_nsec - from -> tv_nsec);
+}
+
+/*
+ * Compare two latencies
+ *
+ * @param const void* l1 - a void pointer representing a latency
+ * @param const void* l2 - a void pointer representing a latency
+ *
+ * @return int - <0, 0, >0 as l1 is less than, equal to, greater than l2
+ */
+static int latency_compare(const void* l1, const void* l2) {
+    double d1 = *(const double*)l1;
+    double d2 = *(const double*)l2;
+    return (d1 > d2) - (d1 < d2);
+}
+
+/*
+ * Add a latency to the timings of a kind of request
+ *
+ * @param timings_t* timings - the timings
+ * @param double nanoseconds - the latency
+ */
+static void add_timing(timings_t* timings, double nanoseconds) {
+
+    if(timings -> count == timings -> size) {
+        timings -> size = (timings -> size == 0) ? 1024 : timings -> size * 2;
+        timings -> nanoseconds = realloc(timings -> nanoseconds,
+        timings -> size * sizeof(double));
+    }
+    timings -> nanoseconds[timings -> count++] = nanoseconds;
+    timings -> total += nanoseconds;
+}
+
+/*
+ * Print the latency percentiles of a kind of request
+ *
+ * @param char* name - the name of the command
+ * @param timings_t* timings - the timings
+ */
+static void print_timings(char* name, timings_t* timings) {
+
+    double* latencies = timings -> nanoseconds;
+    long count = timings -> count;
+
+    qsort(latencies, count, sizeof(double), latency_compare);
+    printf("%-13s %9ld %10.3f %10.1f %10.1f %10.1f\n", name, count,
+    timings -> total / 1e9, latencies[count / 2] / 1e3,
+    latencies[(count * 99) / 100] / 1e3, latencies[count - 1] / 1e3);
+}
+
+/*
+ * Run every request in a file, timing each one, and print a report. The
+ * time to read a line is left out, the time to split it up is not.
+ *
+ * @param inventory_t* invp - the inventory the requests are carried out on
+ * @param FILE* fp - the file the requests are read from
+ *
+ * @return int - EXIT_SUCCESS: every request was run
+ */
+int run_bench(inventory_t* invp, FILE* fp) {
+
+    timings_t timings[REQUEST_COUNT];
+    memset(timings, 0, sizeof(timings));
+
+    //what the requests print is not part of the measurement
+    char* out_buffer = NULL;
+    char* err_buffer = NULL;
+    size_t out_size = 0;
+    size_t err_size = 0;
+    FILE* out = open_memstream(&out_buffer, &out_size);
+    FILE* err = open_memstream(&err_buffer, &err_size);
+    set_output(invp, out, err);
+
+    char* buffer = NULL;
+    size_t n = 0;
+    char* request_array[MAX_LENGTH];
+    int request_return = 1;
+    long errors = 0;
+    struct timespec start, end, begin, finish;
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+
+    while(request_return && getline(&buffer, &n, fp) != -1) {
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        int size = tokenize(buffer, request_array);
+        if(size != 0) {
+            int code = lookup_command(request_array[0]);
+            request_return = process_request(invp, request_array, size);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            add_timing(&timings[code], elapsed(&start, &end));
+
+            //requests that failed would skew the numbers, so count them
+            fflush(err);
+            if(err_size > 0) {
+                errors++;
+            }
+            fseeko(out, 0, SEEK_SET);
+            fseeko(err, 0, SEEK_SET);
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &finish);
+
+    set_output(invp, stdout, stderr);
+    fclose(out);
+    fclose(err);
+    free(out_buffer);
+    free(err_buffer);
+    free(buffer);
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    timings_t* orders = &timings[REQUEST_FULFILL_ORDER];
+    long requests = 0;
+    int code;
+    for(code = 0; code < REQUEST_COUNT; code++) {
+        requests += timings[code].count;
+    }
+
+    printf("requests:     %ld (%ld with errors)\n", requests, errors);
+    printf("seconds:      %.3f\n", elapsed(&begin, &finish) / 1e9);
+    printf("load seconds: %.3f\n", (timings[REQUEST_ADD_PART].total
+    + timings[REQUEST_ADD_ASSEMBLY].total) / 1e9);
+    printf("orders/sec:   %.0f\n",
+    (orders -> total > 0) ? orders -> count / (orders -> total / 1e9) : 0.0);
+    printf("peak RSS KB:  %ld\n", usage.ru_maxrss);
+    printf("\n%-13s %9s %10s %10s %10s %10s\n", "command", "count",
+    "seconds", "p50 usec", "p99 usec", "max usec");
+
+    for(code = 0; code < REQUEST_COUNT; code++) {
+        if(timings[code].count > 0) {
+            print_timings(command_names[code], &timings[code]);
+        }
+        free(timings[code].nanoseconds);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/*
+ * Split a request line the way tokenize() did before it scanned a chunk at
+ * a time, to check and time the scanner against
+ *
+ * @param char* line - the request line (changed in place)
+ * @param char* array[] - filled with the tokens, must hold MAX_LENGTH
+ *
+ * @return int - the number of tokens, 0 if the line holds no request
+ */
+static int reference_tokenize(char* line, char* array[]) {
+
+    char* token;
+    char* save;
+    int i = 0;
+
+    if(strlen(trim(line)) != 0 && line[0] != '#') {
+        token = strtok_r(line, " ", &save);
+        while(token != NULL && token[0] != '#' && i < MAX_LENGTH) {
+            array[i++] = token;
+            token = strtok_r(NULL, " ", &save);
+        }
+    }
+    return i;
+}
+
+/*
+ * Split up every line once and read every token as a number
+ *
+ * @param char* text - the lines, each followed by a '\0' (changed in place)
+ * @param size_t* starts - where each line starts
+ * @param long count - the number of lines
+ * @param int reference - 1: use reference_tokenize() and strtol(),
+ *                        0: use tokenize() and parse_number()
+ *
+ * @return long - the sum of the numbers, so none of the work is left out
+ */
+static long parse_pass(char* text, size_t* starts, long count, int reference) {
+
+    char* array[MAX_LENGTH];
+    unsigned long sum = 0;
+    long line;
+    int i, size;
+
+    for(line = 0; line < count; line++) {
+        if(reference) {
+            size = reference_tokenize(text + starts[line], array);
+            for(i = 0; i < size; i++) {
+                sum += strtol(array[i], NULL, 10);
+            }
+        }
+        else {
+            size = tokenize(text + starts[line], array);
+            for(i = 0; i < size; i++) {
+                sum += parse_number(array[i]);
+            }
+        }
+        sum += size;
+    }
+    return (long)sum;
+}
+
+/*
+ * Check that tokenize() and parse_number() split up and read every line
+ * the same as reference_tokenize() and strtol()
+ *
+ * @param char* text - the lines, each followed by a '\0'
+ * @param size_t* starts - where each line starts
+ * @param long count - the number of lines
+ *
+ * @return long - the number of lines they differ on
+ */
+static long check_parse(char* text, size_t* starts, long count) {
+
+    char* array[MAX_LENGTH];
+    char* expected[MAX_LENGTH];
+    long differ = 0;
+    long line;
+
+    for(line = 0; line < count; line++) {
+        char* copy = strdup(text + starts[line]);
+        char* expected_copy = strdup(text + starts[line]);
+        int size = tokenize(copy, array);
+        int expected_size = reference_tokenize(expected_copy, expected);
+        int same = (size == expected_size);
+        int i;
+        for(i = 0; same && i < size; i++) {
+            same = strcmp(array[i], expected[i]) == 0
+            && parse_number(array[i]) == strtol(expected[i], NULL, 10);
+        }
+        if(!same) {
+            if(differ == 0) {
+                fprintf(stderr, "parse differs on line %ld: %s", line + 1,
+                text + starts[line]);
+            }
+            differ++;
+        }
+        free(copy);
+        free(expected_copy);
+    }
+    return differ;
+}
+
+/*
+ * Time splitting up the lines of a request file and reading their numbers,
+ * with the library's scanner and with the one it replaced, and print the
+ * throughput of each in GB/s (the best of PARSE_RUNS runs)
+ *
+ * @param FILE* fp - the file the requests are read from
+ *
+ * @return int - EXIT_SUCCESS: the two agree on every line,
+ *               EXIT_FAILURE: they do not
+ */
+int run_parse_bench(FILE* fp) {
+
+    //the lines are kept one after another, each followed by a '\0'
+    char* text = NULL;
+    size_t length = 0;
+    size_t text_size = 0;
+    size_t* starts = NULL;
+    long count = 0;
+    long starts_size = 0;
+    char* buffer = NULL;
+    size_t n = 0;
+    ssize_t read;
+
+    while((read = getline(&buffer, &n, fp)) != -1) {
+        if(length + read + 1 > text_size) {
+            text_size = (text_size == 0) ? 1 << 20 : text_size * 2;
+            text_size = (text_size < length + read + 1) ?
+            length + read + 1 : text_size;
+            text = realloc(text, text_size);
+        }
+        if(count == starts_size) {
+            starts_size = (starts_size == 0) ? 1024 : starts_size * 2;
+            starts = realloc(starts, starts_size * sizeof(size_t));
+        }
+        starts[count++] = length;
+        memcpy(text + length, buffer, read + 1);
+        length += read + 1;
+    }
+    free(buffer);
+
+    long differ = check_parse(text, starts, count);
+
+    //each run splits up a fresh copy of the lines
+    char* work = malloc(length + 1);
+    double best[2] = {0, 0};
+    long sums[2] = {0, 0};
+    struct timespec start, end;
+    int run, reference;
+    for(run = 0; run < PARSE_RUNS; run++) {
+        for(reference = 0; reference < 2; reference++) {
+            memcpy(work, text, length);
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            sums[reference] = parse_pass(work, starts, count, reference);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            double nanoseconds = elapsed(&start, &end);
+            if(run == 0 || nanoseconds < best[reference]) {
+                best[reference] = nanoseconds;
+            }
+        }
+    }
+
+    //the bytes counted are the bytes of the file
+    double bytes = length - count;
+    printf("lines:        %ld\n", count);
+    printf("bytes:        %.0f\n", bytes);
+    printf("%-13s %10s %10s\n", "parser", "seconds", "GB/s");
+    printf("%-13s %10.4f %10.3f\n", "scan", best[0] / 1e9,
+    (best[0] > 0) ? bytes / best[0] : 0.0);
+    printf("%-13s %10.4f %10.3f\n", "strtok", best[1] / 1e9,
+    (best[1] > 0) ? bytes / best[1] : 0.0);
+    printf("speedup:      %.2fx\n", (best[0] > 0) ? best[1] / best[0] : 0.0);
+    printf("results:      %s\n", (differ == 0 && sums[0] == sums[1]) ?
+    "identical" : "DIFFERENT");
+    if(differ != 0) {
+        printf("lines differ: %ld\n", differ);
+    }
+
+    free(work);
+    free(text);
+    free(starts);
+
+    return (differ == 0 && sums[0] == sums[1]) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
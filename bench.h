@@ -0,0 +1,37 @@
+/*
+ * File: bench.h
+ *
+ * Description: Function and struct definitions for timing every request
+ *              of a request file and reporting where the time went, and
+ *              for timing how fast request lines are split up
+ *
+ * @author: Frank Abbey (fra1489)
+ * @version: 10/19/2026
+ */
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+#include "libinventory.h"
+
+//times each parser is run, the fastest is reported
+#define PARSE_RUNS 5
+
+//the latencies of every request of one kind
+struct timings {
+    double * nanoseconds;
+    long count;
+    long size;
+    double total;          // sum of the latencies
+};
+
+//struct typedef declarations for ease of use
+typedef struct timings timings_t;
+
+//run every request in a file, timing each one, and print a report
+int run_bench(inventory_t * invp, FILE * fp);
+//time splitting up the lines of a request file, with tokenize() and
+//parse_number() and with what they replaced, and print GB/s for each
+int run_parse_bench(FILE * fp);
+
+#endif // BENCH_H
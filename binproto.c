@@ -0,0 +1,800 @@
+/*
+ * File: binproto.c
+ *
+ * Description: The binary request protocol (see binproto.h for the frame
+ *              layout). Request frames are decoded straight into the
+ *              arguments of the request functions, so no text is trimmed,
+ *              tokenized or converted, and each reply is built from the
+ *              rows the request reports to the inventory's record
+ *              function. Also
+ *              holds the tools to encode a text request file and to print
+ *              binary replies as text.
+ *
+ * Table of Contents:
+ *
+ *      Section:           Line:
+ *      ------------------ -----
+ *      FIELDS                35
+ *      FRAMES               218
+ *      STREAMS              490
+ *
+ * @author: Frank Abbey (fra1489)
+ * @version: 10/19/2026
+ */
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "inventory.h"
+#include "binproto.h"
+#include "stats.h"
+
+/* - - - FIELDS - - -*/
+
+/*
+ * Write a u16 to a stream
+ *
+ * @param FILE* fp - the stream
+ * @param unsigned int value - the value to be written
+ */
+static void put_u16(FILE* fp, unsigned int value) {
+    fputc(value & 0xff, fp);
+    fputc((value >> 8) & 0xff, fp);
+}
+
+/*
+ * Write a u32 to a stream
+ *
+ * @param FILE* fp - the stream
+ * @param uint32_t value - the value to be written
+ */
+static void put_u32(FILE* fp, uint32_t value) {
+    fputc(value & 0xff, fp);
+    fputc((value >> 8) & 0xff, fp);
+    fputc((value >> 16) & 0xff, fp);
+    fputc((value >> 24) & 0xff, fp);
+}
+
+/*
+ * Write a u64 to a stream
+ *
+ * @param FILE* fp - the stream
+ * @param uint64_t value - the value to be written
+ */
+static void put_u64(FILE* fp, uint64_t value) {
+    put_u32(fp, (uint32_t)value);
+    put_u32(fp, (uint32_t)(value >> 32));
+}
+
+/*
+ * Write an id field (a u8 length and the bytes) to a stream
+ *
+ * @param FILE* fp - the stream
+ * @param char* id - the ID
+ *
+ * @return int - 1: the id was written, 0: it is too long to encode
+ */
+static int put_id(FILE* fp, char* id) {
+
+    size_t length = strlen(id);
+    if(length > BINARY_MAX_ID) {
+        return 0;
+    }
+    fputc(length, fp);
+    fwrite(id, 1, length, fp);
+    return 1;
+}
+
+/*
+ * Read a u32 length prefix
+ *
+ * @param const unsigned char* bytes - the four bytes of the prefix
+ *
+ * @return size_t - the length
+ */
+size_t get_length(const unsigned char* bytes) {
+    return (size_t)bytes[0] | ((size_t)bytes[1] << 8)
+    | ((size_t)bytes[2] << 16) | ((size_t)bytes[3] << 24);
+}
+
+/*
+ * Read a u8 from a frame
+ *
+ * @param reader_t* reader - the frame being read
+ *
+ * @return unsigned int - the value, 0 if the frame has ended
+ */
+static unsigned int get_u8(reader_t* reader) {
+    if(reader -> at + 1 > reader -> length) {
+        reader -> malformed = 1;
+        return 0;
+    }
+    return reader -> bytes[reader -> at++];
+}
+
+/*
+ * Read a u16 from a frame
+ *
+ * @param reader_t* reader - the frame being read
+ *
+ * @return unsigned int - the value, 0 if the frame has ended
+ */
+static unsigned int get_u16(reader_t* reader) {
+    if(reader -> at + 2 > reader -> length) {
+        reader -> malformed = 1;
+        return 0;
+    }
+    const unsigned char* bytes = reader -> bytes + reader -> at;
+    reader -> at += 2;
+    return bytes[0] | (bytes[1] << 8);
+}
+
+/*
+ * Read an i32 from a frame
+ *
+ * @param reader_t* reader - the frame being read
+ *
+ * @return int - the value, 0 if the frame has ended
+ */
+static int get_i32(reader_t* reader) {
+    if(reader -> at + 4 > reader -> length) {
+        reader -> malformed = 1;
+        return 0;
+    }
+    uint32_t value = get_length(reader -> bytes + reader -> at);
+    reader -> at += 4;
+    return (int32_t)value;
+}
+
+/*
+ * Read an i64 from a frame
+ *
+ * @param reader_t* reader - the frame being read
+ *
+ * @return long long - the value, 0 if the frame has ended
+ */
+static long long get_i64(reader_t* reader) {
+    if(reader -> at + 8 > reader -> length) {
+        reader -> malformed = 1;
+        return 0;
+    }
+    uint64_t value = get_length(reader -> bytes + reader -> at)
+    | ((uint64_t)get_length(reader -> bytes + reader -> at + 4) << 32);
+    reader -> at += 8;
+    return (int64_t)value;
+}
+
+/*
+ * Read an id field from a frame
+ *
+ * @param reader_t* reader - the frame being read
+ * @param char* into - filled with the ID (room for BINARY_MAX_ID plus NUL)
+ *
+ * @return char* - the ID, empty if the frame has ended
+ */
+static char* get_id(reader_t* reader, char* into) {
+
+    size_t length = get_u8(reader);
+    if(reader -> at + length > reader -> length) {
+        reader -> malformed = 1;
+        length = 0;
+    }
+    memcpy(into, reader -> bytes + reader -> at, length);
+    into[length] = '\0';
+    reader -> at += length;
+    return into;
+}
+
+/*
+ * Read a pairs field from a frame
+ *
+ * @param reader_t* reader - the frame being read
+ * @param char* ids[] - filled with the ID of each pair
+ * @param int amounts[] - filled with the quantity of each pair
+ * @param char strings[][BINARY_MAX_ID + 1] - room for the IDs
+ *
+ * @return int - the number of pairs
+ */
+static int get_pairs(reader_t* reader, char* ids[], int amounts[],
+                     char strings[][BINARY_MAX_ID + 1]) {
+
+    int count = get_u16(reader);
+    if(count > BINARY_MAX_PAIRS) {
+        reader -> malformed = 1;
+        return 0;
+    }
+
+    int i;
+    for(i = 0; i < count; i++) {
+        ids[i] = get_id(reader, strings[i]);
+        amounts[i] = get_i32(reader);
+    }
+    return count;
+}
+
+/* - - - FRAMES - - -*/
+
+/*
+ * Encode a row a request reports (the record function while a frame runs)
+ *
+ * @param void* context - the frames_t* of the session
+ * @param int type - the RECORD_ type of the row
+ * @param char* text - the ID or message of the row
+ * @param long long a - the row's first number
+ * @param long long b - the row's second number
+ */
+static void add_record(void* context, int type, char* text, long long a,
+                       long long b) {
+
+    FILE* records = ((frames_t*)context) -> records;
+    size_t length = strlen(text);
+    if(length > 0xffff) {
+        length = 0xffff;
+    }
+    fputc(type, records);
+    put_u16(records, length);
+    fwrite(text, 1, length, records);
+    put_u64(records, (uint64_t)a);
+    put_u64(records, (uint64_t)b);
+}
+
+/*
+ * Start a binary session, opening the streams requests print into while a
+ * frame runs
+ *
+ * @return frames_t* - the session, released with close_frames()
+ */
+frames_t* open_frames(void) {
+
+    frames_t* frames = calloc(1, sizeof(frames_t));
+    frames -> discard = open_memstream(&(frames -> discard_buffer),
+    &(frames -> discard_size));
+    frames -> errors = open_memstream(&(frames -> error_buffer),
+    &(frames -> error_size));
+    frames -> records = open_memstream(&(frames -> record_buffer),
+    &(frames -> record_size));
+    return frames;
+}
+
+/*
+ * Release what run_frame() keeps between the frames of a session
+ *
+ * @param frames_t* frames - the session
+ */
+void close_frames(frames_t* frames) {
+    fclose(frames -> discard);
+    fclose(frames -> errors);
+    fclose(frames -> records);
+    free(frames -> discard_buffer);
+    free(frames -> error_buffer);
+    free(frames -> record_buffer);
+    free(frames);
+}
+
+/*
+ * Decode the fields of a request and carry it out
+ *
+ * @param inventory_t* invp - the inventory the request is carried out on
+ * @param frames_t* frames - the session the request came in on
+ * @param int code - the REQUEST_ code of the request
+ * @param reader_t* reader - the rest of the frame
+ *
+ * @return int - 0: if command was 'quit'
+ *               1: all other cases
+ */
+static int run_fields(inventory_t* invp, frames_t* frames, int code,
+                      reader_t* reader) {
+
+    char (*strings)[BINARY_MAX_ID + 1] = frames -> strings;
+    char* ids[BINARY_MAX_PAIRS];
+    int amounts[BINARY_MAX_PAIRS];
+    char* id = NULL;
+    char* site_name = "";
+    int number = 0;
+    int count = 0;
+
+    //every field is read before anything is carried out
+    switch(code) {
+    case REQUEST_ADD_ASSEMBLY:
+        id = get_id(reader, strings[BINARY_MAX_PAIRS]);
+        number = get_i32(reader);
+        count = get_pairs(reader, ids, amounts, strings);
+        break;
+    case REQUEST_FULFILL_ORDER:
+        count = get_pairs(reader, ids, amounts, strings);
+        //the site is optional, so older frames still decode
+        if(reader -> at < reader -> length) {
+            site_name = get_id(reader, strings[BINARY_MAX_PAIRS]);
+        }
+        break;
+    case REQUEST_QUOTE:
+        count = get_pairs(reader, ids, amounts, strings);
+        break;
+    case REQUEST_STOCK:
+        id = get_id(reader, strings[BINARY_MAX_PAIRS]);
+        number = get_i32(reader);
+        if(reader -> at < reader -> length) {
+            site_name = get_id(reader, strings[0]);
+        }
+        break;
+    case REQUEST_STATS:
+    case REQUEST_STOCK_PART:
+        id = get_id(reader, strings[BINARY_MAX_PAIRS]);
+        number = get_i32(reader);
+        break;
+    case REQUEST_RESTOCK:
+        id = get_id(reader, strings[BINARY_MAX_PAIRS]);
+        //the mode byte is optional, so older frames still decode
+        if(reader -> at < reader -> length) {
+            number = get_u8(reader);
+        }
+        break;
+    case REQUEST_INVENTORY:
+        id = get_id(reader, strings[BINARY_MAX_PAIRS]);
+        if(reader -> at < reader -> length) {
+            number = get_u8(reader);
+        }
+        break;
+    case REQUEST_ADD_PART:
+    case REQUEST_EMPTY:
+    case REQUEST_UNKNOWN:
+        id = get_id(reader, strings[BINARY_MAX_PAIRS]);
+        break;
+    case REQUEST_PARTS:
+        //the prefix is optional, so older frames still decode
+        if(reader -> at < reader -> length) {
+            id = get_id(reader, strings[BINARY_MAX_PAIRS]);
+        }
+        break;
+    case REQUEST_HELP:
+    case REQUEST_CLEAR:
+    case REQUEST_QUIT:
+    case REQUEST_MEMSTATS:
+        break;
+    default:
+        fprintf(invp -> err, "!!! %d: unknown request code\n", code);
+        return 1;
+    }
+
+    if(reader -> malformed || reader -> at != reader -> length) {
+        fprintf(invp -> err, "!!! %s: malformed request\n",
+        command_names[code]);
+        return 1;
+    }
+
+    //a named site is looked up (or added) before the request runs
+    int site = (site_name[0] != '\0') ? lookup_site(invp, site_name) : 0;
+    if(site < 0) {
+        return 1;
+    }
+
+    switch(code) {
+    case REQUEST_ADD_PART:
+        add_part_request(invp, id);
+        break;
+    case REQUEST_ADD_ASSEMBLY:
+        add_assembly_request(invp, id, number, count, ids, amounts,
+        NULL);
+        break;
+    case REQUEST_FULFILL_ORDER:
+        fulfill_order_request(invp, site, count, ids, amounts);
+        break;
+    case REQUEST_QUOTE:
+        quote_request(invp, count, ids, amounts);
+        break;
+    case REQUEST_STOCK:
+        stock_request(invp, site, id, number);
+        break;
+    case REQUEST_STOCK_PART:
+        stock_part_request(invp, id, number);
+        break;
+    case REQUEST_RESTOCK:
+        restock_request(invp, (id[0] == '\0') ? NULL : id, number != 0);
+        break;
+    case REQUEST_EMPTY:
+        empty_request(invp, id);
+        break;
+    case REQUEST_INVENTORY:
+        if(number != 0) {
+            all_sites_request(invp);
+        }
+        else {
+            inventory_request(invp, (id[0] == '\0') ? NULL : id);
+        }
+        break;
+    case REQUEST_PARTS:
+        parts_request(invp, id);
+        break;
+    case REQUEST_HELP:
+        help_request(invp);
+        break;
+    case REQUEST_MEMSTATS:
+        memstats_request(invp);
+        break;
+    case REQUEST_CLEAR:
+        clear_inventory(invp);
+        break;
+    case REQUEST_QUIT:
+        return 0;
+    case REQUEST_STATS:
+        if(id[0] == '\0') {
+            print_stats(invp, invp -> out);
+        }
+        else {
+            stats_dump_to(invp, id, number);
+        }
+        break;
+    default:
+        fprintf(invp -> err, "!!! %s: unknown command\n", id);
+        break;
+    }
+    return 1;
+}
+
+/*
+ * Carry out one request frame and write its reply frame. The errors the
+ * request prints become RECORD_ERROR rows, without their "!!! " prefix.
+ *
+ * @param inventory_t* invp - the inventory the request is carried out on
+ * @param frames_t* frames - the session the frame came in on
+ * @param const unsigned char* frame - the frame, after its length prefix
+ * @param size_t length - the length of the frame
+ * @param FILE* reply - the stream the reply frame is written to
+ *
+ * @return int - 0: if command was 'quit'
+ *               1: all other cases
+ */
+int run_frame(inventory_t* invp, frames_t* frames, const unsigned char* frame,
+              size_t length, FILE* reply) {
+
+    FILE* out = invp -> out;
+    FILE* err = invp -> err;
+    record_fn_t record = invp -> record;
+    void* record_context = invp -> record_context;
+    set_output(invp, frames -> discard, frames -> errors);
+    set_record(invp, add_record, frames);
+
+    STATS_START(began);
+    reader_t reader = { frame, length, 0, 0 };
+    int code = get_u8(&reader);
+    int request_return = run_fields(invp, frames, code, &reader);
+    STATS_STOP(invp, (code < REQUEST_COUNT) ? code : REQUEST_UNKNOWN, began);
+
+    set_output(invp, out, err);
+    set_record(invp, record, record_context);
+
+    fflush(frames -> errors);
+    char* error_buffer = frames -> error_buffer;
+    size_t error_size = frames -> error_size;
+    size_t start = 0;
+    while(start < error_size) {
+        char* line = error_buffer + start;
+        char* newline = memchr(line, '\n', error_size - start);
+        size_t end = (newline != NULL) ? (size_t)(newline - error_buffer)
+        : error_size;
+        error_buffer[end] = '\0';
+        if(strncmp(line, "!!! ", 4) == 0) {
+            line += 4;
+        }
+        add_record(frames, RECORD_ERROR, line, 0, 0);
+        start = end + 1;
+    }
+
+    fflush(frames -> records);
+    put_u32(reply, 2 + frames -> record_size);
+    fputc(code, reply);
+    fputc(error_size > 0, reply);
+    fwrite(frames -> record_buffer, 1, frames -> record_size, reply);
+
+    fseeko(frames -> discard, 0, SEEK_SET);
+    fseeko(frames -> errors, 0, SEEK_SET);
+    fseeko(frames -> records, 0, SEEK_SET);
+
+    return request_return;
+}
+
+/* - - - STREAMS - - -*/
+
+/*
+ * Read and check the magic bytes at the start of a binary stream
+ *
+ * @param FILE* fp - the stream
+ *
+ * @return int - 1: the stream is binary, 0: it is not
+ */
+static int read_magic(FILE* fp) {
+    char magic[BINARY_MAGIC_LENGTH];
+    if(fread(magic, 1, BINARY_MAGIC_LENGTH, fp) != BINARY_MAGIC_LENGTH
+       || memcmp(magic, BINARY_MAGIC, BINARY_MAGIC_LENGTH) != 0) {
+        fprintf(stderr, "!!! not a binary stream\n");
+        return 0;
+    }
+    return 1;
+}
+
+/*
+ * Read the next frame of a binary stream
+ *
+ * @param FILE* fp - the stream
+ * @param unsigned char* frame - filled with the frame (BINARY_MAX_FRAME)
+ * @param size_t* length - set to the length of the frame
+ *
+ * @return int - 1: a frame was read, 0: the stream ended, -1: it is corrupt
+ */
+static int read_frame(FILE* fp, unsigned char* frame, size_t* length) {
+
+    unsigned char prefix[4];
+    size_t num = fread(prefix, 1, 4, fp);
+    if(num == 0) {
+        return 0;
+    }
+    if(num != 4) {
+        fprintf(stderr, "!!! binary stream ends inside a frame\n");
+        return -1;
+    }
+
+    *length = get_length(prefix);
+    if(*length > BINARY_MAX_FRAME) {
+        fprintf(stderr, "!!! binary frame too long\n");
+        return -1;
+    }
+    if(fread(frame, 1, *length, fp) != *length) {
+        fprintf(stderr, "!!! binary stream ends inside a frame\n");
+        return -1;
+    }
+    return 1;
+}
+
+/*
+ * Carry out every request frame of a binary stream, up to a 'quit'
+ *
+ * @param inventory_t* invp - the inventory the requests are carried out on
+ * @param FILE* in - the binary request stream
+ * @param FILE* out - the stream the binary replies are written to
+ *
+ * @return int - EXIT_FAILURE: the request stream is not binary or corrupt
+ *               EXIT_SUCCESS: every request was run
+ */
+int run_binary(inventory_t* invp, FILE* in, FILE* out) {
+
+    if(!read_magic(in)) {
+        return EXIT_FAILURE;
+    }
+    fwrite(BINARY_MAGIC, 1, BINARY_MAGIC_LENGTH, out);
+
+    unsigned char* frame = malloc(BINARY_MAX_FRAME);
+    frames_t* frames = open_frames();
+    size_t length;
+    int status = 0;
+    int request_return = 1;
+
+    while(request_return && (status = read_frame(in, frame, &length)) > 0) {
+        request_return = run_frame(invp, frames, frame, length, out);
+    }
+
+    free(frame);
+    close_frames(frames);
+    fflush(out);
+
+    return (request_return && status < 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/*
+ * Write the pairs of a text request
+ *
+ * @param FILE* fp - the stream the frame is built in
+ * @param char* array[] - the array containing the command and its arguments
+ * @param int first - the index of the first pair
+ * @param int last - the index after the last token that can be in a pair
+ *
+ * @return int - 1: the pairs were written, 0: an ID was too long
+ */
+static int put_pairs(FILE* fp, char* array[], int first, int last) {
+
+    int encoded = 1;
+    put_u16(fp, (last - first + 1) / 2);
+    int i;
+    for(i = first; i < last; i += 2) {
+        encoded &= put_id(fp, array[i]);
+        put_u32(fp, (uint32_t)strtol((i + 1 < last) ? array[i + 1] : "",
+        NULL, 10));
+    }
+    return encoded;
+}
+
+/*
+ * Convert a text request file to a binary request stream. Each request is
+ * encoded with the arguments the text request would be carried out with,
+ * and requests the text grammar ignores are left out.
+ *
+ * @param FILE* in - the text request file
+ * @param FILE* out - the stream the binary requests are written to
+ *
+ * @return int - EXIT_SUCCESS
+ */
+int encode_requests(FILE* in, FILE* out) {
+
+    char* frame_buffer = NULL;
+    size_t frame_size = 0;
+    FILE* frame = open_memstream(&frame_buffer, &frame_size);
+
+    char* buffer = NULL;
+    size_t n = 0;
+    char* array[MAX_LENGTH];
+
+    fwrite(BINARY_MAGIC, 1, BINARY_MAGIC_LENGTH, out);
+
+    while(getline(&buffer, &n, in) != -1) {
+
+        int size = tokenize(buffer, array);
+        if(size == 0) {
+            continue;
+        }
+
+        int code = lookup_command(array[0]);
+        char* arg1 = (size > 1) ? array[1] : "";
+        int encoded = 1;
+        int at;
+        fputc(code, frame);
+
+        switch(code) {
+        case REQUEST_ADD_ASSEMBLY:
+            encoded = put_id(frame, arg1);
+            put_u32(frame, (uint32_t)strtol((size > 2) ? array[2] : "",
+            NULL, 10));
+            //a last ID without a quantity is ignored
+            encoded &= put_pairs(frame, array, 3,
+            (size > 3) ? size - ((size - 3) % 2) : 3);
+            break;
+        case REQUEST_FULFILL_ORDER:
+            //an '@site' goes after the pairs
+            at = (arg1[0] == '@');
+            encoded = put_pairs(frame, array, 1 + at,
+            (size >= 3 + at) ? size : 1 + at);
+            //an empty site name is not the default site, it is an error
+            if(at) {
+                encoded &= (arg1[1] != '\0') && put_id(frame, arg1 + 1);
+            }
+            break;
+        case REQUEST_QUOTE:
+            encoded = put_pairs(frame, array, 1, (size >= 3) ? size : 1);
+            break;
+        case REQUEST_STOCK:
+            at = (arg1[0] == '@');
+            encoded = (size >= 3 + at)
+            && put_id(frame, (size > 1 + at) ? array[1 + at] : "");
+            put_u32(frame, (uint32_t)strtol((size > 2 + at) ? array[2 + at]
+            : "", NULL, 10));
+            //an empty site name is not the default site, it is an error
+            if(at) {
+                encoded &= (arg1[1] != '\0') && put_id(frame, arg1 + 1);
+            }
+            break;
+        case REQUEST_STOCK_PART:
+            encoded = (size >= 3) && put_id(frame, arg1);
+            put_u32(frame, (uint32_t)strtol((size > 2) ? array[2] : "",
+            NULL, 10));
+            break;
+        case REQUEST_STATS:
+            encoded = put_id(frame, arg1);
+            put_u32(frame, (uint32_t)strtol((size > 2) ? array[2] : "",
+            NULL, 10));
+            break;
+        case REQUEST_RESTOCK:
+            if(size > 1 && strcmp(arg1, "--forecast") == 0) {
+                encoded = (size <= 3)
+                && put_id(frame, (size > 2) ? array[2] : "");
+                fputc(1, frame);
+            }
+            else {
+                encoded = (size <= 2) && put_id(frame, arg1);
+            }
+            break;
+        case REQUEST_INVENTORY:
+            if(strcmp(arg1, "--all-sites") == 0) {
+                encoded = put_id(frame, "");
+                fputc(1, frame);
+            }
+            else {
+                encoded = put_id(frame, arg1);
+            }
+            break;
+        case REQUEST_ADD_PART:
+        case REQUEST_EMPTY:
+            encoded = put_id(frame, arg1);
+            break;
+        case REQUEST_PARTS:
+            if(size > 1) {
+                encoded = put_id(frame, arg1);
+            }
+            break;
+        case REQUEST_UNKNOWN:
+            encoded = put_id(frame, array[0]);
+            break;
+        default:
+            break;
+        }
+
+        fflush(frame);
+        if(encoded) {
+            put_u32(out, frame_size);
+            fwrite(frame_buffer, 1, frame_size, out);
+        }
+        else {
+            fprintf(stderr, "!!! %s: request not encoded\n", array[0]);
+        }
+        fseeko(frame, 0, SEEK_SET);
+    }
+
+    free(buffer);
+    fclose(frame);
+    free(frame_buffer);
+    fflush(out);
+
+    return EXIT_SUCCESS;
+}
+
+/*
+ * Print a binary reply stream as text, one line per reply and one line per
+ * row of the reply
+ *
+ * @param FILE* in - the binary reply stream
+ * @param FILE* out - the stream the text is printed to
+ *
+ * @return int - EXIT_FAILURE: the reply stream is not binary or corrupt
+ *               EXIT_SUCCESS: every reply was printed
+ */
+int print_replies(FILE* in, FILE* out) {
+
+    static char* types[] = { "?", "made", "restocked", "part", "quoted",
+    "assembly", "component", "part_id", "error", "shortage" };
+
+    if(!read_magic(in)) {
+        return EXIT_FAILURE;
+    }
+
+    unsigned char* frame = malloc(BINARY_MAX_FRAME);
+    char text[0xffff + 1];
+    size_t length;
+    int status = 0;
+
+    while((status = read_frame(in, frame, &length)) > 0) {
+
+        reader_t reader = { frame, length, 0, 0 };
+        unsigned int code = get_u8(&reader);
+        unsigned int failed = get_u8(&reader);
+        fprintf(out, "= %s%s\n",
+        (code < REQUEST_COUNT) ? command_names[code] : "?",
+        failed ? " (errors)" : "");
+
+        while(!reader.malformed && reader.at < reader.length) {
+            unsigned int type = get_u8(&reader);
+            unsigned int size = get_u16(&reader);
+            if(reader.at + size > reader.length) {
+                reader.malformed = 1;
+                size = 0;
+            }
+            memcpy(text, reader.bytes + reader.at, size);
+            text[size] = '\0';
+            reader.at += size;
+            long long a = get_i64(&reader);
+            long long b = get_i64(&reader);
+
+            if(type == RECORD_ERROR) {
+                fprintf(out, "  error     %s\n", text);
+            }
+            else {
+                fprintf(out, "  %-9s %-11s %8lld %8lld\n",
+                (type <= RECORD_SHORTAGE) ? types[type] : "?", text, a, b);
+            }
+        }
+        if(reader.malformed) {
+            fprintf(stderr, "!!! malformed reply\n");
+        }
+    }
+
+    free(frame);
+    return (status < 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
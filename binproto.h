@@ -0,0 +1,109 @@
+/*
+ * File: binproto.h
+ *
+ * Description: Function and struct definitions for the binary request
+ *              protocol, a compact encoding of the request grammar for
+ *              programs that feed orders in volume and would rather not
+ *              have every request formatted and parsed as text
+ *
+ *              A binary stream (requests or replies) starts with the four
+ *              bytes of BINARY_MAGIC and is followed by frames. Every
+ *              number is little-endian.
+ *
+ *              Request frame:
+ *                  u32 length of the rest of the frame
+ *                  u8  REQUEST_ code of the command
+ *                  then the command's fields:
+ *                      addPart             id
+ *                      addAssembly         id, i32 capacity, pairs
+ *                      fulfillOrder        pairs, optional id site
+ *                      quote               pairs
+ *                      stock               id, i32 amount, optional id site
+ *                      stockPart           id, i32 amount
+ *                      restock             id (empty for every assembly),
+ *                                          optional u8 mode (1: forecast)
+ *                      inventory           id (empty for every assembly),
+ *                                          optional u8 mode (1: all sites)
+ *                      empty               id
+ *                      stats               id (dump file, empty to print),
+ *                                          i32 requests between dumps
+ *                      unknown             id (the command as given)
+ *                      parts               optional id (prefix)
+ *                      help/clear/quit     nothing
+ *                  where an id is a u8 length and the bytes of the ID, and
+ *                  pairs are a u16 count followed by that many id, i32
+ *
+ *              Reply frame:
+ *                  u32 length of the rest of the frame
+ *                  u8  REQUEST_ code of the command replied to
+ *                  u8  status, 0: no errors, 1: the request had errors
+ *                  then records up to the end of the frame, each:
+ *                      u8 RECORD_ type, u16 text length, text, i64 a, i64 b
+ *
+ * @author: Frank Abbey (fra1489)
+ * @version: 10/19/2026
+ */
+#ifndef BINPROTO_H
+#define BINPROTO_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include "libinventory.h"
+
+//first bytes of a binary stream (a text request never starts with NUL)
+#define BINARY_MAGIC "\0INV"
+#define BINARY_MAGIC_LENGTH 4
+//largest frame accepted, length prefix not included
+#define BINARY_MAX_FRAME 65536
+//longest string a frame can carry
+#define BINARY_MAX_ID 255
+//most ID/quantity pairs in one request
+#define BINARY_MAX_PAIRS (MAX_LENGTH / 2)
+
+//position within a request frame being decoded
+struct reader {
+    const unsigned char * bytes;
+    size_t length;
+    size_t at;      // next byte to be read
+    int malformed;  // set if a field ran past the end of the frame
+};
+
+//a binary session: what run_frame() keeps between frames
+struct frames {
+    FILE * discard;        // what a request prints as text, dropped
+    char * discard_buffer;
+    size_t discard_size;
+    FILE * errors;         // errors a request prints, sent as RECORD_ERROR
+    char * error_buffer;
+    size_t error_size;
+    FILE * records;        // rows a request reports, already encoded
+    char * record_buffer;
+    size_t record_size;
+    char strings[BINARY_MAX_PAIRS + 1][BINARY_MAX_ID + 1]; // decoded IDs
+};
+
+//struct typedef declarations for ease of use
+typedef struct reader reader_t;
+typedef struct frames frames_t;
+
+//read a u32 length prefix
+size_t get_length(const unsigned char * bytes);
+//start a binary session
+frames_t * open_frames(void);
+//carry out one request frame and write its reply frame, returns 0 if the
+//request was 'quit'
+int run_frame(inventory_t * invp,
+              frames_t * frames,
+              const unsigned char * frame,
+              size_t length,
+              FILE * reply);
+//release a binary session
+void close_frames(frames_t * frames);
+//carry out every request frame of a binary stream
+int run_binary(inventory_t * invp, FILE * in, FILE * out);
+//convert a text request file to a binary request stream
+int encode_requests(FILE * in, FILE * out);
+//print a binary reply stream as text
+int print_replies(FILE * in, FILE * out);
+
+#endif // BINPROTO_H
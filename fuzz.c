@@ -0,0 +1,1258 @@
+/*
+ * File: fuzz.c
+ *
+ * Description: A fuzz and differential test harness for the request
+ *              processor. LLVMFuzzerTestOneInput() takes any bytes and
+ *              does two things with them:
+ *
+ *              - runs them as request lines, one per line of input, through
+ *                tokenize() and process_request() on a new inventory, so a
+ *                crash, a sanitizer report or a leak on any input is found
+ *
+ *              - uses them as the choices of a request generator that only
+ *                uses a handful of IDs (P0-P7, A0-A11, sites main, s1, s2),
+ *                so the requests mostly hit each other. Every request is run
+ *                on the inventory and on a reference model here, which keeps
+ *                plain arrays and does each request the obvious way. After
+ *                each request the parts needed and part shortages it
+ *                reported, the assemblies on hand (at the main site and
+ *                added up over every site) and the parts list (all of
+ *                it, and the parts starting with a prefix) have to be the
+ *                same, or the requests so far are printed and the harness
+ *                aborts.
+ *
+ *              Built with -DFUZZ_LIBFUZZER it is a libFuzzer target (see
+ *              'make fuzz-libfuzzer'). Otherwise it has its own main, which
+ *              runs the files it is given as inputs, or with no files runs
+ *              seeded random request sequences through the differential:
+ *
+ *                  ./fuzz [-s seed] [-r runs] [-n requests] [-m store]
+ *                         [file ...]
+ *
+ *              With '-m' the differential runs are on an inventory kept in
+ *              that store file (made anew for each run), which is closed
+ *              and opened again every FUZZ_REOPEN requests, so what it
+ *              keeps across a restart is checked against the model too.
+ *
+ *              Every FUZZ_SNAPSHOT requests a snapshot is taken and held
+ *              while more requests are run (up to the next one that
+ *              changes the catalog), and then has to list the assemblies
+ *              and parts exactly as the inventory did when it was taken.
+ *              At the end of a run, a second 'restock --forecast' right
+ *              after a first one has to build nothing.
+ *
+ * @author: Frank Abbey (fra1489)
+ * @version: 10/19/2026
+ */
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "libinventory.h"
+
+//sizes of the model's ID pools (P0.., A0..) and its sites
+#define MODEL_PARTS 8
+#define MODEL_ASSEMBLIES 12
+#define MODEL_SITES 3
+//most items one assembly is made from
+#define MODEL_ITEMS 3
+//what the standalone harness runs when not told otherwise
+#define FUZZ_RUNS 1000
+#define FUZZ_REQUESTS 200
+//requests between reopening a store ('-m')
+#define FUZZ_REOPEN 25
+//requests between snapshots, which are held for half as many requests
+#define FUZZ_SNAPSHOT 8
+
+//the sites the generated requests use, the first is the default site
+static char* model_sites[MODEL_SITES] = { SITE_DEFAULT, "s1", "s2" };
+
+//an assembly as the reference model keeps it
+struct model_assembly {
+    int exists;
+    long long capacity;
+    long long on_hand[MODEL_SITES];
+    int item_count;
+    int items[MODEL_ITEMS];         // < MODEL_PARTS: part, else assembly
+    long long quantities[MODEL_ITEMS];
+};
+
+//the reference model: everything in fixed arrays, indexed by ID number
+struct model {
+    int parts[MODEL_PARTS];                  // 1: the part was added
+    long long part_stock[MODEL_PARTS];       // -1: not stocked
+    struct model_assembly assemblies[MODEL_ASSEMBLIES];
+    int added[MODEL_ASSEMBLIES];             // assemblies in order added
+    int added_count;
+    long long needed[MODEL_PARTS];           // parts the request needed
+    long long short_by[MODEL_PARTS];         // parts the request was short
+};
+
+//a result row, as reported by the inventory or expected from the model
+struct row {
+    int type;
+    char id[ID_MAX + 1];
+    long long a;
+    long long b;
+};
+
+//the rows of one request or one listing
+struct rows {
+    struct row* row_array;
+    int row_count;
+    int row_size;
+};
+
+//where the generated requests get their choices from
+struct chooser {
+    const uint8_t* data;        // the fuzz input, NULL for the PRNG
+    size_t size;
+    size_t at;                  // next byte of the input to use
+    unsigned long long state;   // xorshift state
+};
+
+//one differential run
+struct fuzz_run {
+    inventory_t* invp;
+    struct model model;
+    struct chooser chooser;
+    struct rows engine;         // rows the inventory reported
+    struct rows expected;       // rows the model says it should have
+    char (* log)[MAX_LENGTH];   // every request run so far
+    int log_count;
+    int log_size;
+    snapshot_t* snapshot;       // the snapshot being held, or NULL
+    char* listed;               // what was listed when it was taken
+    size_t listed_length;
+    int snapshot_age;           // requests run since it was taken
+};
+
+//struct typedef declarations for ease of use
+typedef struct model_assembly model_assembly_t;
+typedef struct model model_t;
+typedef struct row row_t;
+typedef struct rows rows_t;
+typedef struct chooser chooser_t;
+typedef struct fuzz_run fuzz_run_t;
+
+//requests print here, only their result rows are looked at
+static FILE* sink = NULL;
+//store file the differential runs keep their inventory in, or NULL
+static char* store_path = NULL;
+
+/* - - - ROWS - - -*/
+
+/*
+ * Add a row to a list of rows
+ *
+ * @param rows_t* rows - the list
+ * @param int type - the RECORD_ kind of row
+ * @param char* id - the ID of the row
+ * @param long long a - the first number of the row
+ * @param long long b - the second number of the row
+ */
+static void add_row(rows_t* rows, int type, char* id, long long a,
+                    long long b) {
+
+    if(rows -> row_count == rows -> row_size) {
+        rows -> row_size = (rows -> row_size == 0) ? 64 : rows -> row_size * 2;
+        rows -> row_array = realloc(rows -> row_array,
+        rows -> row_size * sizeof(row_t));
+    }
+    row_t* row = &(rows -> row_array[rows -> row_count++]);
+    row -> type = type;
+    snprintf(row -> id, sizeof(row -> id), "%s", id);
+    row -> a = a;
+    row -> b = b;
+}
+
+/*
+ * Keep the result rows the differential compares (the record function set
+ * on the inventory)
+ *
+ * @param void* context - the rows_t the rows are added to
+ * @param int type - the RECORD_ kind of row
+ * @param char* text - the ID of the row
+ * @param long long a - the first number of the row
+ * @param long long b - the second number of the row
+ */
+static void capture(void* context, int type, char* text, long long a,
+                    long long b) {
+
+    if(type == RECORD_PART || type == RECORD_SHORTAGE
+       || type == RECORD_ASSEMBLY || type == RECORD_PART_ID) {
+        add_row((rows_t*)context, type, text, a, b);
+    }
+}
+
+/*
+ * Compare two rows
+ *
+ * @param const void* r1 - a void pointer representing a row
+ * @param const void* r2 - a void pointer representing a row
+ *
+ * @return int - <0, 0, >0 as r1 sorts before, with, after r2
+ */
+static int row_compare(const void* r1, const void* r2) {
+
+    const row_t* row1 = r1;
+    const row_t* row2 = r2;
+    if(row1 -> type != row2 -> type) {
+        return row1 -> type - row2 -> type;
+    }
+    return strcmp(row1 -> id, row2 -> id);
+}
+
+/*
+ * Print a row, or that there is none
+ *
+ * @param char* label - who the row is from
+ * @param row_t* row - the row, NULL if there is none
+ */
+static void print_row(char* label, row_t* row) {
+
+    if(row == NULL) {
+        fprintf(stderr, "    %-9s (no row)\n", label);
+    }
+    else {
+        fprintf(stderr, "    %-9s type %d %s %lld %lld\n", label, row -> type,
+        row -> id, row -> a, row -> b);
+    }
+}
+
+/*
+ * Compare the rows the inventory reported with the rows the model expects,
+ * and print the first difference
+ *
+ * @param fuzz_run_t* run - the run
+ * @param char* what - what the rows are, for the report
+ *
+ * @return int - 1: the same, 0: they differ
+ */
+static int same_rows(fuzz_run_t* run, char* what) {
+
+    rows_t* engine = &(run -> engine);
+    rows_t* expected = &(run -> expected);
+    if(engine -> row_count > 1) {
+        qsort(engine -> row_array, engine -> row_count, sizeof(row_t),
+        row_compare);
+    }
+    if(expected -> row_count > 1) {
+        qsort(expected -> row_array, expected -> row_count, sizeof(row_t),
+        row_compare);
+    }
+
+    int i;
+    for(i = 0; i < engine -> row_count || i < expected -> row_count; i++) {
+        row_t* got = (i < engine -> row_count) ?
+        &(engine -> row_array[i]) : NULL;
+        row_t* want = (i < expected -> row_count) ?
+        &(expected -> row_array[i]) : NULL;
+        if(got == NULL || want == NULL || row_compare(got, want) != 0
+           || got -> a != want -> a || got -> b != want -> b) {
+            fprintf(stderr, "!!! differential: %s differ after request %d\n",
+            what, run -> log_count);
+            print_row("expected", want);
+            print_row("engine", got);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* - - - MODEL - - -*/
+
+/*
+ * Name a part or assembly of the model
+ *
+ * @param int item - the item (< MODEL_PARTS: part, else assembly)
+ * @param char* id - set to the ID (at least ID_MAX + 1 chars)
+ */
+static void item_id(int item, char* id) {
+
+    //(the model has few items, which the casts let the compiler see, so
+    //it knows the ID fits)
+    if(item < MODEL_PARTS) {
+        sprintf(id, "P%hu", (unsigned short)item);
+    }
+    else {
+        sprintf(id, "A%hu", (unsigned short)(item - MODEL_PARTS));
+    }
+}
+
+/*
+ * Empty the model, as clear does to the inventory
+ *
+ * @param model_t* model - the model
+ */
+static void model_clear(model_t* model) {
+
+    memset(model, 0, sizeof(model_t));
+    int part;
+    for(part = 0; part < MODEL_PARTS; part++) {
+        model -> part_stock[part] = -1;
+    }
+}
+
+static void model_make(model_t* model, int site, int assembly, long long n);
+
+/*
+ * Make the items of a number of assemblies: parts are needed, assemblies
+ * are taken from stock
+ *
+ * @param model_t* model - the model
+ * @param int site - the site sub-assemblies are taken from
+ * @param int assembly - the assembly
+ * @param long long n - the number being made
+ */
+static void model_build(model_t* model, int site, int assembly, long long n) {
+
+    model_assembly_t* a = &(model -> assemblies[assembly]);
+    int i;
+    for(i = 0; i < a -> item_count; i++) {
+        long long quantity = a -> quantities[i] * n;
+        if(a -> items[i] < MODEL_PARTS) {
+            model -> needed[a -> items[i]] += quantity;
+        }
+        else {
+            model_make(model, site, a -> items[i] - MODEL_PARTS, quantity);
+        }
+    }
+}
+
+/*
+ * Take a number of assemblies out of stock, making what is not on hand
+ * (an order line and a sub-assembly needed are taken the same way)
+ *
+ * @param model_t* model - the model
+ * @param int site - the site the order is filled from
+ * @param int assembly - the assembly
+ * @param long long n - the number ordered
+ */
+static void model_make(model_t* model, int site, int assembly, long long n) {
+
+    long long* on_hand = &(model -> assemblies[assembly].on_hand[site]);
+    if(n >= *on_hand) {
+        long long to_make = n - *on_hand;
+        *on_hand = 0;
+        model_build(model, site, assembly, to_make);
+    }
+    else {
+        *on_hand -= n;
+    }
+}
+
+/*
+ * Stock an assembly up to at most its capacity
+ *
+ * @param model_t* model - the model
+ * @param int site - the site stocked
+ * @param int assembly - the assembly
+ * @param long long n - the number to stock
+ */
+static void model_stock(model_t* model, int site, int assembly, long long n) {
+
+    model_assembly_t* a = &(model -> assemblies[assembly]);
+    long long* on_hand = &(a -> on_hand[site]);
+    long long amount = n;
+    if(*on_hand + n > a -> capacity) {
+        amount = a -> capacity - *on_hand;
+        *on_hand = a -> capacity;
+    }
+    else {
+        *on_hand += n;
+    }
+    if(amount > 0) {
+        model_build(model, site, assembly, amount);
+    }
+}
+
+/*
+ * Restock an assembly at the main site if it is below half its capacity
+ *
+ * @param model_t* model - the model
+ * @param int assembly - the assembly
+ */
+static void model_restock(model_t* model, int assembly) {
+
+    model_assembly_t* a = &(model -> assemblies[assembly]);
+    if(a -> on_hand[0] < (double)(a -> capacity) / 2.0) {
+        model_stock(model, 0, assembly, a -> capacity - a -> on_hand[0]);
+    }
+}
+
+/*
+ * Check the parts a request needed against part stock
+ *
+ * @param model_t* model - the model
+ * @param int take - 1: take them out of stock, 0: only check them
+ */
+static void model_take(model_t* model, int take) {
+
+    int part;
+    for(part = 0; part < MODEL_PARTS; part++) {
+        long long* stock = &(model -> part_stock[part]);
+        if(model -> needed[part] > 0 && *stock != -1) {
+            long long short_by = model -> needed[part] - *stock;
+            if(take) {
+                *stock = (short_by > 0) ? 0 : -short_by;
+            }
+            if(short_by > 0) {
+                model -> short_by[part] = short_by;
+            }
+        }
+    }
+}
+
+/*
+ * Fill or quote an order: every line has to be a known assembly and a
+ * positive amount, or nothing happens
+ *
+ * @param model_t* model - the model
+ * @param int site - the site the order is filled from
+ * @param int count - the number of lines
+ * @param int assemblies[] - the assembly of each line (-1: not one)
+ * @param int amounts[] - the amount of each line
+ * @param int quote - 1: put everything back afterwards
+ */
+static void model_order(model_t* model, int site, int count,
+                        int assemblies[], int amounts[], int quote) {
+
+    model_t* before = malloc(sizeof(model_t));
+    memcpy(before, model, sizeof(model_t));
+    int valid = (count > 0);
+    int i;
+    for(i = 0; i < count && valid; i++) {
+        if(amounts[i] <= 0 || assemblies[i] < 0
+           || !model -> assemblies[assemblies[i]].exists) {
+            valid = 0;
+        }
+        else {
+            model_make(model, site, assemblies[i], amounts[i]);
+        }
+    }
+    if(valid) {
+        model_take(model, !quote);
+    }
+    if(!valid || quote) {
+        //the parts needed and shortages of a valid quote are still reported
+        long long needed[MODEL_PARTS];
+        long long short_by[MODEL_PARTS];
+        memcpy(needed, model -> needed, sizeof(needed));
+        memcpy(short_by, model -> short_by, sizeof(short_by));
+        memcpy(model, before, sizeof(model_t));
+        if(valid) {
+            memcpy(model -> needed, needed, sizeof(needed));
+            memcpy(model -> short_by, short_by, sizeof(short_by));
+        }
+    }
+    free(before);
+}
+
+/* - - - GENERATOR - - -*/
+
+/*
+ * Pick a number
+ *
+ * @param chooser_t* chooser - where the choice comes from
+ * @param int n - how many numbers there are to pick from
+ *
+ * @return int - a number from 0 to n - 1 (0 once the input has run out)
+ */
+static int choose(chooser_t* chooser, int n) {
+
+    unsigned long long value;
+    if(chooser -> data != NULL) {
+        value = (chooser -> at < chooser -> size) ?
+        chooser -> data[chooser -> at++] : 0;
+    }
+    else {
+        chooser -> state ^= chooser -> state << 13;
+        chooser -> state ^= chooser -> state >> 7;
+        chooser -> state ^= chooser -> state << 17;
+        value = chooser -> state >> 11;
+    }
+    return (int)(value % n);
+}
+
+/*
+ * Pick an amount: mostly small positive numbers, sometimes zero or less
+ *
+ * @param chooser_t* chooser - where the choice comes from
+ * @param int most - the largest amount
+ *
+ * @return int - the amount
+ */
+static int choose_amount(chooser_t* chooser, int most) {
+
+    if(choose(chooser, 10) == 0) {
+        return choose(chooser, 3) - 2;
+    }
+    return 1 + choose(chooser, most);
+}
+
+/*
+ * Append a token to a request line
+ *
+ * @param char* line - the line
+ * @param char* token - the token
+ */
+static void append(char* line, char* token) {
+
+    size_t length = strlen(line);
+    snprintf(line + length, MAX_LENGTH - length, "%s%s",
+    (length > 0) ? " " : "", token);
+}
+
+/*
+ * Append a number to a request line
+ *
+ * @param char* line - the line
+ * @param long long n - the number
+ */
+static void append_number(char* line, long long n) {
+
+    char token[32];
+    sprintf(token, "%lld", n);
+    append(line, token);
+}
+
+/*
+ * Generate a request, carry it out on the model, and write it as the
+ * request line the inventory is given
+ *
+ * @param fuzz_run_t* run - the run
+ * @param char* line - set to the request line
+ */
+static void generate(fuzz_run_t* run, char* line) {
+
+    model_t* model = &(run -> model);
+    chooser_t* chooser = &(run -> chooser);
+    char id[ID_MAX + 1];
+    int kind = choose(chooser, 100);
+
+    line[0] = '\0';
+    memset(model -> needed, 0, sizeof(model -> needed));
+    memset(model -> short_by, 0, sizeof(model -> short_by));
+
+    if(kind < 10) {
+        int part = choose(chooser, MODEL_PARTS);
+        item_id(part, id);
+        append(line, "addPart");
+        append(line, id);
+        model -> parts[part] = 1;
+    }
+    else if(kind < 25) {
+        int assembly = choose(chooser, MODEL_ASSEMBLIES);
+        int capacity = (choose(chooser, 10) == 0) ? -1 : choose(chooser, 40);
+        model_assembly_t* a = &(model -> assemblies[assembly]);
+        model_assembly_t added;
+        memset(&added, 0, sizeof(added));
+        int valid = !a -> exists && capacity >= 0;
+        item_id(MODEL_PARTS + assembly, id);
+        append(line, "addAssembly");
+        append(line, id);
+        append_number(line, capacity);
+
+        //the items: mostly parts, sometimes sub-assemblies. Now and then
+        //they are those of the last assembly added, with a quantity
+        //sometimes changed, so BOM rows are shared (or nearly are).
+        model_assembly_t* like = (model -> added_count > 0
+                                  && choose(chooser, 4) == 0)
+        ? &(model -> assemblies[model -> added[model -> added_count - 1]])
+        : NULL;
+        int count = like ? like -> item_count
+        : choose(chooser, MODEL_ITEMS + 1);
+        int i;
+        for(i = 0; i < count; i++) {
+            int item;
+            int quantity;
+            if(like) {
+                item = like -> items[i];
+                quantity = like -> quantities[i] + (choose(chooser, 4) == 0);
+            }
+            else {
+                item = (choose(chooser, 3) == 0) ?
+                MODEL_PARTS + choose(chooser, MODEL_ASSEMBLIES) :
+                choose(chooser, MODEL_PARTS);
+                quantity = (choose(chooser, 10) == 0) ?
+                0 : 1 + choose(chooser, 4);
+            }
+            item_id(item, id);
+            append(line, id);
+            append_number(line, quantity);
+
+            int exists = (item < MODEL_PARTS) ? model -> parts[item] :
+            model -> assemblies[item - MODEL_PARTS].exists;
+            if(!exists || quantity <= 0) {
+                valid = 0;
+            }
+            added.items[added.item_count] = item;
+            added.quantities[added.item_count++] = quantity;
+        }
+        if(valid) {
+            added.exists = 1;
+            added.capacity = capacity;
+            *a = added;
+            model -> added[model -> added_count++] = assembly;
+        }
+    }
+    else if(kind < 60) {
+        //orders and quotes
+        int quote = (kind >= 50);
+        int site = 0;
+        append(line, quote ? "quote" : "fulfillOrder");
+        if(!quote && choose(chooser, 2) == 0) {
+            site = choose(chooser, MODEL_SITES);
+            char at[ID_MAX + 2];
+            sprintf(at, "@%s", model_sites[site]);
+            append(line, at);
+        }
+        int assemblies[MODEL_ITEMS];
+        int amounts[MODEL_ITEMS];
+        int count = choose(chooser, MODEL_ITEMS + 1);
+        int i;
+        for(i = 0; i < count; i++) {
+            //one ID past the pool is never added
+            assemblies[i] = choose(chooser, MODEL_ASSEMBLIES + 1);
+            amounts[i] = choose_amount(chooser, 20);
+            item_id(MODEL_PARTS + assemblies[i], id);
+            append(line, id);
+            append_number(line, amounts[i]);
+            if(assemblies[i] == MODEL_ASSEMBLIES) {
+                assemblies[i] = -1;
+            }
+        }
+        model_order(model, site, count, assemblies, amounts, quote);
+    }
+    else if(kind < 75) {
+        int site = 0;
+        int assembly = choose(chooser, MODEL_ASSEMBLIES);
+        int amount = choose_amount(chooser, 30);
+        append(line, "stock");
+        if(choose(chooser, 2) == 0) {
+            site = choose(chooser, MODEL_SITES);
+            char at[ID_MAX + 2];
+            sprintf(at, "@%s", model_sites[site]);
+            append(line, at);
+        }
+        item_id(MODEL_PARTS + assembly, id);
+        append(line, id);
+        append_number(line, amount);
+        if(amount > 0 && model -> assemblies[assembly].exists) {
+            model_stock(model, site, assembly, amount);
+            model_take(model, 1);
+        }
+    }
+    else if(kind < 83) {
+        append(line, "restock");
+        if(choose(chooser, 2) == 0) {
+            int assembly = choose(chooser, MODEL_ASSEMBLIES);
+            item_id(MODEL_PARTS + assembly, id);
+            append(line, id);
+            if(model -> assemblies[assembly].exists) {
+                model_restock(model, assembly);
+            }
+        }
+        else {
+            //the newest assembly is restocked first
+            int i;
+            for(i = model -> added_count - 1; i >= 0; i--) {
+                model_restock(model, model -> added[i]);
+            }
+        }
+        model_take(model, 1);
+    }
+    else if(kind < 91) {
+        int part = choose(chooser, MODEL_PARTS);
+        int amount = choose_amount(chooser, 50);
+        item_id(part, id);
+        append(line, "stockPart");
+        append(line, id);
+        append_number(line, amount);
+        if(amount > 0 && model -> parts[part]) {
+            if(model -> part_stock[part] == -1) {
+                model -> part_stock[part] = 0;
+            }
+            model -> part_stock[part] += amount;
+        }
+    }
+    else if(kind < 96) {
+        int assembly = choose(chooser, MODEL_ASSEMBLIES);
+        item_id(MODEL_PARTS + assembly, id);
+        append(line, "empty");
+        append(line, id);
+        if(model -> assemblies[assembly].exists) {
+            model -> assemblies[assembly].on_hand[0] = 0;
+        }
+    }
+    else if(kind < 99) {
+        //listings change nothing
+        append(line, (kind == 96) ? "parts" : "inventory");
+        if(kind == 98) {
+            item_id(MODEL_PARTS + choose(chooser, MODEL_ASSEMBLIES), id);
+            append(line, id);
+        }
+    }
+    else {
+        append(line, "clear");
+        model_clear(model);
+    }
+}
+
+/* - - - DIFFERENTIAL - - -*/
+
+/*
+ * Compare the inventory with the model after a request
+ *
+ * @param fuzz_run_t* run - the run (the request's rows are in 'engine')
+ *
+ * @return int - 1: the same, 0: they differ
+ */
+static int check_state(fuzz_run_t* run) {
+
+    model_t* model = &(run -> model);
+    rows_t* expected = &(run -> expected);
+    char id[ID_MAX + 1];
+    int i, site;
+
+    //the parts needed and the shortages the request reported
+    expected -> row_count = 0;
+    for(i = 0; i < MODEL_PARTS; i++) {
+        item_id(i, id);
+        if(model -> needed[i] > 0) {
+            add_row(expected, RECORD_PART, id, model -> needed[i], 0);
+        }
+        if(model -> short_by[i] > 0) {
+            add_row(expected, RECORD_SHORTAGE, id, model -> short_by[i], 0);
+        }
+    }
+    //a listing reports rows of its own, which are not compared
+    int j = 0;
+    for(i = 0; i < run -> engine.row_count; i++) {
+        int type = run -> engine.row_array[i].type;
+        if(type == RECORD_PART || type == RECORD_SHORTAGE) {
+            run -> engine.row_array[j++] = run -> engine.row_array[i];
+        }
+    }
+    run -> engine.row_count = j;
+    if(!same_rows(run, "parts needed")) {
+        return 0;
+    }
+
+    //on hand at the main site
+    expected -> row_count = 0;
+    run -> engine.row_count = 0;
+    for(i = 0; i < MODEL_ASSEMBLIES; i++) {
+        model_assembly_t* a = &(model -> assemblies[i]);
+        if(a -> exists) {
+            item_id(MODEL_PARTS + i, id);
+            add_row(expected, RECORD_ASSEMBLY, id, a -> capacity,
+            a -> on_hand[0]);
+        }
+    }
+    inventory_request(run -> invp, NULL);
+    if(!same_rows(run, "assemblies on hand")) {
+        return 0;
+    }
+
+    //on hand over every site (the capacity depends on the sites named
+    //since the last clear, so only the amounts are compared)
+    for(i = 0; i < expected -> row_count; i++) {
+        int assembly = atoi(expected -> row_array[i].id + 1);
+        long long total = 0;
+        for(site = 0; site < MODEL_SITES; site++) {
+            total += model -> assemblies[assembly].on_hand[site];
+        }
+        expected -> row_array[i].a = 0;
+        expected -> row_array[i].b = total;
+    }
+    run -> engine.row_count = 0;
+    all_sites_request(run -> invp);
+    for(i = 0; i < run -> engine.row_count; i++) {
+        run -> engine.row_array[i].a = 0;
+    }
+    if(!same_rows(run, "assemblies on hand at all sites")) {
+        return 0;
+    }
+
+    //the parts list
+    expected -> row_count = 0;
+    run -> engine.row_count = 0;
+    for(i = 0; i < MODEL_PARTS; i++) {
+        if(model -> parts[i]) {
+            item_id(i, id);
+            add_row(expected, RECORD_PART_ID, id, 0, 0);
+        }
+    }
+    print_parts(run -> invp);
+    if(!same_rows(run, "parts lists")) {
+        return 0;
+    }
+
+    //the parts whose IDs start with a prefix, taking turns: each part's
+    //ID, and then "P", which every part's starts with
+    int prefix = run -> log_count % (MODEL_PARTS + 1);
+    expected -> row_count = 0;
+    run -> engine.row_count = 0;
+    for(i = 0; i < MODEL_PARTS; i++) {
+        if(model -> parts[i] && (prefix == MODEL_PARTS || i == prefix)) {
+            item_id(i, id);
+            add_row(expected, RECORD_PART_ID, id, 0, 0);
+        }
+    }
+    if(prefix < MODEL_PARTS) {
+        item_id(prefix, id);
+    }
+    else {
+        strcpy(id, "P");
+    }
+    parts_request(run -> invp, id);
+    return same_rows(run, "parts lists by prefix");
+}
+
+/*
+ * Print the listings (inventory, inventory --all-sites and parts) of an
+ * inventory, or of a snapshot of one, to memory
+ *
+ * @param inventory_t* invp - the inventory, NULL to list the snapshot
+ * @param snapshot_t* snapshot - the snapshot
+ * @param size_t* length - set to the length of what was printed
+ *
+ * @return char* - what was printed (to be freed)
+ */
+static char* print_listings(inventory_t* invp, snapshot_t* snapshot,
+                            size_t* length) {
+
+    static char* listings[] = { "inventory", "inventory --all-sites",
+    "parts" };
+    char* text = NULL;
+    FILE* out = open_memstream(&text, length);
+    char line[MAX_LENGTH];
+    char* request_array[MAX_LENGTH];
+
+    if(invp != NULL) {
+        set_output(invp, out, out);
+    }
+    unsigned int i;
+    for(i = 0; i < sizeof(listings) / sizeof(listings[0]); i++) {
+        strcpy(line, listings[i]);
+        int size = tokenize(line, request_array);
+        if(invp != NULL) {
+            process_request(invp, request_array, size);
+        }
+        else {
+            snapshot_request(snapshot, out, out, request_array, size);
+        }
+    }
+    if(invp != NULL) {
+        set_output(invp, sink, sink);
+    }
+    fclose(out);
+    return text;
+}
+
+/*
+ * Take a snapshot of a run's inventory, and keep what the inventory lists
+ * as it is taken
+ *
+ * @param fuzz_run_t* run - the run
+ */
+static void hold_snapshot(fuzz_run_t* run) {
+
+    run -> listed = print_listings(run -> invp, NULL,
+    &(run -> listed_length));
+    run -> snapshot = take_snapshot(run -> invp);
+    run -> snapshot_age = 0;
+}
+
+/*
+ * Compare what a run's snapshot lists with what the inventory listed when
+ * it was taken, and release it
+ *
+ * @param fuzz_run_t* run - the run (holding a snapshot)
+ *
+ * @return int - 1: the same, 0: they differ (printed to stderr)
+ */
+static int check_snapshot(fuzz_run_t* run) {
+
+    size_t length;
+    char* text = print_listings(NULL, run -> snapshot, &length);
+    int same = (length == run -> listed_length
+                && memcmp(text, run -> listed, length) == 0);
+    if(!same) {
+        fprintf(stderr, "snapshot taken %d requests ago lists:\n%s\n"
+        "but when it was taken the inventory listed:\n%s\n",
+        run -> snapshot_age, text, run -> listed);
+    }
+
+    release_snapshot(run -> snapshot);
+    run -> snapshot = NULL;
+    free(run -> listed);
+    free(text);
+    return same;
+}
+
+/*
+ * Determine if a request may change the catalog, which waits until every
+ * snapshot is released: an add, a clear, or a request naming a site (which
+ * may be a new one)
+ *
+ * @param char* array[] - the request
+ * @param int size - the number of tokens
+ *
+ * @return int - 1: it may, 0: it does not
+ */
+static int changes_catalog(char* array[], int size) {
+
+    int code = lookup_command(array[0]);
+    if(code == REQUEST_ADD_PART || code == REQUEST_ADD_ASSEMBLY
+       || code == REQUEST_CLEAR) {
+        return 1;
+    }
+    int i;
+    for(i = 1; i < size; i++) {
+        if(array[i][0] == '@') {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Open the inventory of a differential run, in the store file if there is
+ * one, with its output and rows going where the run looks at them
+ *
+ * @param fuzz_run_t* run - the run
+ */
+static void open_run(fuzz_run_t* run) {
+
+    run -> invp = store_path ? open_inventory(store_path) : new_inventory();
+    if(run -> invp == NULL) {
+        perror(store_path);
+        exit(EXIT_FAILURE);
+    }
+    set_output(run -> invp, sink, sink);
+    set_record(run -> invp, capture, &run -> engine);
+}
+
+/*
+ * Count the assemblies a request restocked (the record function set while
+ * forecast restocks are checked)
+ *
+ * @param void* context - the int the count is kept in
+ * @param int type - the RECORD_ kind of row
+ * @param char* text - the ID of the row
+ * @param long long a - the first number of the row
+ * @param long long b - the second number of the row
+ */
+static void count_restocks(void* context, int type, char* text, long long a,
+                           long long b) {
+
+    (void)text;
+    (void)a;
+    (void)b;
+    if(type == RECORD_RESTOCKED) {
+        (*(int*)context)++;
+    }
+}
+
+/*
+ * Run 'restock --forecast' twice in a row at the end of a run. Building
+ * stock is not demand, so the first may not raise any assembly's velocity,
+ * and the second has nothing left to build.
+ *
+ * @param fuzz_run_t* run - the run
+ *
+ * @return int - 1: the second built nothing, 0: it did (printed to stderr)
+ */
+static int check_forecast(fuzz_run_t* run) {
+
+    char line[MAX_LENGTH];
+    char* request_array[MAX_LENGTH];
+    int restocked = 0;
+    int pass;
+
+    set_record(run -> invp, count_restocks, &restocked);
+    for(pass = 0; pass < 2; pass++) {
+        restocked = 0;
+        strcpy(line, "restock --forecast");
+        process_request(run -> invp, request_array,
+        tokenize(line, request_array));
+    }
+    set_record(run -> invp, capture, &run -> engine);
+
+    if(restocked > 0) {
+        fprintf(stderr, "!!! differential: a second restock --forecast "
+        "restocked %d assemblies\n", restocked);
+        return 0;
+    }
+    return 1;
+}
+
+/*
+ * Run generated requests on an inventory and the model side by side
+ *
+ * @param chooser_t* chooser - where the requests' choices come from
+ * @param int limit - the most requests to run, 0: until the input runs out
+ *
+ * @return int - 1: the inventory matched the model, 0: it did not (the
+ *               requests are printed to stderr)
+ */
+static int run_differential(chooser_t* chooser, int limit) {
+
+    fuzz_run_t run;
+    memset(&run, 0, sizeof(run));
+    run.chooser = *chooser;
+    if(store_path != NULL) {
+        remove(store_path);
+    }
+    open_run(&run);
+    model_clear(&run.model);
+
+    char line[MAX_LENGTH];
+    char* request_array[MAX_LENGTH];
+    int same = 1;
+
+    while(same && (limit > 0 ? run.log_count < limit
+                   : run.chooser.at < run.chooser.size)) {
+
+        generate(&run, line);
+        if(run.log_count == run.log_size) {
+            run.log_size = (run.log_size == 0) ? 64 : run.log_size * 2;
+            run.log = realloc(run.log, run.log_size * sizeof(*run.log));
+        }
+        strcpy(run.log[run.log_count++], line);
+
+        run.engine.row_count = 0;
+        int size = tokenize(line, request_array);
+        //the snapshot has to be let go of before the catalog changes
+        if(run.snapshot != NULL && changes_catalog(request_array, size)) {
+            same = check_snapshot(&run);
+        }
+        process_request(run.invp, request_array, size);
+        //a store is closed and opened again, and has to have kept it all
+        if(store_path != NULL && run.log_count % FUZZ_REOPEN == 0) {
+            if(run.snapshot != NULL) {
+                same = check_snapshot(&run) && same;
+            }
+            free_inventory(run.invp);
+            open_run(&run);
+        }
+        same = check_state(&run) && same;
+
+        if(run.snapshot != NULL) {
+            if(++run.snapshot_age == FUZZ_SNAPSHOT / 2) {
+                same = check_snapshot(&run) && same;
+            }
+        }
+        else if(run.log_count % FUZZ_SNAPSHOT == 0) {
+            hold_snapshot(&run);
+        }
+    }
+    if(run.snapshot != NULL) {
+        same = check_snapshot(&run) && same;
+    }
+    if(same) {
+        same = check_forecast(&run);
+    }
+
+    if(!same) {
+        fprintf(stderr, "requests run:\n");
+        int i;
+        for(i = 0; i < run.log_count; i++) {
+            fprintf(stderr, "%s\n", run.log[i]);
+        }
+    }
+
+    free_inventory(run.invp);
+    free(run.engine.row_array);
+    free(run.expected.row_array);
+    free(run.log);
+    return same;
+}
+
+/*
+ * Run an input as request lines, looking only for crashes
+ *
+ * @param const uint8_t* data - the input
+ * @param size_t size - its length
+ */
+static void run_text(const uint8_t* data, size_t size) {
+
+    char* text = malloc(size + 1);
+    memcpy(text, data, size);
+    text[size] = '\0';
+
+    inventory_t* invp = new_inventory();
+    set_output(invp, sink, sink);
+    char* request_array[MAX_LENGTH];
+    char line[MAX_LENGTH];
+    char* next = text;
+    int request_return = 1;
+
+    while(request_return && next != NULL && *next != '\0') {
+        char* end = strchr(next, '\n');
+        size_t length = (end != NULL) ? (size_t)(end - next) : strlen(next);
+        //longer lines are read in pieces, as getline into a fixed buffer
+        //would not, but tokenize needs the line to fit
+        if(length >= MAX_LENGTH) {
+            length = MAX_LENGTH - 1;
+            end = next + length - 1;
+        }
+        memcpy(line, next, length);
+        line[length] = '\0';
+        next = (end != NULL) ? end + 1 : NULL;
+
+        int i = tokenize(line, request_array);
+        if(i != 0) {
+            request_return = process_request(invp, request_array, i);
+        }
+    }
+
+    free_inventory(invp);
+    free(text);
+}
+
+/*
+ * The fuzz target: run the input as request lines, then as the choices of
+ * a differential run
+ *
+ * @param const uint8_t* data - the input
+ * @param size_t size - its length
+ *
+ * @return int - 0 (a mismatch aborts)
+ */
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+
+    if(sink == NULL) {
+        sink = fopen("/dev/null", "w");
+    }
+    run_text(data, size);
+
+    chooser_t chooser = { data, size, 0, 0 };
+    if(!run_differential(&chooser, 0)) {
+        abort();
+    }
+    return 0;
+}
+
+#ifndef FUZZ_LIBFUZZER
+
+/*
+ * Read a whole file
+ *
+ * @param char* path - the file
+ * @param size_t* size - set to its length
+ *
+ * @return uint8_t* - the contents (to be freed), NULL if it cannot be read
+ */
+static uint8_t* read_file(char* path, size_t* size) {
+
+    FILE* fp = fopen(path, "rb");
+    if(!fp) {
+        perror(path);
+        return NULL;
+    }
+    uint8_t* data = NULL;
+    size_t length = 0;
+    size_t capacity = 0;
+    size_t got;
+    do {
+        if(length == capacity) {
+            capacity = (capacity == 0) ? 4096 : capacity * 2;
+            data = realloc(data, capacity);
+        }
+        got = fread(data + length, 1, capacity - length, fp);
+        length += got;
+    } while(got > 0);
+    fclose(fp);
+    *size = length;
+    return data;
+}
+
+/*
+ * Run the files given as fuzz inputs, or seeded random request sequences
+ * through the differential
+ *
+ * @param int argc - the amount of arguments given
+ * @param char* argv[] - the arguments given
+ *
+ * @return int - EXIT_SUCCESS: no mismatch, EXIT_FAILURE: a mismatch, or a
+ *               file could not be read
+ */
+int main(int argc, char* argv[]) {
+
+    unsigned long long seed = 1;
+    long runs = FUZZ_RUNS;
+    int requests = FUZZ_REQUESTS;
+    int arg = 1;
+
+    while(arg + 1 < argc && argv[arg][0] == '-') {
+        if(strcmp(argv[arg], "-s") == 0) {
+            seed = strtoull(argv[arg + 1], NULL, 10);
+        }
+        else if(strcmp(argv[arg], "-r") == 0) {
+            runs = atol(argv[arg + 1]);
+        }
+        else if(strcmp(argv[arg], "-n") == 0) {
+            requests = atoi(argv[arg + 1]);
+        }
+        else if(strcmp(argv[arg], "-m") == 0) {
+            store_path = argv[arg + 1];
+        }
+        else {
+            break;
+        }
+        arg += 2;
+    }
+    if(arg < argc && argv[arg][0] == '-') {
+        fprintf(stderr,
+        "Useage: ./fuzz [-s seed] [-r runs] [-n requests] [-m store]"
+        " [file ...]\n");
+        return EXIT_FAILURE;
+    }
+
+    sink = fopen("/dev/null", "w");
+    int status = EXIT_SUCCESS;
+
+    //files are fuzz inputs, such as a libFuzzer corpus or crash
+    if(arg < argc) {
+        for(; arg < argc && status == EXIT_SUCCESS; arg++) {
+            size_t size;
+            uint8_t* data = read_file(argv[arg], &size);
+            if(data == NULL) {
+                status = EXIT_FAILURE;
+            }
+            else {
+                LLVMFuzzerTestOneInput(data, size);
+                free(data);
+            }
+        }
+        fclose(sink);
+        return status;
+    }
+
+    long run;
+    for(run = 0; run < runs && status == EXIT_SUCCESS; run++) {
+        //each run has a seed of its own, so a failure can be rerun alone
+        chooser_t chooser = { NULL, 0, 0, 0 };
+        chooser.state = (seed + run) * 0x9e3779b97f4a7c15ULL | 1;
+        if(!run_differential(&chooser, requests > 0 ? requests : 1)) {
+            fprintf(stderr, "mismatch in run %ld (./fuzz -s %llu -r 1 -n %d)\n",
+            run, seed + run, requests);
+            status = EXIT_FAILURE;
+        }
+    }
+    if(status == EXIT_SUCCESS) {
+        printf("fuzz: %ld runs of %d requests matched the model\n", runs,
+        requests);
+    }
+
+    fclose(sink);
+    return status;
+}
+
+#endif // FUZZ_LIBFUZZER
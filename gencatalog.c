@@ -0,0 +1,364 @@
+/*
+ * File: gencatalog.c
+ *
+ * Description: Generates a synthetic request file for benchmarking: a
+ *              catalog of parts and assemblies, followed by a stream of
+ *              orders and other requests. Assemblies are built in levels,
+ *              so every assembly above the first level uses at least one
+ *              assembly from the level below it. Orders pick assemblies
+ *              with Zipf-distributed popularity, so a few are ordered often
+ *              and most rarely.
+ *
+ *              Useage: ./gencatalog [-p parts] [-a assemblies] [-w width]
+ *                                   [-d depth] [-s sharing] [-o orders]
+ *                                   [-z zipf] [-r seed] [-v variants]
+ *
+ *              -p  number of parts (default 1000)
+ *              -a  number of assemblies (default 500)
+ *              -w  items each assembly is made from (default 5)
+ *              -d  levels of assemblies (default 4)
+ *              -s  chance, from 0 to 1, that an item is one of the few
+ *                  common items every level draws from (default 0.3)
+ *              -o  number of requests after the catalog (default 20000)
+ *              -z  Zipf exponent of assembly popularity (default 1.0)
+ *              -r  random seed (default 1)
+ *              -v  chance, from 0 to 1, that an assembly is a variant of
+ *                  the one before it on its level, made from the same
+ *                  items in the same quantities (default 0)
+ *
+ *              Of the requests after the catalog, about 90% are
+ *              fulfillOrder, 5% stock and 4% restock of one assembly, and
+ *              the rest are split between restock, inventory and parts.
+ *
+ * @author: Frank Abbey (fra1489)
+ * @version: 10/19/2026
+ */
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+//generator settings, as given on the command line
+struct settings {
+    int parts;
+    int assemblies;
+    int width;
+    int depth;
+    double sharing;
+    long orders;
+    double zipf;
+    unsigned long seed;
+    double variants;
+};
+
+typedef struct settings settings_t;
+
+//state of the random number generator
+static unsigned long long state;
+
+/*
+ * Next random number (xorshift64*, so a seed gives the same file anywhere)
+ *
+ * @return unsigned long long - the number
+ */
+static unsigned long long next_random(void) {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 2685821657736338717ULL;
+}
+
+/*
+ * Random number in a range
+ *
+ * @param long low - the lowest number
+ * @param long high - the highest number
+ *
+ * @return long - a number from low to high
+ */
+static long random_range(long low, long high) {
+    return low + (long)(next_random() % (unsigned long long)(high - low + 1));
+}
+
+/*
+ * Random number from 0 up to (not including) 1
+ *
+ * @return double - the number
+ */
+static double random_unit(void) {
+    return (next_random() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/*
+ * Write the ID of an item. Items 0 to parts - 1 are parts, the rest are
+ * assemblies.
+ *
+ * @param char* id - filled with the ID
+ * @param int item - the item
+ * @param int parts - the number of parts
+ */
+static void item_id(char* id, int item, int parts) {
+    if(item < parts) {
+        sprintf(id, "P%d", item);
+    }
+    else {
+        sprintf(id, "A%d", item - parts);
+    }
+}
+
+/*
+ * Pick an item for an assembly from the items before it
+ *
+ * @param settings_t* settings - the generator settings
+ * @param int count - the number of items to pick from
+ *
+ * @return int - the item
+ */
+static int pick_item(settings_t* settings, int count) {
+
+    //the common items are the first 1% of the parts
+    int common = settings -> parts / 100;
+    if(common < 1) {
+        common = 1;
+    }
+    if(random_unit() < settings -> sharing) {
+        return random_range(0, common - 1);
+    }
+    return random_range(0, count - 1);
+}
+
+/*
+ * Write the addPart and addAssembly requests of the catalog
+ *
+ * @param settings_t* settings - the generator settings
+ */
+static void write_catalog(settings_t* settings) {
+
+    char id[32];
+    int* items = malloc(settings -> width * sizeof(int));
+    long* quantities = malloc(settings -> width * sizeof(long));
+    int width = 0;
+    int i;
+
+    for(i = 0; i < settings -> parts; i++) {
+        item_id(id, i, settings -> parts);
+        printf("addPart %s\n", id);
+    }
+
+    //level 0 gets whatever the even split leaves over
+    int per_level = settings -> assemblies / settings -> depth;
+    int level_start = 0;
+    int level_end = settings -> assemblies - per_level
+    * (settings -> depth - 1);
+
+    int level;
+    for(level = 0; level < settings -> depth; level++) {
+
+        int a;
+        for(a = level_start; a < level_end; a++) {
+
+            //a variant keeps the items of the assembly before it
+            //(only drawn for when there are variants, so a seed without
+            //them gives the same catalog it always has)
+            if(a > level_start && settings -> variants > 0
+               && random_unit() < settings -> variants) {
+                item_id(id, settings -> parts + a, settings -> parts);
+                printf("addAssembly %s %ld", id, random_range(5, 50));
+                int j;
+                for(j = 0; j < width; j++) {
+                    item_id(id, items[j], settings -> parts);
+                    printf(" %s %ld", id, quantities[j]);
+                }
+                printf("\n");
+                continue;
+            }
+
+            //level 0 is made from parts, the levels above it can use any
+            //part or lower assembly, and always use the level below
+            int count = settings -> parts + level_start;
+            width = 0;
+            if(level > 0) {
+                items[width++] = settings -> parts
+                + random_range(level_start - per_level, level_start - 1);
+            }
+
+            //an item already picked is not picked twice (small catalogs
+            //may end up with narrower assemblies)
+            int tries = 0;
+            while(width < settings -> width && tries < settings -> width * 8) {
+                int item = pick_item(settings, count);
+                int j = 0;
+                while(j < width && items[j] != item) {
+                    j++;
+                }
+                if(j == width) {
+                    items[width++] = item;
+                }
+                tries++;
+            }
+
+            item_id(id, settings -> parts + a, settings -> parts);
+            printf("addAssembly %s %ld", id, random_range(5, 50));
+            int j;
+            for(j = 0; j < width; j++) {
+                quantities[j] = random_range(1, 5);
+                item_id(id, items[j], settings -> parts);
+                printf(" %s %ld", id, quantities[j]);
+            }
+            printf("\n");
+        }
+
+        level_start = level_end;
+        level_end += per_level;
+    }
+
+    free(items);
+    free(quantities);
+}
+
+/*
+ * Pick an assembly by popularity
+ *
+ * @param double* cumulative - running total of each rank's Zipf weight
+ * @param int* ranked - the assembly at each rank
+ * @param int count - the number of assemblies
+ *
+ * @return int - the assembly
+ */
+static int pick_assembly(double* cumulative, int* ranked, int count) {
+
+    double target = random_unit() * cumulative[count - 1];
+    int low = 0;
+    int high = count - 1;
+    while(low < high) {
+        int middle = (low + high) / 2;
+        if(cumulative[middle] < target) {
+            low = middle + 1;
+        }
+        else {
+            high = middle;
+        }
+    }
+    return ranked[low];
+}
+
+/*
+ * Write the requests that follow the catalog
+ *
+ * @param settings_t* settings - the generator settings
+ */
+static void write_orders(settings_t* settings) {
+
+    int count = settings -> assemblies;
+    double* cumulative = malloc(count * sizeof(double));
+    int* ranked = malloc(count * sizeof(int));
+
+    //popularity does not follow the level an assembly is on
+    int i;
+    for(i = 0; i < count; i++) {
+        ranked[i] = i;
+    }
+    for(i = count - 1; i > 0; i--) {
+        int j = random_range(0, i);
+        int temp = ranked[i];
+        ranked[i] = ranked[j];
+        ranked[j] = temp;
+    }
+    double total = 0;
+    for(i = 0; i < count; i++) {
+        total += 1.0 / pow(i + 1, settings -> zipf);
+        cumulative[i] = total;
+    }
+
+    long r;
+    for(r = 0; r < settings -> orders; r++) {
+
+        double kind = random_unit();
+
+        if(kind < 0.90) {
+            printf("fulfillOrder");
+            int lines = random_range(1, 3);
+            while(lines-- > 0) {
+                printf(" A%d %ld", pick_assembly(cumulative, ranked, count),
+                random_range(1, 5));
+            }
+            printf("\n");
+        }
+        else if(kind < 0.95) {
+            printf("stock A%d %ld\n", pick_assembly(cumulative, ranked, count),
+            random_range(1, 10));
+        }
+        else if(kind < 0.99) {
+            printf("restock A%d\n", pick_assembly(cumulative, ranked, count));
+        }
+        else if(kind < 0.995) {
+            printf("restock\n");
+        }
+        else if(kind < 0.9975) {
+            printf("inventory\n");
+        }
+        else {
+            printf("parts\n");
+        }
+    }
+
+    free(cumulative);
+    free(ranked);
+}
+
+/*
+ * Main function writes a catalog and the requests that follow it to stdout
+ *
+ * @param int argc - the amount of arguments given
+ * @param char* argv[] - the arguments given
+ *
+ * @return int - EXIT_FAILURE: bad arguments
+ *               EXIT_SUCCESS: the request file was written
+ */
+int main(int argc, char* argv[]) {
+
+    settings_t settings = { 1000, 500, 5, 4, 0.3, 20000, 1.0, 1, 0 };
+    int option;
+
+    while((option = getopt(argc, argv, "p:a:w:d:s:o:z:r:v:")) != -1) {
+        switch(option) {
+        case 'p': settings.parts = atoi(optarg); break;
+        case 'a': settings.assemblies = atoi(optarg); break;
+        case 'w': settings.width = atoi(optarg); break;
+        case 'd': settings.depth = atoi(optarg); break;
+        case 's': settings.sharing = atof(optarg); break;
+        case 'o': settings.orders = atol(optarg); break;
+        case 'z': settings.zipf = atof(optarg); break;
+        case 'r': settings.seed = strtoul(optarg, NULL, 10); break;
+        case 'v': settings.variants = atof(optarg); break;
+        default:
+            fprintf(stderr, "Useage: ./gencatalog [-p parts] [-a assemblies]"
+            " [-w width] [-d depth] [-s sharing] [-o orders] [-z zipf]"
+            " [-r seed] [-v variants]\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    if(settings.parts < 1 || settings.width < 1 || settings.depth < 1
+       || settings.assemblies < settings.depth || settings.orders < 0) {
+        fprintf(stderr, "!!! need at least 1 part, width 1, depth 1 and"
+        " as many assemblies as levels\n");
+        return EXIT_FAILURE;
+    }
+
+    //zero is a fixed point of xorshift
+    state = settings.seed * 0x9E3779B97F4A7C15ULL + 1;
+
+    printf("# gencatalog -p %d -a %d -w %d -d %d -s %g -o %ld -z %g -r %lu"
+    " -v %g\n", settings.parts, settings.assemblies, settings.width,
+    settings.depth, settings.sharing, settings.orders, settings.zipf,
+    settings.seed, settings.variants);
+
+    write_catalog(&settings);
+    write_orders(&settings);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,169 @@
+/*
+ * File: ids.h
+ *
+ * Description: Fixed-width ID kernels. Part, assembly and item IDs are
+ *              stored NUL-padded in ID_SIZE aligned bytes, so two IDs are
+ *              the same when all ID_SIZE bytes are, which SSE2 checks with
+ *              one compare, and their order is that of the first byte that
+ *              differs. A run of IDs side by side (see id_find) is searched
+ *              eight at a time, two to a compare with AVX2. Without SSE2
+ *              the same is done eight bytes at a time.
+ *
+ *              The functions are inline, since each is only a few
+ *              instructions and is called once per list node or per sort
+ *              comparison.
+ *
+ * @author: Frank Abbey (fra1489)
+ * @version: 10/19/2026
+ */
+#ifndef IDS_H
+#define IDS_H
+
+#include <string.h>
+#include "libinventory.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+//bytes an ID is stored in: ID_MAX characters, then NULs
+#define ID_SIZE 16
+//IDs stored in a struct start on an ID_SIZE boundary
+#define ID_ALIGNED __attribute__((aligned(ID_SIZE)))
+
+//an ID looked up, padded out the way stored IDs are
+struct id_key {
+    char bytes[ID_SIZE];
+} ID_ALIGNED;
+
+//struct typedef declarations for ease of use
+typedef struct id_key id_key_t;
+
+/*
+ * Pad an ID out to be compared with stored IDs
+ *
+ * @param id_key_t* key - set to the padded ID
+ * @param const char* id - the ID
+ *
+ * @return int - 1: done, 0: the ID is too long to be stored, so it matches
+ *               no stored ID
+ */
+static inline int id_key(id_key_t* key, const char* id) {
+
+    size_t length = strlen(id);
+    if(length > ID_MAX) {
+        return 0;
+    }
+    memset(key -> bytes, 0, ID_SIZE);
+    memcpy(key -> bytes, id, length);
+    return 1;
+}
+
+/*
+ * Determine if two stored (or padded) IDs are the same
+ *
+ * @param const char* id1 - an ID of ID_SIZE bytes
+ * @param const char* id2 - another ID of ID_SIZE bytes
+ *
+ * @return int - 1: the same, 0: not
+ */
+static inline int id_equal(const char* id1, const char* id2) {
+
+#if defined(__SSE2__)
+    __m128i equal = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)id1),
+    _mm_loadu_si128((const __m128i*)id2));
+    return _mm_movemask_epi8(equal) == 0xffff;
+#else
+    unsigned long long words1[2], words2[2];
+    memcpy(words1, id1, ID_SIZE);
+    memcpy(words2, id2, ID_SIZE);
+    return ((words1[0] ^ words2[0]) | (words1[1] ^ words2[1])) == 0;
+#endif
+}
+
+/*
+ * Compare two stored (or padded) IDs. The padding is NUL, so this is the
+ * same order as strcmp.
+ *
+ * @param const char* id1 - an ID of ID_SIZE bytes
+ * @param const char* id2 - another ID of ID_SIZE bytes
+ *
+ * @return int - <0, 0, >0 as id1 is before, the same as, after id2
+ */
+static inline int id_compare(const char* id1, const char* id2) {
+
+#if defined(__SSE2__)
+    __m128i equal = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)id1),
+    _mm_loadu_si128((const __m128i*)id2));
+    int differ = ~_mm_movemask_epi8(equal) & 0xffff;
+    if(differ == 0) {
+        return 0;
+    }
+    //the lowest set bit is the first byte that differs
+    int i = __builtin_ctz(differ);
+    return (unsigned char)id1[i] - (unsigned char)id2[i];
+#else
+    return memcmp(id1, id2, ID_SIZE);
+#endif
+}
+
+/*
+ * Search IDs stored side by side for one, eight at a time
+ *
+ * @param char (*ids)[ID_SIZE] - the IDs
+ * @param int count - the number of IDs
+ * @param const id_key_t* key - the ID searched for
+ *
+ * @return int - the index of the ID, -1 if it is not there
+ */
+static inline int id_find(char (*ids)[ID_SIZE], int count,
+                          const id_key_t* key) {
+
+    int i = 0;
+#if defined(__AVX2__)
+    //the key in both halves, so one compare checks two IDs
+    __m256i wanted = _mm256_broadcastsi128_si256(
+    _mm_load_si128((const __m128i*)key -> bytes));
+    for(; i + 8 <= count; i += 8) {
+        unsigned int masks[4];
+        int j;
+        for(j = 0; j < 4; j++) {
+            masks[j] = _mm256_movemask_epi8(_mm256_cmpeq_epi8(wanted,
+            _mm256_loadu_si256((const __m256i*)ids[i + 2 * j])));
+        }
+        for(j = 0; j < 4; j++) {
+            if((masks[j] & 0xffff) == 0xffff) {
+                return i + 2 * j;
+            }
+            if((masks[j] >> 16) == 0xffff) {
+                return i + 2 * j + 1;
+            }
+        }
+    }
+#elif defined(__SSE2__)
+    __m128i wanted = _mm_load_si128((const __m128i*)key -> bytes);
+    for(; i + 8 <= count; i += 8) {
+        int masks[8];
+        int j;
+        for(j = 0; j < 8; j++) {
+            masks[j] = _mm_movemask_epi8(_mm_cmpeq_epi8(wanted,
+            _mm_loadu_si128((const __m128i*)ids[i + j])));
+        }
+        for(j = 0; j < 8; j++) {
+            if(masks[j] == 0xffff) {
+                return i + j;
+            }
+        }
+    }
+#endif
+    for(; i < count; i++) {
+        if(id_equal(ids[i], key -> bytes)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+#endif // IDS_H
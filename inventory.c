@@ -4,23 +4,34 @@
  * Description: An inventory system that manages parts and assemblies, which
  *              are created using parts and sub-assemblies. Customer orders 
  *              can be made, and the inventory can be manually updated.
+ *              Everything works on the inventory handle it is given, so
+ *              any number of inventories can be open at once; the command
+ *              line front end is in main.c.
  * 
  * Table of Contents:
  *
  *      Section:           Line:
  *      ------------------ -----
- *      GLOBAL DEFINITIONS    39
- *      VALIDATION            48
- *      STOCK/RESTOCK        144
- *      LOOKUPS              266
- *      ADD FUNCTIONS        347
- *      TO ARRAY             527
- *      COMPARE              614
- *      MAKE/GET             673 
- *      PRINT                779
- *      PROCESS REQUESTS     890
- *      FREES               1204
- *      MAIN                1260
+ *      GLOBAL DEFINITIONS    53
+ *      HANDLES               74
+ *      SITES                168
+ *      STORE                265
+ *      BOM GRAPH            507
+ *      VALIDATION           949
+ *      FORECAST            1068
+ *      STOCK/RESTOCK       1180
+ *      ID FILTERS          1347
+ *      ID DICTIONARIES     1504
+ *      LOOKUPS             1779
+ *      ADD FUNCTIONS       1868
+ *      TO ARRAY            2083
+ *      COMPARE             2166
+ *      MAKE/GET            2203
+ *      PRINT               2632
+ *      PROCESS REQUESTS    2861
+ *      BATCH               3717
+ *      MEMORY              4183
+ *      FREES               4307
  *
  * @author: Frank Abbey (fra1489)
  * @version: 4/23/2020
@@ -30,20 +41,910 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
+#include <errno.h>
 #include "inventory.h"
-#include "trimit.h"
-
-#define MAX_LENGTH 351
+#include "stats.h"
+#include "scan.h"
+#include "store.h"
+#include "snapshot.h"
 
 /* - - - GLOBAL DEFINITIONS - - -*/
 
-// inventory to be shared across the life of the program
-inventory_t* inventory;
+// name of each command by its REQUEST_ code, in the order they are matched
+char* command_names[REQUEST_COUNT] = { "unknown", "addPart", "addAssembly",
+"fulfillOrder", "stock", "restock", "empty", "inventory", "parts", "help",
+"clear", "quit", "quote", "stats", "stockPart", "memstats" };
 //required to free one-time-use items_needed_t* lists
 static void free_items_needed(items_needed_t* items);
+//stock/restock make assemblies through the order functions of MAKE/GET
+static long long* lookup_on_hand(inventory_t* invp, assembly_t* assembly,
+                                 order_t* order);
+static int make_items(inventory_t* invp, assembly_t* assembly, long long n,
+                      order_t* order);
+static void rollback(inventory_t* invp, undo_log_t* log);
+//the catalog's arrays are allocated from the store, if there is one
+static void* grow_array(inventory_t* invp, void* array, size_t old_bytes,
+                        size_t bytes);
+static void release_array(inventory_t* invp, void* array);
 //used to 'clear' inventory 
 void free_inventory(inventory_t* invp);
 
+/* - - - HANDLES - - -*/
+
+/*
+ * Set up a handle with no catalog yet. Its requests print to stdout and
+ * stderr and report no result rows until told otherwise.
+ *
+ * @param store_t* store - the store its catalog is kept in, or NULL
+ *
+ * @return inventory_t* - the handle
+ */
+static inventory_t* new_handle(store_t* store) {
+
+    inventory_t* invp = calloc(1, sizeof(inventory_t));
+    invp -> store = store;
+    invp -> part_list = LIST_END;
+    invp -> part_count = 0;
+    invp -> assembly_list = LIST_END;
+    invp -> assembly_count = 0;
+    invp -> out = stdout;
+    invp -> err = stderr;
+    invp -> record = NULL;
+    invp -> record_context = NULL;
+    return invp;
+}
+
+/*
+ * Give a new inventory the one site requests go to by default, which
+ * every inventory starts with
+ *
+ * @param inventory_t* invp - the inventory
+ */
+static void first_site(inventory_t* invp) {
+
+    invp -> site_names = grow_array(invp, NULL, 0,
+    sizeof(*(invp -> site_names)));
+    memset(invp -> site_names[0], 0, sizeof(*(invp -> site_names)));
+    strcpy(invp -> site_names[0], SITE_DEFAULT);
+    invp -> site_count = 1;
+    invp -> site_size = 1;
+}
+
+/*
+ * Create an empty inventory. Its requests print to stdout and stderr and
+ * report no result rows until told otherwise.
+ *
+ * @return inventory_t* - the new inventory, freed with free_inventory()
+ */
+inventory_t* new_inventory(void) {
+
+    inventory_t* invp = new_handle(NULL);
+    first_site(invp);
+    return invp;
+}
+
+/*
+ * Set the streams an inventory's requests print their output and errors to
+ *
+ * @param inventory_t* invp - the inventory
+ * @param FILE* out - the stream output is printed to
+ * @param FILE* err - the stream errors are printed to
+ */
+void set_output(inventory_t* invp, FILE* out, FILE* err) {
+    invp -> out = out;
+    invp -> err = err;
+}
+
+/*
+ * Set the function an inventory's requests report their result rows to
+ *
+ * @param inventory_t* invp - the inventory
+ * @param record_fn_t record - called with every row, NULL for none
+ * @param void* context - passed back to the function with every row
+ */
+void set_record(inventory_t* invp, record_fn_t record, void* context) {
+    invp -> record = record;
+    invp -> record_context = context;
+}
+
+/*
+ * Report a result row to the inventory's record function, if it has one
+ *
+ * @param inventory_t* invp - the inventory the row comes from
+ * @param int type - the RECORD_ type of the row
+ * @param char* text - the ID or message of the row
+ * @param long long a - the row's first number
+ * @param long long b - the row's second number
+ */
+static void report(inventory_t* invp, int type, char* text, long long a,
+                   long long b) {
+    if(invp -> record != NULL) {
+        invp -> record(invp -> record_context, type, text, a, b);
+    }
+}
+
+/* - - - SITES - - -*/
+
+/*
+ * Make room for more sites: the site names, and the row of 'on_hand'
+ * values of every assembly, double in size
+ *
+ * @param inventory_t* invp - the inventory
+ */
+static void grow_sites(inventory_t* invp) {
+
+    //snapshots read the rows where they are
+    wait_snapshots(invp);
+    int size = invp -> site_size * 2;
+    invp -> site_names = grow_array(invp, invp -> site_names,
+    invp -> site_size * sizeof(*(invp -> site_names)),
+    size * sizeof(*(invp -> site_names)));
+    STATS_COUNT(invp, allocations);
+
+    //the rows get longer, so every row moves
+    size_t bytes = (size_t)invp -> assembly_size * size * sizeof(long long);
+    long long* on_hand = grow_array(invp, NULL, 0, bytes);
+    STATS_COUNT(invp, allocations);
+    memset(on_hand, 0, bytes);
+    int handle;
+    for(handle = 0; handle < invp -> assembly_count; handle++) {
+        memcpy(on_hand + (size_t)handle * size,
+        invp -> on_hand + (size_t)handle * invp -> site_size,
+        invp -> site_size * sizeof(long long));
+    }
+    release_array(invp, invp -> on_hand);
+    invp -> on_hand = on_hand;
+    invp -> site_size = size;
+}
+
+/*
+ * Find the number of a site, adding the site if it is new
+ *
+ * @param inventory_t* invp - the inventory
+ * @param char* name - the name of the site (without the '@')
+ *
+ * @return int - the number of the site, -1 if the name is not valid or
+ *               there is no room for another site
+ */
+int lookup_site(inventory_t* invp, char* name) {
+
+    int site;
+    for(site = 0; site < invp -> site_count; site++) {
+        if(strcmp(invp -> site_names[site], name) == 0) {
+            return site;
+        }
+    }
+
+    if(*name == '\0' || strlen(name) > ID_MAX) {
+        fprintf(invp -> err, "!!! @%s: illegal site name\n", name);
+        return -1;
+    }
+    if(invp -> site_count == SITE_MAX) {
+        fprintf(invp -> err, "!!! @%s: too many sites (at most %d)\n", name,
+        SITE_MAX);
+        return -1;
+    }
+    if(invp -> site_count == invp -> site_size) {
+        grow_sites(invp);
+    }
+    strcpy(invp -> site_names[invp -> site_count], name);
+    return invp -> site_count++;
+}
+
+/*
+ * Add up how many of an assembly are on hand across every site. The
+ * per-site values are side by side, so this is a plain sum over an array
+ * (read one at a time through the snapshot of a view).
+ *
+ * @param inventory_t* invp - the inventory holding the assembly
+ * @param assembly_t* assembly - the assembly
+ *
+ * @return long long - the total on hand
+ */
+static long long total_on_hand(inventory_t* invp, assembly_t* assembly) {
+
+    long long total = 0;
+    int site;
+    if(invp -> snapshot != NULL) {
+        for(site = 0; site < invp -> site_count; site++) {
+            total += snapshot_on_hand(invp -> snapshot, assembly -> handle,
+            site);
+        }
+        return total;
+    }
+
+    const long long* on_hand = ON_HAND(invp, assembly);
+    for(site = 0; site < invp -> site_count; site++) {
+        total += on_hand[site];
+    }
+    return total;
+}
+
+/* - - - STORE - - -*/
+
+//what a store holds has to be laid out the same as this build lays it out
+#define STORE_LAYOUT ((unsigned int)(sizeof(part_t) | sizeof(assembly_t) << 8 \
+                      | (ID_MAX + 1) << 16 | DICT_BLOCK_SHIFT << 20 \
+                      | FILTER_BLOCK_WORDS << 24))
+
+/*
+ * Make an array of the catalog larger, or allocate one given NULL. On the
+ * heap this is realloc(); in a store the array is handed out again at the
+ * end of the file and what it held is copied, since nothing in a store is
+ * ever moved.
+ *
+ * @param inventory_t* invp - the inventory the array belongs to
+ * @param void* array - the array, or NULL
+ * @param size_t old_bytes - the size of the array (0 for NULL)
+ * @param size_t bytes - the size it needs to be
+ *
+ * @return void* - the larger array (anything past 'old_bytes' is not set)
+ */
+static void* grow_array(inventory_t* invp, void* array, size_t old_bytes,
+                        size_t bytes) {
+
+    if(invp -> store == NULL) {
+        return realloc(array, bytes);
+    }
+    void* grown = store_alloc(invp -> store, bytes);
+    if(old_bytes > 0) {
+        memcpy(grown, array, old_bytes);
+    }
+    return grown;
+}
+
+/*
+ * Give back an array of the catalog that is no longer used (in a store it
+ * is left where it is)
+ *
+ * @param inventory_t* invp - the inventory the array belonged to
+ * @param void* array - the array, or NULL
+ */
+static void release_array(inventory_t* invp, void* array) {
+    if(invp -> store == NULL) {
+        free(array);
+    }
+}
+
+/*
+ * Open an inventory whose catalog and stock are kept in a store file,
+ * creating the file if it does not exist. Only the header of the file is
+ * read: the arrays of the inventory are where the file is mapped, and
+ * their pages are read in as they are used, so opening takes about the
+ * same time however many parts and assemblies there are.
+ *
+ * @param const char* path - the store file
+ *
+ * @return inventory_t* - the inventory, freed (and checkpointed one last
+ *                        time) with free_inventory(), or NULL if the file
+ *                        could not be opened (errno says why; EINVAL: it
+ *                        is not a store of this build's layout)
+ */
+inventory_t* open_inventory(const char* path) {
+
+    store_t* store = store_open(path);
+    if(store == NULL) {
+        return NULL;
+    }
+    store_header_t* header = store -> header;
+    if(header -> layout != 0 && header -> layout != STORE_LAYOUT) {
+        store_close(store);
+        errno = EINVAL;
+        return NULL;
+    }
+
+    inventory_t* invp = new_handle(store);
+    //a new store starts out as a new inventory
+    if(header -> layout == 0) {
+        first_site(invp);
+        header -> layout = STORE_LAYOUT;
+        checkpoint_inventory(invp);
+        return invp;
+    }
+
+    invp -> part_count = header -> part_count;
+    invp -> part_size = header -> part_size;
+    invp -> part_list = header -> part_list;
+    invp -> assembly_count = header -> assembly_count;
+    invp -> assembly_size = header -> assembly_size;
+    invp -> assembly_list = header -> assembly_list;
+    invp -> bom_count = header -> bom_count;
+    invp -> bom_size = header -> bom_size;
+    invp -> bom_row_count = header -> bom_row_count;
+    invp -> bom_row_size = header -> bom_row_size;
+    invp -> bom_index_size = header -> bom_index_size;
+    invp -> site_count = header -> site_count;
+    invp -> site_size = header -> site_size;
+    invp -> part_filter.blocks = header -> part_filter_blocks;
+    invp -> part_filter.count = header -> part_filter_count;
+    invp -> assembly_filter.blocks = header -> assembly_filter_blocks;
+    invp -> assembly_filter.count = header -> assembly_filter_count;
+    invp -> part_dict.count = header -> part_dict_count;
+    invp -> part_dict.arrays.size = header -> part_dict_size;
+    invp -> part_dict.byte_count = header -> part_dict_byte_count;
+    invp -> part_dict.arrays.byte_size = header -> part_dict_byte_size;
+    invp -> assembly_dict.count = header -> assembly_dict_count;
+    invp -> assembly_dict.arrays.size = header -> assembly_dict_size;
+    invp -> assembly_dict.byte_count = header -> assembly_dict_byte_count;
+    invp -> assembly_dict.arrays.byte_size = header -> assembly_dict_byte_size;
+    invp -> order_count = header -> order_count;
+
+    invp -> part_table = store_address(store, header -> part_table);
+    invp -> part_stock = store_address(store, header -> part_stock);
+    invp -> part_ids = store_address(store, header -> part_ids);
+    invp -> assembly_table = store_address(store, header -> assembly_table);
+    invp -> assembly_ids = store_address(store, header -> assembly_ids);
+    invp -> on_hand = store_address(store, header -> on_hand);
+    invp -> bom_child = store_address(store, header -> bom_child);
+    invp -> bom_quantity = store_address(store, header -> bom_quantity);
+    invp -> bom_rows = store_address(store, header -> bom_rows);
+    invp -> bom_index = store_address(store, header -> bom_index);
+    invp -> site_names = store_address(store, header -> site_names);
+    invp -> part_filter.words = store_address(store, header -> part_filter);
+    invp -> assembly_filter.words = store_address(store,
+    header -> assembly_filter);
+    invp -> part_dict.arrays.firsts = store_address(store,
+    header -> part_dict_firsts);
+    invp -> part_dict.arrays.offsets = store_address(store,
+    header -> part_dict_offsets);
+    invp -> part_dict.arrays.bytes = store_address(store,
+    header -> part_dict_bytes);
+    invp -> part_dict.arrays.handles = store_address(store,
+    header -> part_dict_handles);
+    invp -> assembly_dict.arrays.firsts = store_address(store,
+    header -> assembly_dict_firsts);
+    invp -> assembly_dict.arrays.offsets = store_address(store,
+    header -> assembly_dict_offsets);
+    invp -> assembly_dict.arrays.bytes = store_address(store,
+    header -> assembly_dict_bytes);
+    invp -> assembly_dict.arrays.handles = store_address(store,
+    header -> assembly_dict_handles);
+    invp -> part_dict.checkpointed = 1;
+    invp -> assembly_dict.checkpointed = 1;
+    invp -> bom_index_checkpointed = 1;
+
+    //what a request works in starts out empty (large zeroed allocations
+    //are pages that are not there until they are used)
+    invp -> part_demand = calloc(invp -> part_size, sizeof(long long));
+    invp -> part_touched = malloc(invp -> part_size * sizeof(int));
+    invp -> demand = calloc(invp -> assembly_size, sizeof(long long));
+    invp -> demand_heap = malloc(invp -> assembly_size * sizeof(int));
+    invp -> shadow_on_hand = malloc(invp -> assembly_size
+    * sizeof(long long));
+    invp -> shadow_stamp = calloc(invp -> assembly_size,
+    sizeof(unsigned int));
+    STATS_ADD(invp, allocations, 6);
+    return invp;
+}
+
+/*
+ * Write every change made to an inventory to its store file: the header
+ * is brought up to date with where the inventory is, and then everything
+ * changed is written out. If the program stops between checkpoints, how
+ * much of what changed since the last one is in the file is not defined.
+ *
+ * @param inventory_t* invp - the inventory
+ *
+ * @return int - 1: the file is up to date (or there is no store),
+ *               0: it could not be written
+ */
+int checkpoint_inventory(inventory_t* invp) {
+
+    store_t* store = invp -> store;
+    if(store == NULL) {
+        return 1;
+    }
+    store_header_t* header = store -> header;
+
+    header -> part_count = invp -> part_count;
+    header -> part_size = invp -> part_size;
+    header -> part_list = invp -> part_list;
+    header -> assembly_count = invp -> assembly_count;
+    header -> assembly_size = invp -> assembly_size;
+    header -> assembly_list = invp -> assembly_list;
+    header -> bom_count = invp -> bom_count;
+    header -> bom_size = invp -> bom_size;
+    header -> bom_row_count = invp -> bom_row_count;
+    header -> bom_row_size = invp -> bom_row_size;
+    header -> bom_index_size = invp -> bom_index_size;
+    header -> site_count = invp -> site_count;
+    header -> site_size = invp -> site_size;
+    header -> part_filter_blocks = invp -> part_filter.blocks;
+    header -> part_filter_count = invp -> part_filter.count;
+    header -> assembly_filter_blocks = invp -> assembly_filter.blocks;
+    header -> assembly_filter_count = invp -> assembly_filter.count;
+    header -> part_dict_count = invp -> part_dict.count;
+    header -> part_dict_size = invp -> part_dict.arrays.size;
+    header -> part_dict_byte_count = invp -> part_dict.byte_count;
+    header -> part_dict_byte_size = invp -> part_dict.arrays.byte_size;
+    header -> assembly_dict_count = invp -> assembly_dict.count;
+    header -> assembly_dict_size = invp -> assembly_dict.arrays.size;
+    header -> assembly_dict_byte_count = invp -> assembly_dict.byte_count;
+    header -> assembly_dict_byte_size = invp -> assembly_dict.arrays.byte_size;
+    header -> order_count = invp -> order_count;
+
+    header -> part_table = store_offset(store, invp -> part_table);
+    header -> part_stock = store_offset(store, invp -> part_stock);
+    header -> part_ids = store_offset(store, invp -> part_ids);
+    header -> assembly_table = store_offset(store, invp -> assembly_table);
+    header -> assembly_ids = store_offset(store, invp -> assembly_ids);
+    header -> on_hand = store_offset(store, invp -> on_hand);
+    header -> bom_child = store_offset(store, invp -> bom_child);
+    header -> bom_quantity = store_offset(store, invp -> bom_quantity);
+    header -> bom_rows = store_offset(store, invp -> bom_rows);
+    header -> bom_index = store_offset(store, invp -> bom_index);
+    header -> site_names = store_offset(store, invp -> site_names);
+    header -> part_filter = store_offset(store, invp -> part_filter.words);
+    header -> assembly_filter = store_offset(store,
+    invp -> assembly_filter.words);
+    header -> part_dict_firsts = store_offset(store,
+    invp -> part_dict.arrays.firsts);
+    header -> part_dict_offsets = store_offset(store,
+    invp -> part_dict.arrays.offsets);
+    header -> part_dict_bytes = store_offset(store,
+    invp -> part_dict.arrays.bytes);
+    header -> part_dict_handles = store_offset(store,
+    invp -> part_dict.arrays.handles);
+    header -> assembly_dict_firsts = store_offset(store,
+    invp -> assembly_dict.arrays.firsts);
+    header -> assembly_dict_offsets = store_offset(store,
+    invp -> assembly_dict.arrays.offsets);
+    header -> assembly_dict_bytes = store_offset(store,
+    invp -> assembly_dict.arrays.bytes);
+    header -> assembly_dict_handles = store_offset(store,
+    invp -> assembly_dict.arrays.handles);
+    invp -> part_dict.checkpointed = 1;
+    invp -> assembly_dict.checkpointed = 1;
+    invp -> bom_index_checkpointed = 1;
+
+    header -> checkpoints++;
+    store -> requests = 0;
+    return store_sync(store);
+}
+
+/* - - - BOM GRAPH - - -*/
+
+/*
+ * Make room for more assemblies: the arrays kept by assembly handle (the
+ * assemblies, their stock, their IDs, and a quote's demand and copies of
+ * 'on_hand') double in size
+ *
+ * @param inventory_t* invp - the inventory
+ */
+static void grow_assemblies(inventory_t* invp) {
+
+    int old_size = invp -> assembly_size;
+    int size = (old_size == 0) ? 8 : old_size * 2;
+    invp -> assembly_table = grow_array(invp, invp -> assembly_table,
+    old_size * sizeof(assembly_t), size * sizeof(assembly_t));
+    invp -> on_hand = grow_array(invp, invp -> on_hand,
+    (size_t)old_size * invp -> site_size * sizeof(long long),
+    (size_t)size * invp -> site_size * sizeof(long long));
+    invp -> demand = realloc(invp -> demand, size * sizeof(long long));
+    invp -> demand_heap = realloc(invp -> demand_heap, size * sizeof(int));
+    invp -> shadow_on_hand = realloc(invp -> shadow_on_hand,
+    size * sizeof(long long));
+    invp -> shadow_stamp = realloc(invp -> shadow_stamp,
+    size * sizeof(unsigned int));
+    invp -> assembly_ids = grow_array(invp, invp -> assembly_ids,
+    old_size * sizeof(*(invp -> assembly_ids)),
+    size * sizeof(*(invp -> assembly_ids)));
+    STATS_ADD(invp, allocations, 7);
+    memset(invp -> demand + old_size, 0, (size - old_size) * sizeof(long long));
+    memset(invp -> shadow_stamp + old_size, 0,
+    (size - old_size) * sizeof(unsigned int));
+    invp -> assembly_size = size;
+}
+
+/*
+ * Hash a row of the BOM graph (32-bit FNV-1a over its children and
+ * quantities)
+ *
+ * @param inventory_t* invp - the inventory
+ * @param int first - the first entry of the row
+ * @param int length - the entries of the row
+ *
+ * @return unsigned int - the hash
+ */
+static unsigned int hash_bom(inventory_t* invp, int first, int length) {
+
+    unsigned int hash = 2166136261U;
+    int entry;
+    for(entry = first; entry < first + length; entry++) {
+        unsigned long long quantity = invp -> bom_quantity[entry];
+        hash = (hash ^ (unsigned int)invp -> bom_child[entry]) * 16777619U;
+        hash = (hash ^ (unsigned int)quantity) * 16777619U;
+        hash = (hash ^ (unsigned int)(quantity >> 32)) * 16777619U;
+    }
+    return hash;
+}
+
+/*
+ * Find the slot of the BOM index holding the row with the same entries as
+ * a run of entries, or the empty slot it would go in
+ *
+ * @param inventory_t* invp - the inventory (with an index)
+ * @param unsigned int hash - the hash of the entries
+ * @param int first - the first of the entries
+ * @param int length - the number of entries
+ *
+ * @return int - the slot
+ */
+static int find_bom_row(inventory_t* invp, unsigned int hash, int first,
+                        int length) {
+
+    int mask = invp -> bom_index_size - 1;
+    int slot = hash & mask;
+    while(invp -> bom_index[slot] != -1) {
+        bom_row_t* row = &(invp -> bom_rows[invp -> bom_index[slot]]);
+        //empty rows match (with nothing in the arrays to compare yet)
+        if(row -> hash == hash && row -> length == length
+           && (length == 0
+               || (memcmp(invp -> bom_child + row -> first,
+                          invp -> bom_child + first,
+                          length * sizeof(int)) == 0
+                   && memcmp(invp -> bom_quantity + row -> first,
+                             invp -> bom_quantity + first,
+                             length * sizeof(long long)) == 0))) {
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+/*
+ * Get the BOM index ready to be changed. In a store, the index the last
+ * checkpoint points at is left as it is, since a store opened after a
+ * crash looks rows up in it: it is copied into the spare index, which
+ * becomes the index, and the two swap again after the next checkpoint.
+ * The spare is not in the header, so a store that is reopened starts a
+ * new one.
+ *
+ * @param inventory_t* invp - the inventory
+ */
+static void own_bom_index(inventory_t* invp) {
+
+    //an empty store has no index yet to keep
+    if(!(invp -> bom_index_checkpointed) || invp -> bom_index_size == 0) {
+        return;
+    }
+    int size = invp -> bom_index_size;
+    if(invp -> bom_spare_size != size) {
+        release_array(invp, invp -> bom_spare);
+        invp -> bom_spare = grow_array(invp, NULL, 0, size * sizeof(int));
+        invp -> bom_spare_size = size;
+        STATS_COUNT(invp, allocations);
+    }
+    memcpy(invp -> bom_spare, invp -> bom_index, size * sizeof(int));
+
+    int* checkpointed = invp -> bom_index;
+    invp -> bom_index = invp -> bom_spare;
+    invp -> bom_spare = checkpointed;
+    invp -> bom_index_checkpointed = 0;
+}
+
+/*
+ * Empty the BOM index, making it larger first if it is to hold more rows
+ * than a 1/BOM_INDEX_LOAD share of its slots, and put the rows back in it
+ *
+ * @param inventory_t* invp - the inventory
+ * @param int rows - the rows the index is to have room for
+ */
+static void refill_bom_index(inventory_t* invp, int rows) {
+
+    //a larger index is a new array, so only one kept in place is copied
+    if(rows * BOM_INDEX_LOAD > invp -> bom_index_size) {
+        int size = (invp -> bom_index_size == 0) ? 64
+        : invp -> bom_index_size;
+        while(rows * BOM_INDEX_LOAD > size) {
+            size *= 2;
+        }
+        release_array(invp, invp -> bom_index);
+        invp -> bom_index = grow_array(invp, NULL, 0, size * sizeof(int));
+        invp -> bom_index_size = size;
+        invp -> bom_index_checkpointed = 0;
+        STATS_COUNT(invp, allocations);
+    }
+    own_bom_index(invp);
+    if(invp -> bom_index_size > 0) {
+        memset(invp -> bom_index, -1, invp -> bom_index_size * sizeof(int));
+    }
+
+    int mask = invp -> bom_index_size - 1;
+    int row;
+    for(row = 0; row < invp -> bom_row_count; row++) {
+        int slot = invp -> bom_rows[row].hash & mask;
+        while(invp -> bom_index[slot] != -1) {
+            slot = (slot + 1) & mask;
+        }
+        invp -> bom_index[slot] = row;
+    }
+}
+
+/*
+ * Add the items of a new assembly to the BOM graph. The entries keep the
+ * order of the list, which is the order the items are taken in when the
+ * assembly is made. They are put after the entries in use, and are only
+ * kept as a new row if no row already has the same entries; otherwise the
+ * assembly shares that row.
+ *
+ * @param inventory_t* invp - the inventory
+ * @param int handle - the handle of the new assembly
+ * @param items_needed_t* items - the items the assembly is made from
+ */
+static void add_bom(inventory_t* invp, int handle, items_needed_t* items) {
+
+    if(invp -> bom_count + items -> item_count > invp -> bom_size) {
+        int old_size = invp -> bom_size;
+        while(invp -> bom_count + items -> item_count > invp -> bom_size) {
+            invp -> bom_size = (invp -> bom_size == 0) ?
+            64 : invp -> bom_size * 2;
+        }
+        invp -> bom_child = grow_array(invp, invp -> bom_child,
+        old_size * sizeof(int), invp -> bom_size * sizeof(int));
+        invp -> bom_quantity = grow_array(invp, invp -> bom_quantity,
+        old_size * sizeof(long long), invp -> bom_size * sizeof(long long));
+        STATS_ADD(invp, allocations, 2);
+    }
+    if(invp -> bom_row_count == invp -> bom_row_size) {
+        int old_size = invp -> bom_row_size;
+        invp -> bom_row_size = (old_size == 0) ? 64 : old_size * 2;
+        invp -> bom_rows = grow_array(invp, invp -> bom_rows,
+        old_size * sizeof(bom_row_t), invp -> bom_row_size * sizeof(bom_row_t));
+        STATS_COUNT(invp, allocations);
+    }
+    if((invp -> bom_row_count + 1) * BOM_INDEX_LOAD > invp -> bom_index_size) {
+        refill_bom_index(invp, invp -> bom_row_count + 1);
+    }
+
+    int first = invp -> bom_count;
+    int length;
+    for(length = 0; length < items -> item_count; length++) {
+        struct item* item = ITEM_AT(items, length);
+        invp -> bom_child[first + length] = (item -> id[0] == 'P') ?
+        item -> handle : BOM_ASSEMBLY(lookup_assembly(invp, item -> id)
+                                      -> handle);
+        invp -> bom_quantity[first + length] = item -> quantity;
+    }
+
+    unsigned int hash = hash_bom(invp, first, length);
+    int slot = find_bom_row(invp, hash, first, length);
+    if(invp -> bom_index[slot] == -1) {
+        bom_row_t* row = &(invp -> bom_rows[invp -> bom_row_count]);
+        row -> hash = hash;
+        row -> first = first;
+        row -> length = length;
+        own_bom_index(invp);
+        invp -> bom_index[slot] = invp -> bom_row_count++;
+        invp -> bom_count += length;
+    }
+    bom_row_t* row = &(invp -> bom_rows[invp -> bom_index[slot]]);
+    invp -> assembly_table[handle].bom_first = row -> first;
+    invp -> assembly_table[handle].bom_length = row -> length;
+}
+
+/*
+ * Find the ID of a child in the BOM graph
+ *
+ * @param inventory_t* invp - the inventory
+ * @param int child - a part handle, or BOM_ASSEMBLY of an assembly handle
+ *
+ * @return char* - the ID of the part or assembly
+ */
+static char* bom_id(inventory_t* invp, int child) {
+    return (child >= 0) ? invp -> part_ids[child]
+    : invp -> assembly_ids[BOM_ASSEMBLY(child)];
+}
+
+/*
+ * Put an item on an items_needed_t list that is known not to list it yet,
+ * making the list's array larger if it is full
+ *
+ * @param inventory_t* invp - the inventory the item is in
+ * @param items_needed_t* items - the list
+ * @param char* id - the ID of the item, ID_SIZE bytes padded the way IDs
+ *                   are stored
+ * @param int handle - the part handle of the item (-1 for an assembly)
+ * @param long long quantity - the quantity needed
+ */
+static void push_needed(inventory_t* invp, items_needed_t* items, char* id,
+                        int handle, long long quantity) {
+
+    if(items -> item_count == items -> item_size) {
+        items -> item_size = (items -> item_size == 0) ? 8
+        : items -> item_size * 2;
+        items -> item_array = realloc(items -> item_array,
+        items -> item_size * sizeof(struct item));
+        STATS_COUNT(invp, allocations);
+    }
+    struct item* item = &(items -> item_array[items -> item_count++]);
+    memcpy(item -> id, id, ID_SIZE);
+    item -> handle = handle;
+    item -> quantity = quantity;
+}
+
+/*
+ * Add an item to an items_needed_t list whose ID is already known to be
+ * in the inventory, adding to its quantity if it is already listed
+ *
+ * @param inventory_t* invp - the inventory the item is in
+ * @param items_needed_t* items - the list
+ * @param char* id - the ID of the item, as it is stored
+ * @param int handle - the part handle of the item (-1 for an assembly)
+ * @param long long quantity - the quantity to add
+ *
+ * @return int - 1: done, 0: the total quantity was too large
+ */
+static int add_needed(inventory_t* invp, items_needed_t* items, char* id,
+                      int handle, long long quantity) {
+
+    struct item* item = lookup_item(invp, items, id);
+    if(item != NULL) {
+        if(__builtin_add_overflow(item -> quantity, quantity,
+           &(item -> quantity))) {
+            fprintf(invp -> err, "!!! %s: quantity too large\n", id);
+            return 0;
+        }
+        return 1;
+    }
+    push_needed(invp, items, id, handle, quantity);
+    return 1;
+}
+
+/*
+ * Build the list of items an assembly is made from out of its BOM row, for
+ * printing (in the same order as the list it was added with)
+ *
+ * @param inventory_t* invp - the inventory holding the assembly
+ * @param assembly_t* assembly - the assembly
+ *
+ * @return items_needed_t* - the list, to be freed with free_items_needed
+ */
+static items_needed_t* bom_items(inventory_t* invp, assembly_t* assembly) {
+
+    struct items_needed* items = calloc(1, sizeof(struct items_needed));
+    STATS_COUNT(invp, allocations);
+    int entry;
+    for(entry = assembly -> bom_first + assembly -> bom_length - 1;
+        entry >= assembly -> bom_first; entry--) {
+        int child = invp -> bom_child[entry];
+        add_needed(invp, items, bom_id(invp, child),
+        (child >= 0) ? child : -1, invp -> bom_quantity[entry]);
+    }
+    return items;
+}
+
+/*
+ * Add to the quantity of a part needed by the walk in progress. The parts
+ * are added up in a vector by part handle, with a list of the handles set,
+ * so each part needed costs one step instead of a search of the parts
+ * list. flush_parts turns the vector into the parts list afterwards.
+ *
+ * @param inventory_t* invp - the inventory holding the part
+ * @param int handle - the handle of the part
+ * @param long long quantity - the quantity needed
+ *
+ * @return int - 1: done, 0: the total quantity was too large
+ */
+static int need_part(inventory_t* invp, int handle, long long quantity) {
+
+    STATS_COUNT(invp, add_item_calls);
+    long long* demand = &(invp -> part_demand[handle]);
+    if(*demand == 0) {
+        invp -> part_touched[invp -> part_touched_count++] = handle;
+    }
+    if(__builtin_add_overflow(*demand, quantity, demand)) {
+        fprintf(invp -> err, "!!! %s: quantity too large\n",
+        invp -> part_ids[handle]);
+        *demand = LLONG_MAX;
+        return 0;
+    }
+    return 1;
+}
+
+/*
+ * Move the parts needed by a walk into a parts list, and clear the vector
+ * for the next walk
+ *
+ * @param inventory_t* invp - the inventory
+ * @param items_needed_t* parts - the parts list
+ * @param int fits - 0: the walk failed, so the parts are only cleared
+ *
+ * @return int - 1: the walk went through and the parts were added,
+ *               0: it failed, or a total quantity was too large
+ */
+static int flush_parts(inventory_t* invp, items_needed_t* parts, int fits) {
+
+    int i;
+    for(i = 0; i < invp -> part_touched_count; i++) {
+        int handle = invp -> part_touched[i];
+        if(fits) {
+            fits = add_needed(invp, parts, invp -> part_ids[handle],
+            handle, invp -> part_demand[handle]);
+        }
+        invp -> part_demand[handle] = 0;
+    }
+    invp -> part_touched_count = 0;
+    return fits;
+}
+
+/*
+ * Queue an assembly to be expanded. The queue is a binary heap of handles,
+ * highest first, so an assembly comes off it after everything made from it.
+ *
+ * @param inventory_t* invp - the inventory holding the assembly
+ * @param int handle - the handle of the assembly (not already queued)
+ */
+static void queue_demand(inventory_t* invp, int handle) {
+
+    int* heap = invp -> demand_heap;
+    int i = invp -> demand_count++;
+    while(i > 0 && heap[(i - 1) / 2] < handle) {
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap[i] = handle;
+}
+
+/*
+ * Add to the demand for an assembly in a quote, queueing the assembly if
+ * it had none
+ *
+ * @param inventory_t* invp - the inventory holding the assembly
+ * @param int handle - the handle of the assembly
+ * @param long long quantity - the units needed (more than 0)
+ *
+ * @return int - 1: done, 0: the total was too large
+ */
+static int add_demand(inventory_t* invp, int handle, long long quantity) {
+
+    long long* demand = &(invp -> demand[handle]);
+    if(*demand == 0) {
+        queue_demand(invp, handle);
+    }
+    if(__builtin_add_overflow(*demand, quantity, demand)) {
+        fprintf(invp -> err, "!!! %s: quantity too large\n",
+        invp -> assembly_ids[handle]);
+        *demand = LLONG_MAX;
+        return 0;
+    }
+    return 1;
+}
+
+/*
+ * Take the highest assembly handle off the queue
+ *
+ * @param inventory_t* invp - the inventory (with at least one queued)
+ *
+ * @return int - the handle
+ */
+static int next_demand(inventory_t* invp) {
+
+    int* heap = invp -> demand_heap;
+    int top = heap[0];
+    int last = heap[--invp -> demand_count];
+    int count = invp -> demand_count;
+
+    int i = 0;
+    while(2 * i + 1 < count) {
+        int child = 2 * i + 1;
+        if(child + 1 < count && heap[child + 1] > heap[child]) {
+            child++;
+        }
+        if(heap[child] < last) {
+            break;
+        }
+        heap[i] = heap[child];
+        i = child;
+    }
+    if(count > 0) {
+        heap[i] = last;
+    }
+    return top;
+}
+
 /* - - - VALIDATION - - -*/
 
 /*
@@ -54,14 +955,14 @@ void free_inventory(inventory_t* invp);
  * 
  * @return int - 1: valid, 0: invalid
  */
-static int valid_part_id(char* id) {
+static int valid_part_id(inventory_t* invp, char* id) {
 
     if(*(id) != 'P') {
-        fprintf(stderr, "!!! %s: part ID must start with 'P'\n", id);
+        fprintf(invp -> err, "!!! %s: part ID must start with 'P'\n", id);
         return 0;
     }
     else if(strlen(id) > ID_MAX) {
-        fprintf(stderr, "!!! %s: part ID too long\n", id);
+        fprintf(invp -> err, "!!! %s: part ID too long\n", id);
         return 0;
     }
     else {
@@ -77,14 +978,14 @@ static int valid_part_id(char* id) {
  * 
  * @return int - 1: valid, 0: invalid
  */
-static int valid_assembly_id(char* id) {
+static int valid_assembly_id(inventory_t* invp, char* id) {
 
     if(*(id) != 'A') {
-        fprintf(stderr, "!!! %s: assembly ID must start with 'A'\n", id);
+        fprintf(invp -> err, "!!! %s: assembly ID must start with 'A'\n", id);
         return 0;
     }   
     else if(strlen(id) > ID_MAX) {
-        fprintf(stderr, "!!! %s: assembly ID too long\n", id);
+        fprintf(invp -> err, "!!! %s: assembly ID too long\n", id);
         return 0;
     }
     else {
@@ -104,12 +1005,12 @@ static int valid_assembly_id(char* id) {
 static int valid_item(inventory_t* invp, char* id) {
 
     if(*(id) == 'P') {
-        if(valid_part_id(id)) {
-            if(lookup_part(invp -> part_list, id) != NULL) {
+        if(valid_part_id(invp, id)) {
+            if(lookup_part(invp, id) != NULL) {
                 return 1;
             }
             else {
-                fprintf(stderr,
+                fprintf(invp -> err,
                 "!!! %s: part/assembly ID is not in the inventory\n", id);
                 return 0;
             }
@@ -119,12 +1020,12 @@ static int valid_item(inventory_t* invp, char* id) {
         }
     }
     else if(*(id) == 'A') {
-        if(valid_assembly_id(id)) {
-            if(lookup_assembly(invp -> assembly_list, id) != NULL) {
+        if(valid_assembly_id(invp, id)) {
+            if(lookup_assembly(invp, id) != NULL) {
                 return 1;
             }
             else {
-                fprintf(stderr,
+                fprintf(invp -> err,
                 "!!! %s: part/assembly ID is not in the inventory\n", id);
                 return 0;
             }
@@ -134,1219 +1035,3374 @@ static int valid_item(inventory_t* invp, char* id) {
         }
     }
     else {
-        fprintf(stderr,
+        fprintf(invp -> err,
         "!!! %s: part/assembly ID is not in the inventory\n", id);
         return 0;
     }
 }
 
-/* - - - STOCK/RESTOCK - - -*/
-
 /*
- * Manufacture a given amount of an assembly
+ * Multiply the quantity of an item by a number of units, as long as the
+ * product fits in 64 bits. Quantities multiply level by level down an
+ * assembly, so one that does not fit is reported rather than wrapped.
  *
- * @param inventory_t* invp - the inventory containing the assembly
- * @param char* id - the ID of the assembly
- * @param items_needed_t* parts - the list of items required to make this 
- *                                assembly
+ * @param inventory_t* invp - the inventory whose error stream is used
+ * @param int child - the item, as a child in the BOM graph
+ * @param long long quantity - the quantity of the item in one unit
+ * @param long long units - the number of units
+ * @param long long* product - set to the product if it fits
+ *
+ * @return int - 1: the product fits, 0: it does not
  */
-static void stock(inventory_t* invp, char* id, int n, items_needed_t* parts) {
-    //determine if the quantity to stock is valid   
-    if(n <= 0) {
-        fprintf(stderr, "!!! %d: illegal quantity for ID %s\n",
-        n, id);
+static int multiply_quantity(inventory_t* invp, int child, long long quantity,
+                             long long units, long long* product) {
+    if(__builtin_mul_overflow(quantity, units, product)) {
+        fprintf(invp -> err, "!!! %s: quantity too large\n",
+        bom_id(invp, child));
+        return 0;
     }
-    else {
-        struct assembly* assembly = lookup_assembly(invp -> assembly_list, id);
-        //the assembly was not found
-        if(assembly == NULL) {
-            fprintf(stderr,
-            "!!! %s: assembly ID is not in the inventory\n",
-            id);
+    return 1;
+}
+
+/* - - - FORECAST - - -*/
+
+/*
+ * The share of an assembly's velocity kept from one order to the next
+ *
+ * @param unsigned long orders - the number of orders passed
+ *
+ * @return double - (1 - FORECAST_ALPHA) to the power of 'orders'
+ */
+static double decay(unsigned long orders) {
+
+    double keep = 1.0 - FORECAST_ALPHA;
+    double factor = 1.0;
+    //square-and-multiply, so a long idle stretch costs no more than a few
+    while(orders > 0 && factor > 0) {
+        if(orders & 1) {
+            factor *= keep;
+        }
+        keep *= keep;
+        orders >>= 1;
+    }
+    return factor;
+}
+
+/*
+ * Bring an assembly's velocity up to the current order, applying the decay
+ * of every order since it was last used in one go
+ *
+ * @param inventory_t* invp - the inventory holding the assembly
+ * @param assembly_t* assembly - the assembly
+ */
+static void age_velocity(inventory_t* invp, assembly_t* assembly) {
+
+    if(assembly -> velocity_order != invp -> order_count) {
+        assembly -> velocity *= decay(invp -> order_count
+        - assembly -> velocity_order);
+        assembly -> velocity_order = invp -> order_count;
+    }
+}
+
+/*
+ * Count units of an assembly used up by an order. An order that can still
+ * be rolled back only holds them as pending until it is committed, and a
+ * quote does not use anything up.
+ *
+ * @param inventory_t* invp - the inventory holding the assembly
+ * @param assembly_t* assembly - the assembly used
+ * @param long long n - the number of units used
+ * @param order_t* order - the state of the order, or NULL
+ */
+static void consume(inventory_t* invp, assembly_t* assembly, long long n,
+                    order_t* order) {
+
+    if(order != NULL && order -> overlay != NULL) {
+        return;
+    }
+    if(order != NULL && order -> log != NULL) {
+        assembly -> pending += n;
+    }
+    else {
+        age_velocity(invp, assembly);
+        assembly -> velocity += FORECAST_ALPHA * n;
+    }
+}
+
+/*
+ * Keep the changes made by an order. The units it held as pending are added
+ * to the velocities of the assemblies it used, if they were used by a
+ * fulfilled order: sub-assemblies used to build stock are not demand, and
+ * counting them would have every forecast restock raise the next one.
+ * Every assembly an order used had its 'on_hand' logged, so only those are
+ * looked at.
+ *
+ * @param inventory_t* invp - the inventory the order was carried out on
+ * @param undo_log_t* log - the changes made by the order
+ * @param int demand - 1: a fulfilled order, 0: a stock or restock request
+ */
+static void commit(inventory_t* invp, undo_log_t* log, int demand) {
+
+    int i;
+    for(i = 0; i < log -> undo_count; i++) {
+        assembly_t* assembly = log -> undo_array[i].assembly;
+        if(assembly -> pending != 0) {
+            if(demand) {
+                age_velocity(invp, assembly);
+                assembly -> velocity += FORECAST_ALPHA * assembly -> pending;
+            }
+            assembly -> pending = 0;
+        }
+    }
+    log -> undo_count = 0;
+}
+
+/*
+ * Find how many units of an assembly a forecast restock builds: enough to
+ * cover FORECAST_ORDERS orders at its current velocity, up to its capacity
+ *
+ * @param inventory_t* invp - the inventory holding the assembly
+ * @param assembly_t* assembly - the assembly
+ *
+ * @return long long - the number of units to build, 0 if it has enough
+ */
+static long long forecast_amount(inventory_t* invp, assembly_t* assembly) {
+
+    age_velocity(invp, assembly);
+    double cover = assembly -> velocity * FORECAST_ORDERS;
+    long long target = (cover >= assembly -> capacity)
+    ? assembly -> capacity : (long long)(cover + 0.5);
+    return (ON_HAND(invp, assembly)[0] < target)
+    ? target - ON_HAND(invp, assembly)[0] : 0;
+}
+
+/* - - - STOCK/RESTOCK - - -*/
+
+/*
+ * Manufacture a given amount of an assembly
+ *
+ * @param inventory_t* invp - the inventory containing the assembly
+ * @param char* id - the ID of the assembly
+ * @param long long n - the amount to stock
+ * @param order_t* order - logs the 'on_hand' values changed
+ *
+ * @return int - 1: done, 0: a quantity needed was too large (the parts
+ *               needed are added up until flush_parts)
+ */
+static int stock(inventory_t* invp, char* id, long long n, order_t* order) {
+    int fits = 1;
+    //determine if the quantity to stock is valid   
+    if(n <= 0) {
+        fprintf(invp -> err, "!!! %lld: illegal quantity for ID %s\n",
+        n, id);
+    }
+    else {
+        struct assembly* assembly = lookup_assembly(invp, id);
+        //the assembly was not found
+        if(assembly == NULL) {
+            fprintf(invp -> err,
+            "!!! %s: assembly ID is not in the inventory\n",
+            id);
         }
         else {
-            int amount_needed = 0;
+            long long amount_needed = 0;
+            long long* on_hand = lookup_on_hand(invp, assembly, order);
             //stocking the assembly by 'n' would exceed the capacity
-            if(assembly -> on_hand + n > assembly -> capacity) {
-                amount_needed = (assembly -> capacity) - (assembly -> on_hand);
-                assembly -> on_hand = assembly -> capacity;
+            if(*on_hand + n > assembly -> capacity) {
+                amount_needed = (assembly -> capacity) - *on_hand;
+                SET_ON_HAND(on_hand, assembly -> capacity);
             }
             //stocking the assembly by 'n' would NOT exceed capacity
             else {
-                assembly -> on_hand += n;
+                SET_ON_HAND(on_hand, *on_hand + n);
                 amount_needed = n;
             }
             //there is at least one unit needing to be made
             if(amount_needed)
-                printf(">>> make %d units of assembly %s\n", amount_needed, id);
+                fprintf(invp -> out, ">>> make %lld units of assembly %s\n",
+                amount_needed, id);
+            if(amount_needed)
+                report(invp, RECORD_MADE, id, amount_needed, 0);
             
             if(amount_needed > 0) {
-                //for every item in this assembly's 'items_needed" list
-                int i, quantity;
-                int num_items = (assembly -> items) -> item_count;
-                struct item* item = (assembly -> items) -> item_list;
-                for(i = 0; i < num_items; i++) {
-
-                    quantity = (item -> quantity) * amount_needed;
-                    //if this item is a part
-                    if(item -> id[0] == 'P') {
-                        add_item(parts, item -> id, quantity);
-                    }
-                    //if this item is an assembly 
-                    if(item -> id[0] == 'A') {
-                        //get needed amount of 'sub' assemblies
-                        get(invp, item -> id, quantity, parts);
-                    }
-
-                    item = item -> next;
-
-                }
+                fits = make_items(invp, assembly, amount_needed, order);
             }
                 
         }
 
     }
 
+    return fits;
 }
 
 /*
  * Manufacture assemblies if they are below the restock threshold 
- * (if the on hand amount is less than half of the capacity). 
+ * (if the on hand amount is less than half of the capacity). A forecast
+ * restock instead builds each assembly up to what its recent velocity
+ * says will be used (see forecast_amount).
  *
  * @param inventory_t* invp - the inventory containing the assembly/assemblies
  * @param char* id - the ID of the assembly. If this value is NULL, restock 
  *                   every item in the inventory 
- * @param items_needed_t* parts - the list of items required for the request
+ * @param int forecast - 1: size builds from velocity, 0: fill to capacity
+ * @param order_t* order - logs the 'on_hand' values changed
+ *
+ * @return int - 1: done, 0: a quantity needed was too large (the parts
+ *               needed are added up until flush_parts)
  */
-static void restock(inventory_t* invp, char* id, items_needed_t* parts) {
+static int restock(inventory_t* invp, char* id, int forecast,
+                   order_t* order) {
     
     struct assembly* assembly;
-    int amount;
+    long long amount;
+    int fits = 1;
 
     //request to restock entire inventory
     if(id == NULL) {
     
-        assembly = invp -> assembly_list;
+        assembly = ASSEMBLY_AT(invp, invp -> assembly_list);
         
-        while(assembly != NULL) {
+        while(assembly != NULL && fits) {
+            amount = forecast ? forecast_amount(invp, assembly) : 0;
             //check if 'on_hand' value meets the threshold 
-            if((assembly -> on_hand) < ((double)(assembly -> capacity) / 2.0)) {
-                amount = assembly -> capacity - assembly -> on_hand;
-                printf(">>> restocking assembly %s with %d items\n",
-                assembly -> id, amount);
-                stock(invp, assembly -> id, amount, parts);
+            if(!forecast && (ON_HAND(invp, assembly)[0])
+               < ((double)(assembly -> capacity) / 2.0)) {
+                amount = assembly -> capacity - ON_HAND(invp, assembly)[0];
             }
-            assembly = assembly -> next;
+            if(amount > 0) {
+                fprintf(invp -> out,
+                ">>> restocking assembly %s with %lld items\n",
+                ASSEMBLY_ID(invp, assembly), amount);
+                report(invp, RECORD_RESTOCKED, ASSEMBLY_ID(invp, assembly),
+                amount, 0);
+                fits = stock(invp, ASSEMBLY_ID(invp, assembly), amount, order);
+            }
+            assembly = ASSEMBLY_AT(invp, assembly -> next);
         }
 
     }
     //request to restock a specific assembly
     else {
-        assembly = lookup_assembly(invp -> assembly_list, id);
+        assembly = lookup_assembly(invp, id);
 
         if(assembly == NULL) {
-            fprintf(stderr,
+            fprintf(invp -> err,
             "!!! %s: assembly ID is not in the inventory\n",
             id);
         }
         else {
-            if((assembly -> on_hand) < ((double)(assembly -> capacity) / 2.0)) {
-                amount = (assembly -> capacity) - (assembly -> on_hand);
-                printf(">>> restocking assembly %s with %d items\n", 
+            amount = forecast ? forecast_amount(invp, assembly) : 0;
+            if(!forecast && (ON_HAND(invp, assembly)[0])
+               < ((double)(assembly -> capacity) / 2.0)) {
+                amount = (assembly -> capacity)
+                - (ON_HAND(invp, assembly)[0]);
+            }
+            if(amount > 0) {
+                fprintf(invp -> out,
+                ">>> restocking assembly %s with %lld items\n",
                 id, amount);
-                stock(invp, id, amount, parts);
+                report(invp, RECORD_RESTOCKED, id, amount, 0);
+                fits = stock(invp, id, amount, order);
             }
         }
     
     }
 
+    return fits;
 }
 
-/* - - - LOOKUPS - - -*/
-
 /*
- * Search for a part in a given part list
- * 
- * @param part_t* pp - the part list to be searched
- * @param char* id - the ID to be searched for 
- * 
- * @return part_t* part - the address of the part if it is found, 
- *                        'NULL' if not found
+ * Take the parts a request needed out of part stock, and list the parts
+ * there was not enough of. Only parts given stock with stockPart are
+ * counted (the rest are made as needed), and each part needed is found by
+ * its handle, so this costs one step per line of the parts needed list.
+ *
+ * @param inventory_t* invp - the inventory holding the part stock
+ * @param items_needed_t* parts - the parts needed by the request
+ * @param int take - 1: take the parts out of stock, 0: only check them
+ * @param items_needed_t* shortages - filled with each part that is short
+ *                                    and how many it is short by
  */
-part_t* lookup_part(part_t* pp, char* id) {
-    
-    struct part* part = pp;
-    
-    while(part != NULL) {
-        //if the matching ID is found
-        if(strncmp(part -> id, id, strlen(id)) == 0
-            && strlen(id) == strlen(part -> id)) {
-            
-            return part;  
+static void take_parts(inventory_t* invp, items_needed_t* parts, int take,
+                       items_needed_t* shortages) {
+
+    int i;
+    for(i = 0; i < parts -> item_count; i++) {
+        struct item* item = ITEM_AT(parts, i);
+        long long* stock = &(invp -> part_stock[item -> handle]);
+        if(*stock != PART_UNTRACKED) {
+            long long short_by = item -> quantity - *stock;
+            if(take) {
+                *stock = (short_by > 0) ? 0 : -short_by;
+            }
+            if(short_by > 0) {
+                push_needed(invp, shortages, item -> id, item -> handle,
+                short_by);
+            }
         }
-        part = part -> next;
     }
+}
 
-    return NULL;
+/* - - - ID FILTERS - - -*/
+
+/*
+ * Hash an ID for the ID filters (64-bit FNV-1a, with the bits mixed so the
+ * high bits, which pick the block, depend on every character)
+ *
+ * @param char* id - the ID
+ *
+ * @return unsigned long long - the hash
+ */
+static unsigned long long hash_id(char* id) {
 
+    unsigned long long hash = 14695981039346656037ULL;
+    for(; *id != '\0'; id++) {
+        hash = (hash ^ (unsigned char)*id) * 1099511628211ULL;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return hash;
 }
 
 /*
- * Search for an assembly in a given assembly list
+ * Find the block of an ID filter a hash falls in
  *
- * @param assembly_t* ap - the assembly list to be searched
- * @param char* id - the ID to be searched for
+ * @param id_filter_t* filter - the filter (with at least one block)
+ * @param unsigned long long hash - the hash of an ID
  *
- * @return assembly_t* part - the address of the assembly if it is found,
- *                            'NULL' if not found
+ * @return unsigned long long* - the first word of the block
  */
-assembly_t* lookup_assembly(assembly_t* ap, char* id) {
-    
-    struct assembly* assembly = ap;
+static unsigned long long* filter_block(id_filter_t* filter,
+                                        unsigned long long hash) {
+    return filter -> words
+    + ((hash >> 32) & (filter -> blocks - 1)) * FILTER_BLOCK_WORDS;
+}
 
-    while(assembly != NULL) {
-        //if the matching ID is found
-        if(strncmp(assembly -> id, id, strlen(id)) == 0 
-            && strlen(id) == strlen(assembly -> id)) {
-            
-            return assembly;  
-        }
-        assembly = assembly -> next;
-    }
+/*
+ * Mix the low half of an ID's hash into the bits that pick its bits in a
+ * filter block. The high half picked the block, so leaving it out keeps
+ * the probes independent of the block; the multiply spreads the 32 bits
+ * over the 54 the probes take.
+ *
+ * @param unsigned long long hash - the hash of an ID
+ *
+ * @return unsigned long long - 9 bits for each of the FILTER_PROBES bits
+ */
+static unsigned long long filter_probes(unsigned long long hash) {
 
-    return NULL;
+    unsigned long long probes = (hash & 0xffffffffULL)
+    * 0x9e3779b97f4a7c15ULL;
+    return probes ^ (probes >> 29);
+}
+
+/*
+ * Set the bits of an ID in an ID filter. Each of the FILTER_PROBES bits is
+ * picked by 9 bits of filter_probes().
+ *
+ * @param id_filter_t* filter - the filter (with at least one block)
+ * @param unsigned long long hash - the hash of the ID
+ */
+static void filter_set(id_filter_t* filter, unsigned long long hash) {
 
+    unsigned long long* block = filter_block(filter, hash);
+    unsigned long long probes = filter_probes(hash);
+    int i;
+    for(i = 0; i < FILTER_PROBES; i++) {
+        int bit = (probes >> (9 * i)) & 511;
+        block[bit / 64] |= 1ULL << (bit % 64);
+    }
 }
 
 /*
- * Search for an item in a given item list
+ * Determine if an ID could be in an ID filter
  *
- * @param item_t* ip - the item list to be searched
- * @param char* id - the ID to be searched for
+ * @param id_filter_t* filter - the filter
+ * @param char* id - the ID
  *
- * @return item_t* item - the address of the item if it is found,
- *                        'NULL' if not found
+ * @return int - 1: it could be, 0: it surely is not
  */
-item_t* lookup_item(item_t* ip, char* id) {
-    
-    struct item* item = ip;
+static int filter_has(id_filter_t* filter, char* id) {
 
-    while(item != NULL) {
-        //if the matching ID is found
-        if(strncmp(item -> id, id, strlen(id)) == 0 &&
-        strlen(id) == strlen(item -> id)) {
-            return item;
+    if(filter -> blocks == 0) {
+        return 0;
+    }
+    unsigned long long hash = hash_id(id);
+    unsigned long long* block = filter_block(filter, hash);
+    unsigned long long probes = filter_probes(hash);
+    int i;
+    for(i = 0; i < FILTER_PROBES; i++) {
+        int bit = (probes >> (9 * i)) & 511;
+        if(!(block[bit / 64] & (1ULL << (bit % 64)))) {
+            return 0;
         }
-        item = item -> next;
     }
-
-    return NULL;
+    return 1;
 }
 
-/* - - - ADD FUNCTIONS - - -*/
-
 /*
- * Add a new part identifier to the part inventory
+ * Rebuild an inventory's part or assembly ID filter from its table by
+ * handle, with room for as many IDs again
  *
- * @param inventory_t* invp - the inventory holding parts
- * @param char* id - the ID of the part to be created and 
- *                   added
+ * @param inventory_t* invp - the inventory
+ * @param id_filter_t* filter - its part filter or its assembly filter
  */
-void add_part(inventory_t* invp, char* id) {
-    //create a new part struct 
-    struct part* new_part = calloc(1, sizeof(struct part));
-    
-    //assign the values in the id array to the given pointer
-    unsigned int i;
-    for(i = 0; i < strlen(id); i++) {
-        (new_part -> id)[i] = *(id + i);
+static void refill_filter(inventory_t* invp, id_filter_t* filter) {
+
+    int parts = (filter == &(invp -> part_filter));
+    int count = parts ? invp -> part_count : invp -> assembly_count;
+
+    int blocks = 0;
+    if(count > 0) {
+        blocks = 1;
+        while(blocks * FILTER_IDS_PER_BLOCK < 2 * count) {
+            blocks *= 2;
+        }
     }
-    
-    //check if part id already exists
-    if(lookup_part(invp -> part_list, id) != NULL) {
-        fprintf(stderr, "!!! Part: duplicate part ID\n");
-        free(new_part);
+    if(blocks != filter -> blocks) {
+        release_array(invp, filter -> words);
+        filter -> words = (blocks > 0) ? grow_array(invp, NULL, 0,
+        (size_t)blocks * FILTER_BLOCK_WORDS * sizeof(unsigned long long))
+        : NULL;
+        filter -> blocks = blocks;
+        STATS_COUNT(invp, allocations);
     }
-    
-    //otherwise, add the part
-    else {
-        //retreive the beginning of the list
-        struct part* current_part = invp -> part_list;
-        //add the part to the end of the parts list
-        if(current_part != NULL) {
-            while(current_part != NULL) {
-
-                //if there is another part after this one in the list
-                if(current_part -> next != NULL)
-                    current_part = current_part -> next;
-                //otherwise, insert the part into the list
-                else { 
-                    current_part -> next = new_part;
-                    current_part = new_part -> next;
-                    invp -> part_count++;
-                }
-        
-            }
-        }
-        //current_part was NULL, meaning the list was empty
-        else {
-            invp -> part_list = new_part;
-            new_part -> next = NULL;
-            invp -> part_count++;
-        }
+    if(blocks > 0) {
+        memset(filter -> words, 0, (size_t)blocks * FILTER_BLOCK_WORDS
+        * sizeof(unsigned long long));
     }
 
+    int handle;
+    for(handle = 0; handle < count; handle++) {
+        filter_set(filter, hash_id(parts ? invp -> part_ids[handle]
+        : invp -> assembly_ids[handle]));
+    }
+    filter -> count = count;
 }
 
 /*
- * Add a new assembly to the inventory
+ * Add the newest part or assembly of an inventory to its ID filter,
+ * rebuilding the filter larger once it holds FILTER_IDS_PER_BLOCK IDs a
+ * block
  *
- * @param inventory_t* invp - the inventory to be added to
- * @param char* id - the ID of the assembly to be created and
- *                   added
- * @param int capacity - the total capacity that is to be set 
- *                       for this assembly
- * @param items_needed_t* items - the items (parts/assemblies) 
- *                                required to create this assembly
+ * @param inventory_t* invp - the inventory
+ * @param id_filter_t* filter - its part filter or its assembly filter
+ * @param char* id - the ID of the part or assembly (already added)
  */
-void add_assembly(inventory_t* invp, char* id, int capacity,
-                  items_needed_t* items) {
+static void filter_add(inventory_t* invp, id_filter_t* filter, char* id) {
 
-        //validity of assembly ID
-        if(!valid_assembly_id(id)) {
-            return;
-        }
-        //negative capacity
-        else if(capacity < 0) {
-            fprintf(stderr, "!!! %d: illegal capacity for ID %s\n", 
-            capacity, id);
-        }
-        //a return value of 'NULL" indicates the assembly is not already in
-        //the inventory
-        else if(lookup_assembly(invp -> assembly_list, id) != NULL) {
-            fprintf(stderr, "!!! %s: duplicate assembly ID\n", id);
-        }
-        //after all error-checks pass, add the assembly
-        else {
-            //create a new assembly struct 
-            struct assembly* new_assembly = calloc(1, sizeof(struct assembly));
+    if(filter -> count >= filter -> blocks * FILTER_IDS_PER_BLOCK) {
+        refill_filter(invp, filter);
+    }
+    else {
+        filter_set(filter, hash_id(id));
+        filter -> count++;
+    }
+}
 
-            //assign the values in the id array to the given pointer
-            unsigned int i;
-            for(i = 0; i < strlen(id); i++) {
-                (new_assembly -> id)[i] = *(id + i);
-            }
-           
-            new_assembly -> capacity = capacity;
-            new_assembly -> on_hand = 0;
-            new_assembly -> items = items;
-            new_assembly -> next = NULL;
+/* - - - ID DICTIONARIES - - -*/
 
-            //add the new assembly to the beginning of the assembly list
-            if(invp -> assembly_list != NULL) {
-                new_assembly -> next = invp -> assembly_list;
-                invp -> assembly_list = new_assembly;
-                invp -> assembly_count++;
-            }
-            //current_assembly was NULL, meaning the list was empty
-            else {
-                invp -> assembly_list = new_assembly;
-                new_assembly -> next = NULL;
-                invp -> assembly_count++;
-            }
+/*
+ * Put a dictionary cursor on the first ID of a block
+ *
+ * @param id_dict_t* dict - the dictionary
+ * @param dict_cursor_t* cursor - the cursor
+ * @param int block - the block
+ */
+static void dict_block(id_dict_t* dict, dict_cursor_t* cursor, int block) {
 
-        }
-    
+    cursor -> at = block << DICT_BLOCK_SHIFT;
+    memcpy(cursor -> id.bytes, dict -> arrays.firsts[block], ID_SIZE);
+    cursor -> next = dict -> arrays.bytes + dict -> arrays.offsets[block];
 }
 
 /*
- * Add an item (part or assembly) to an items_needed_t list
+ * Move a dictionary cursor on to the next ID, decoding it from the one
+ * before it (or from the whole first ID of the next block)
  *
- * @param items_needed_t* items - the list to add the item to
- * @param char* id - the ID of the item
- * @param int quantity - the amount of the item that is/was required
+ * @param id_dict_t* dict - the dictionary
+ * @param dict_cursor_t* cursor - the cursor, not at the end
  */
-void add_item(items_needed_t* items, char* id, int quantity) {
+static void dict_next(id_dict_t* dict, dict_cursor_t* cursor) {
 
-    int valid = 0;
-    //do not add the item if the id is not valid as a part or assembly
-    if(*(id) == 'P') {
-        if(valid_part_id(id)) {
-            if(lookup_part(inventory -> part_list, id) != NULL) {
-                valid = 1;
-            }
-            else {
-                fprintf(stderr, "!!! %s: part/assembly ID is not in the inventory\n",
-                id);    
-            }
-        }
+    cursor -> at++;
+    if(cursor -> at == dict -> count) {
+        return;
     }
-    else if(*(id) == 'A') {
-        if(valid_assembly_id(id)) {
-            if(lookup_assembly(inventory -> assembly_list, id) != NULL) {
-                valid = 1;
-            }
-            else {
-                fprintf(stderr, "!!! %s: part/assembly ID is not in the inventory\n",
-                id);
-            }
-        }
+    if((cursor -> at & (DICT_BLOCK_IDS - 1)) == 0) {
+        dict_block(dict, cursor, cursor -> at >> DICT_BLOCK_SHIFT);
+        return;
     }
+    int prefix = *(cursor -> next) >> 4;
+    int length = *(cursor -> next) & 15;
+    memcpy(cursor -> id.bytes + prefix, cursor -> next + 1, length);
+    memset(cursor -> id.bytes + prefix + length, 0,
+    ID_SIZE - prefix - length);
+    cursor -> next += 1 + length;
+}
 
-    if(valid) {
+/*
+ * Put a dictionary cursor on the first ID that is not before a given one:
+ * a binary search of the blocks' first IDs finds the last block that
+ * starts no later than it, and the block is decoded up to it
+ *
+ * @param inventory_t* invp - the inventory the dictionary belongs to
+ * @param id_dict_t* dict - the dictionary
+ * @param dict_cursor_t* cursor - the cursor (at the end if every ID is
+ *                                before the one given)
+ * @param const char* from - a stored (or padded) ID
+ */
+static void dict_seek(inventory_t* invp, id_dict_t* dict,
+                      dict_cursor_t* cursor, const char* from) {
 
-        //initialize a new item
-        struct item* item = calloc(1, sizeof(struct item));
-    
-        unsigned int i;
-        for(i = 0; i < strlen(id); i++) {
-            item -> id[i] = *(id + i);
-        } 
+    cursor -> at = dict -> count;
+    if(dict -> count == 0) {
+        return;
+    }
 
-        item -> quantity = quantity;
-        item -> next = NULL;
-        
-        struct item* current_item = lookup_item(items -> item_list, id);
-        //increment quantity if the item is alrady in the list 
-        if(current_item != NULL) {
-            current_item -> quantity += quantity;
-            //delete the item that now does not need to be added
-            free(item);
+    int low = 0;
+    int high = (dict -> count - 1) >> DICT_BLOCK_SHIFT;
+    while(low < high) {
+        int middle = (low + high + 1) / 2;
+        STATS_COUNT(invp, lookup_probes);
+        if(id_compare(dict -> arrays.firsts[middle], from) <= 0) {
+            low = middle;
         }
-        //otherwise, add it to the list
         else {
-            item -> next = items -> item_list;
-            items -> item_list = item;
-            items -> item_count++;
+            high = middle - 1;
         }
     }
 
+    dict_block(dict, cursor, low);
+    while(cursor -> at < dict -> count
+          && id_compare(cursor -> id.bytes, from) < 0) {
+        STATS_COUNT(invp, lookup_probes);
+        dict_next(dict, cursor);
+    }
 }
 
-/* - - - TO ARRAY - - -*/
-
 /*
- * Convert a part_t* part list from a linked list to an array
- * 
- * @param int count - the amount of parts in this list
- * @param part_t* part_list - the parts list to be converted
+ * Find the handle of an ID: in a dictionary, and then, several at a time,
+ * among the IDs added since the dictionary was laid out
+ *
+ * @param inventory_t* invp - the inventory
+ * @param id_dict_t* dict - its part dictionary or its assembly dictionary
+ * @param char (*ids)[ID_SIZE] - the IDs the dictionary is of, by handle
+ * @param int count - the number of IDs
+ * @param const id_key_t* key - the ID searched for
  *
- * @return part_t** part_array - the array of parts 
+ * @return int - the handle, -1 if the ID is not there
  */
-part_t** to_part_array(int count, part_t* part_list) {
-    
-    //dynamically allocate an array of void pointers
-    part_t** part_array = calloc(count, sizeof(part_t*));
-    struct part* part = part_list;
-
-    //fill the array with values from the linked list
-    int i;
-    for(i = 0; i < count; i++) {
-        if(part != NULL) {
-            part_array[i] = (void*)part;
-            part = part -> next;
-        }
-
+static int dict_lookup(inventory_t* invp, id_dict_t* dict,
+                       char (*ids)[ID_SIZE], int count,
+                       const id_key_t* key) {
+
+    dict_cursor_t cursor;
+    dict_seek(invp, dict, &cursor, key -> bytes);
+    if(cursor.at < dict -> count && id_equal(cursor.id.bytes, key -> bytes)) {
+        return dict -> arrays.handles[cursor.at];
     }
-    
-    return part_array;
 
+    int handle = id_find(ids + dict -> count, count - dict -> count, key);
+    STATS_ADD(invp, lookup_probes,
+    (handle >= 0) ? handle + 1 : count - dict -> count);
+    return (handle >= 0) ? dict -> count + handle : -1;
 }
 
 /*
- * Convert an assembly_t* assembly list from a linked list 
- * to an array
+ * Sort the IDs added since a dictionary was laid out
  *
- * @param int count - the amount of assemblies in this list
- * @param assembly_t* assembly_list - the assembly list to be converted
+ * @param id_dict_t* dict - the dictionary
+ * @param char (*ids)[ID_SIZE] - the IDs it is of, by handle
+ * @param int count - the number of IDs
  *
- * @return assembly_t** assembly_array - the array of assemblies
+ * @return char** - the IDs added since, pointing into 'ids' (so ID_HANDLE
+ *                  finds their handles), in ID order (to be freed)
  */
-assembly_t** to_assembly_array(int count, assembly_t* assembly_list) {
-
-    //dynamically allocate an array of void pointers
-    assembly_t** assembly_array = calloc(count, sizeof(assembly_t*));
-    struct assembly* assembly = assembly_list;
+static char** dict_tail(id_dict_t* dict, char (*ids)[ID_SIZE], int count) {
 
-    //fill the array with values from the linked list
+    int tail = count - dict -> count;
+    char** added = malloc(((tail > 0) ? tail : 1) * sizeof(char*));
     int i;
-    for(i = 0; i < count; i++) {
-        if(assembly != NULL) {
-            assembly_array[i] = (void*)assembly;
-            assembly = assembly -> next;
-        }
-
+    for(i = 0; i < tail; i++) {
+        added[i] = ids[dict -> count + i];
     }
-
-    return assembly_array;
-
+    qsort(added, tail, sizeof(char*), id_compare_at);
+    return added;
 }
 
 /*
- * Convert an item_t* item list from a linked list to an array
+ * Find the length of the prefix two different stored IDs share
  *
- * @param int count - the amount of items in this list
- * @param item_t* item_list - the item list to be converted
+ * @param const char* id1 - an ID of ID_SIZE bytes
+ * @param const char* id2 - another ID of ID_SIZE bytes
  *
- * @return item_t** item_array - the array of items
+ * @return int - the bytes they have in common before the first that
+ *               differs (less than ID_SIZE, since they are different)
  */
-item_t ** to_item_array(int count, item_t * item_list) {
-    
-    //dynamically allocate an array of void pointers
-    item_t** item_array = calloc(count, sizeof(item_t*));
-    struct item* item = item_list;
+static int shared_prefix(const char* id1, const char* id2) {
 
-    //fill the array with values from the linked list
+    int length = 0;
+    while(id1[length] == id2[length]) {
+        length++;
+    }
+    return length;
+}
+
+/*
+ * Lay a dictionary out again from handles in the order of their IDs. The
+ * arrays it is in are kept unless they are too small, and then double. In
+ * a store, the arrays the last checkpoint points at are left as they are,
+ * since a store opened after a crash goes back to them, so the dictionary
+ * is laid out in its spare arrays instead and the two swap.
+ *
+ * @param inventory_t* invp - the inventory the dictionary belongs to
+ * @param id_dict_t* dict - the dictionary
+ * @param char (*ids)[ID_SIZE] - the IDs, by handle
+ * @param int* sorted - the handles in ID order
+ * @param int count - the number of handles
+ */
+static void lay_out_dict(inventory_t* invp, id_dict_t* dict,
+                         char (*ids)[ID_SIZE], int* sorted, int count) {
+
+    if(dict -> checkpointed) {
+        struct dict_arrays checkpointed = dict -> arrays;
+        dict -> arrays = dict -> spare;
+        dict -> spare = checkpointed;
+        dict -> checkpointed = 0;
+    }
+    struct dict_arrays* arrays = &(dict -> arrays);
+
+    if(count > arrays -> size) {
+        int size = (arrays -> size == 0) ? DICT_BLOCK_IDS : arrays -> size;
+        while(size < count) {
+            size *= 2;
+        }
+        int blocks = size >> DICT_BLOCK_SHIFT;
+        release_array(invp, arrays -> handles);
+        release_array(invp, arrays -> firsts);
+        release_array(invp, arrays -> offsets);
+        arrays -> handles = grow_array(invp, NULL, 0, size * sizeof(int));
+        arrays -> firsts = grow_array(invp, NULL, 0, blocks * ID_SIZE);
+        arrays -> offsets = grow_array(invp, NULL, 0, blocks * sizeof(int));
+        arrays -> size = size;
+        STATS_ADD(invp, allocations, 3);
+    }
+
+    //the IDs after the first of each block take a byte of lengths and the
+    //part of them not shared with the ID before
     int i;
+    int bytes = 0;
+    for(i = 0; i < count; i++) {
+        if((i & (DICT_BLOCK_IDS - 1)) != 0) {
+            char* id = ids[sorted[i]];
+            int prefix = shared_prefix(ids[sorted[i - 1]], id);
+            bytes += 1 + strnlen(id + prefix, ID_SIZE - prefix);
+        }
+    }
+    if(bytes > arrays -> byte_size || arrays -> bytes == NULL) {
+        int size = (arrays -> byte_size == 0) ? DICT_BLOCK_IDS
+        : arrays -> byte_size;
+        while(size < bytes) {
+            size *= 2;
+        }
+        release_array(invp, arrays -> bytes);
+        arrays -> bytes = grow_array(invp, NULL, 0, size);
+        arrays -> byte_size = size;
+        STATS_COUNT(invp, allocations);
+    }
+
+    bytes = 0;
     for(i = 0; i < count; i++) {
-        if(item != NULL) {
-            item_array[i] = (void*)item;
-            item = item -> next;
+        char* id = ids[sorted[i]];
+        arrays -> handles[i] = sorted[i];
+        if((i & (DICT_BLOCK_IDS - 1)) == 0) {
+            memcpy(arrays -> firsts[i >> DICT_BLOCK_SHIFT], id, ID_SIZE);
+            arrays -> offsets[i >> DICT_BLOCK_SHIFT] = bytes;
+        }
+        else {
+            int prefix = shared_prefix(ids[sorted[i - 1]], id);
+            int length = strnlen(id + prefix, ID_SIZE - prefix);
+            arrays -> bytes[bytes] = (unsigned char)(prefix << 4 | length);
+            memcpy(arrays -> bytes + bytes + 1, id + prefix, length);
+            bytes += 1 + length;
         }
+    }
+    dict -> byte_count = bytes;
+    dict -> count = count;
+}
+
+/*
+ * Merge the IDs added since a dictionary was laid out into it, once there
+ * are more of them than DICT_TAIL_MIN, and one more for every
+ * DICT_TAIL_SHARE IDs it holds (so the IDs searched one by one stay few,
+ * and the dictionary is laid out again a few hundred times at most as a
+ * catalog of a million IDs is loaded). Only done as the catalog changes,
+ * when there are no snapshots.
+ *
+ * @param inventory_t* invp - the inventory
+ * @param id_dict_t* dict - its part dictionary or its assembly dictionary
+ * @param char (*ids)[ID_SIZE] - the IDs the dictionary is of, by handle
+ * @param int count - the number of IDs
+ */
+static void update_dict(inventory_t* invp, id_dict_t* dict,
+                        char (*ids)[ID_SIZE], int count) {
 
+    int tail = count - dict -> count;
+    if(tail <= DICT_TAIL_MIN + dict -> count / DICT_TAIL_SHARE) {
+        return;
     }
 
-    return item_array;
+    //both runs are in ID order, so they merge in one pass
+    char** added = dict_tail(dict, ids, count);
+    int* sorted = malloc(count * sizeof(int));
+    STATS_ADD(invp, allocations, 2);
+    int i = 0;
+    int j = 0;
+    int k = 0;
+    while(k < count) {
+        if(j == tail || (i < dict -> count
+           && id_compare(ids[dict -> arrays.handles[i]], added[j]) < 0)) {
+            sorted[k++] = dict -> arrays.handles[i++];
+        }
+        else {
+            sorted[k++] = ID_HANDLE(ids, added[j++]);
+        }
+    }
+    lay_out_dict(invp, dict, ids, sorted, count);
 
+    free(added);
+    free(sorted);
 }
 
-/* - - - COMPARE - - -*/
+/* - - - LOOKUPS - - -*/
 
 /*
- * Compare two parts based on their IDs
+ * Search for a part in an inventory's part list
  * 
- * @param const void* p1 - a void pointer representing a part
- * @param const void* p2 - a void pointer representing a part
+ * @param inventory_t* invp - the inventory to be searched
+ * @param char* id - the ID to be searched for 
  * 
- * @return int - 0: the IDs are equal
- *              <0: p1's ID is less than p2's ID
- *              >0: p2's ID is less than p1's ID   
+ * @return part_t* part - the address of the part if it is found, 
+ *                        'NULL' if not found
  */
-int part_compare(const void* p1, const void* p2) {
+part_t* lookup_part(inventory_t* invp, char* id) {
     
-    const struct part* part1 = *(part_t**)p1;
-    const struct part* part2 = *(part_t**)p2;
+    STATS_COUNT(invp, lookups);
+
+    //most IDs that are not in the inventory stop here
+    if(!filter_has(&(invp -> part_filter), id)) {
+        STATS_COUNT(invp, filter_rejects);
+        return NULL;
+    }
+
+    //the rest are searched for in the dictionary
+    id_key_t key;
+    int handle = id_key(&key, id) ? dict_lookup(invp, &(invp -> part_dict),
+    invp -> part_ids, invp -> part_count, &key) : -1;
+
+    return (handle >= 0) ? &(invp -> part_table[handle]) : NULL;
 
-    return strncmp(part1 -> id, part2 -> id, strlen(part1 -> id));
-    
 }
 
 /*
- * Compare two assemblies based on their IDs
+ * Search for an assembly in an inventory's assembly list
  *
- * @param const void* a1 - a void pointer representing an assembly
- * @param const void* a2 - a void pointer representing an assembly
+ * @param inventory_t* invp - the inventory to be searched
+ * @param char* id - the ID to be searched for
  *
- * @return int - 0: the IDs are equal
- *              <0: a1's ID is less than a2's ID
- *              >0: a2's ID is less than a1's ID
+ * @return assembly_t* part - the address of the assembly if it is found,
+ *                            'NULL' if not found
  */
-int assembly_compare(const void* a1, const void* a2) {
+assembly_t* lookup_assembly(inventory_t* invp, char* id) {
+    
+    STATS_COUNT(invp, lookups);
+
+    if(!filter_has(&(invp -> assembly_filter), id)) {
+        STATS_COUNT(invp, filter_rejects);
+        return NULL;
+    }
 
-    const struct assembly* assembly1 = *(assembly_t**)a1;
-    const struct assembly* assembly2 = *(assembly_t**)a2;
+    id_key_t key;
+    int handle = id_key(&key, id) ? dict_lookup(invp,
+    &(invp -> assembly_dict), invp -> assembly_ids, invp -> assembly_count,
+    &key) : -1;
 
-    return strncmp(assembly1 -> id, assembly2 -> id, strlen(assembly1 -> id));
+    return (handle >= 0) ? &(invp -> assembly_table[handle]) : NULL;
 
 }
 
 /*
- * Compare two items based on their IDs
+ * Search for an item in a given item list
  *
- * @param const void* i1 - a void pointer representing an item
- * @param const void* i2 - a void pointer representing an item
+ * @param inventory_t* invp - the inventory the list belongs to
+ * @param items_needed_t* items - the item list to be searched
+ * @param char* id - the ID to be searched for
  *
- * @return int - 0: the IDs are equal
- *              <0: i1's ID is less than i2's ID
- *              >0: i2's ID is less than i1's ID
+ * @return item_t* item - the address of the item if it is found (until
+ *                        the next item is added), 'NULL' if not found
  */
-int item_compare(const void* i1, const void* i2) {
-
-    const struct item* item1 = *(item_t**)i1;
-    const struct item* item2 = *(item_t**)i2;
+item_t* lookup_item(inventory_t* invp, items_needed_t* items, char* id) {
+    
+    STATS_COUNT(invp, lookups);
 
-    return strncmp(item1 -> id, item2 -> id, strlen(item1 -> id));
+    //the ID is padded once, then each item is one compare
+    id_key_t key;
+    if(!id_key(&key, id)) {
+        return NULL;
+    }
+    int i;
+    for(i = 0; i < items -> item_count; i++) {
+        STATS_COUNT(invp, lookup_probes);
+        struct item* item = ITEM_AT(items, i);
+        //if the matching ID is found
+        if(id_equal(item -> id, key.bytes)) {
+            return item;
+        }
+    }
 
+    return NULL;
 }
 
-/* - - - MAKE/GET - - -*/
+/* - - - ADD FUNCTIONS - - -*/
 
 /*
- * Make a given amount of assemblies from an inventory
+ * Add a new part identifier to the part inventory
  *
- * @param inventory_t* invp - the inventory holding the assemblies
- * @param char* id - the ID of the assembly to be made
- * @param int n - the number of assemblies needed
- * @param items_needed* parts - the parts/sub-assemblies required to 
- *                              create this assembly
+ * @param inventory_t* invp - the inventory holding parts
+ * @param char* id - the ID of the part to be created and 
+ *                   added
  */
-void make(inventory_t* invp, char* id, int n, items_needed_t* parts) {
-    //check for valid amount 
-    if(n <= 0) {
-        fprintf(stderr, 
-        "!!! %d: illegal order quantity for ID %s -- order canceled\n", n, id);
+void add_part(inventory_t* invp, char* id) {
+    //the catalog stays as it is while there are snapshots
+    wait_snapshots(invp);
+    //create a new part struct 
+    struct part new_part;
+    memset(&new_part, 0, sizeof(new_part));
+    
+    //pad the ID out the way it is stored
+    char padded[ID_SIZE];
+    memset(padded, 0, ID_SIZE);
+    unsigned int i;
+    for(i = 0; i < strlen(id); i++) {
+        padded[i] = *(id + i);
+    }
+    
+    //check if part id already exists
+    if(lookup_part(invp, id) != NULL) {
+        fprintf(invp -> err, "!!! Part: duplicate part ID\n");
     }
+    
+    //otherwise, add the part
     else {
-        struct assembly* assembly = lookup_assembly(invp -> assembly_list, id);
-        //assembly was not found
-        if(assembly == NULL) {
-            fprintf(stderr,
-            "!!! %s: assembly ID is not in the inventory -- order canceled\n",
-            id);
+        //its stock is the next slot of the dense part stock array
+        new_part.handle = invp -> part_count;
+        new_part.next = LIST_END;
+        if(invp -> part_count == invp -> part_size) {
+            int old_size = invp -> part_size;
+            invp -> part_size = (old_size == 0) ? 8 : old_size * 2;
+            invp -> part_stock = grow_array(invp, invp -> part_stock,
+            old_size * sizeof(long long),
+            invp -> part_size * sizeof(long long));
+            invp -> part_table = grow_array(invp, invp -> part_table,
+            old_size * sizeof(part_t), invp -> part_size * sizeof(part_t));
+            invp -> part_demand = realloc(invp -> part_demand,
+            invp -> part_size * sizeof(long long));
+            invp -> part_touched = realloc(invp -> part_touched,
+            invp -> part_size * sizeof(int));
+            invp -> part_ids = grow_array(invp, invp -> part_ids,
+            old_size * sizeof(*(invp -> part_ids)),
+            invp -> part_size * sizeof(*(invp -> part_ids)));
+            STATS_ADD(invp, allocations, 5);
+        }
+        invp -> part_stock[new_part.handle] = PART_UNTRACKED;
+        invp -> part_table[new_part.handle] = new_part;
+        memcpy(invp -> part_ids[new_part.handle], padded, ID_SIZE);
+        invp -> part_demand[new_part.handle] = 0;
+
+        //add the part to the end of the parts list, where the part added
+        //before it is
+        if(invp -> part_list != LIST_END) {
+            invp -> part_table[new_part.handle - 1].next = new_part.handle;
         }
+        //the list was empty
         else {
-            
-            int amount_to_make = 0;
-            if(n >= assembly -> on_hand) {
-                amount_to_make = n - (assembly -> on_hand);
-                printf(">>> make %d units of assembly %s\n", amount_to_make, id);
-                assembly -> on_hand = 0;
-            }
-            else {
-                assembly -> on_hand = assembly -> on_hand - n;   
-            }
-            if(amount_to_make > 0) { 
-                //for every item in this assembly's 'items_needed" list
-                int i, quantity;
-                int num_items = (assembly -> items) -> item_count;
-                struct item* item = (assembly -> items) -> item_list;
-                for(i = 0; i < num_items; i++) {
-
-                    quantity = (item -> quantity) * amount_to_make;
-                    //if this item is a part
-                    if(item -> id[0] == 'P') {
-                        add_item(parts, item -> id, quantity);
-                    }
-                    //if this item is an assembly 
-                    if(item -> id[0] == 'A') {
-                        //get needed amount of 'sub' assemblies
-                        get(invp, item -> id, quantity, parts); 
-                    }
-                
-                    item = item -> next;
-
-                }
-            }
-            
+            invp -> part_list = new_part.handle;
         }
-
+        invp -> part_count++;
+        filter_add(invp, &(invp -> part_filter), id);
+        update_dict(invp, &(invp -> part_dict), invp -> part_ids,
+        invp -> part_count);
     }
 
 }
 
 /*
- * Determine if there is enough of a given amount of assemblies 
- * from an inventory
+ * Add a new assembly to the inventory
  *
- * @param inventory_t* invp - the inventory holding the assembly
- * @param char* id - the ID of the assembly to be made
- * @param int n - the number of assemblies needed
- * @param items_needed* parts - the parts/sub-assemblies required to 
- *                              create this assembly
+ * @param inventory_t* invp - the inventory to be added to
+ * @param char* id - the ID of the assembly to be created and
+ *                   added
+ * @param int capacity - the total capacity that is to be set 
+ *                       for this assembly
+ * @param items_needed_t* items - the items (parts/assemblies) 
+ *                                required to create this assembly
+ *                                (deleted once they are in the BOM graph,
+ *                                or if the assembly is not added)
  */
-void get(inventory_t * invp, char * id, int n, items_needed_t * parts) {
-    //check for valid amount
-    if(n <= 0) {
-        fprintf(stderr, "!!! %d: illegal order quantity for ID %s\n",
-        n, id);
-    }
-    else {
-        struct assembly* assembly = lookup_assembly(invp -> assembly_list, id);
-        
-        //assembly was not found
-        if(assembly == NULL) {
-            fprintf(stderr,
-            "!!! %s: assembly ID is not in the inventory -- order canceled\n",
-            id);
+void add_assembly(inventory_t* invp, char* id, int capacity,
+                  items_needed_t* items) {
+
+        //the catalog stays as it is while there are snapshots
+        wait_snapshots(invp);
+
+        //validity of assembly ID
+        if(!valid_assembly_id(invp, id)) {
+            free_items_needed(items);
+            return;
+        }
+        //negative capacity
+        else if(capacity < 0) {
+            fprintf(invp -> err, "!!! %d: illegal capacity for ID %s\n", 
+            capacity, id);
+            free_items_needed(items);
+        }
+        //a return value of 'NULL" indicates the assembly is not already in
+        //the inventory
+        else if(lookup_assembly(invp, id) != NULL) {
+            fprintf(invp -> err, "!!! %s: duplicate assembly ID\n", id);
+            free_items_needed(items);
         }
+        //after all error-checks pass, add the assembly
         else {
-            //check if there are enough of this assembly in stock
-            if(assembly -> on_hand >= n) {
-                (assembly -> on_hand) -= n;
+            //create a new assembly struct 
+            struct assembly new_assembly;
+            memset(&new_assembly, 0, sizeof(new_assembly));
+
+            //pad the ID out the way it is stored
+            char padded[ID_SIZE];
+            memset(padded, 0, ID_SIZE);
+            unsigned int i;
+            for(i = 0; i < strlen(id); i++) {
+                padded[i] = *(id + i);
             }
-            //more of this assembly will need to be made
-            else {
-                int amount_to_make = n - (assembly -> on_hand);
-                assembly -> on_hand = 0;
-                make(invp, id, amount_to_make, parts); 
+           
+            new_assembly.capacity = capacity;
+
+            //its items are the next row of the BOM graph
+            new_assembly.handle = invp -> assembly_count;
+            if(invp -> assembly_count == invp -> assembly_size) {
+                grow_assemblies(invp);
             }
-        }
-    }
 
-}
+            //add the new assembly to the beginning of the assembly list
+            new_assembly.next = invp -> assembly_list;
+            invp -> assembly_list = new_assembly.handle;
+            invp -> assembly_table[new_assembly.handle] = new_assembly;
+            memset(ON_HAND(invp, &new_assembly), 0,
+            invp -> site_size * sizeof(long long));
+            memcpy(invp -> assembly_ids[new_assembly.handle], padded,
+            ID_SIZE);
+            add_bom(invp, new_assembly.handle, items);
+            free_items_needed(items);
+            invp -> assembly_count++;
+            filter_add(invp, &(invp -> assembly_filter), id);
+            update_dict(invp, &(invp -> assembly_dict), invp -> assembly_ids,
+            invp -> assembly_count);
 
-/* - - - PRINT - - -*/
+        }
+    
+}
 
 /*
- * Print all assemblies in the inventory along with their capacity and
- * the amount on hand of each
+ * Add an item (part or assembly) to an items_needed_t list
  *
- * @param inventory_t* invp - the inventory to be printed
+ * @param inventory_t* invp - the inventory the item must be in
+ * @param items_needed_t* items - the list to add the item to
+ * @param char* id - the ID of the item
+ * @param long long quantity - the amount of the item that is/was required
+ *
+ * @return int - 1: the item is in the list, 0: the ID was not valid or the
+ *               total quantity of the item was too large
  */
-void print_inventory(inventory_t* invp) {
+int add_item(inventory_t* invp, items_needed_t* items, char* id,
+             long long quantity) {
 
-    //sort all assemblies in the inventory 
-    assembly_t** assembly_array = to_assembly_array(invp -> assembly_count,
-    invp -> assembly_list);
-    qsort(assembly_array, invp -> assembly_count, sizeof(void*), assembly_compare);
+    STATS_COUNT(invp, add_item_calls);
+    int valid = 0;
+    int handle = -1;
+    //do not add the item if the id is not valid as a part or assembly
+    if(*(id) == 'P') {
+        if(valid_part_id(invp, id)) {
+            struct part* part = lookup_part(invp, id);
+            if(part != NULL) {
+                valid = 1;
+                handle = part -> handle;
+            }
+            else {
+                fprintf(invp -> err, "!!! %s: part/assembly ID is not in the inventory\n",
+                id);    
+            }
+        }
+    }
+    else if(*(id) == 'A') {
+        if(valid_assembly_id(invp, id)) {
+            if(lookup_assembly(invp, id) != NULL) {
+                valid = 1;
+            }
+            else {
+                fprintf(invp -> err, "!!! %s: part/assembly ID is not in the inventory\n",
+                id);
+            }
+        }
+    }
 
-    printf("Assembly inventory:\n");
-    printf("-------------------\n");
+    if(valid) {
 
-    //if there is at least one assembly in the inventory
-    if(invp -> assembly_count > 0) {
-    
-        printf("Assembly ID Capacity On Hand\n");
-        printf("=========== ======== =======\n");
-       
-        int i;
-        for(i = 0; i < invp -> assembly_count; i++) {
-            printf("%-11s%9d%8d", assembly_array[i] -> id,
-            assembly_array[i] -> capacity, assembly_array[i] -> on_hand);
-            
-            if(assembly_array[i] -> on_hand < 
-            (double)(assembly_array[i] -> capacity) / 2.0) {
-                printf("*");
+        struct item* current_item = lookup_item(invp, items, id);
+        //increment quantity if the item is alrady in the list 
+        if(current_item != NULL) {
+            if(__builtin_add_overflow(current_item -> quantity, quantity,
+               &(current_item -> quantity))) {
+                fprintf(invp -> err, "!!! %s: quantity too large\n", id);
+                valid = 0;
             }
-            printf("\n");
-        
+        }
+        //otherwise, add it to the list
+        else {
+            id_key_t key;
+            id_key(&key, id);
+            push_needed(invp, items, key.bytes, handle, quantity);
         }
     }
-    else {
-        printf("EMPTY INVENTORY\n");
-    }
-    
-    free(assembly_array);
 
+    return valid;
 }
 
+/* - - - TO ARRAY - - -*/
+
 /*
- * Print all parts currently registered in the inventory
+ * Convert the part list to an array of the parts' IDs, each pointing at
+ * the part's ID in 'part_ids' (so ID_HANDLE finds the part)
+ * 
+ * @param inventory_t* invp - the inventory holding the parts list
  *
- * @param inventory_t* invp - the inventory containing the parts
+ * @return char** part_array - the array of IDs
  */
-void print_parts(inventory_t* invp) {
-   
-    //sort all parts in the part_list
-    part_t** part_array = to_part_array(invp -> part_count, 
-    invp -> part_list);
-    qsort(part_array, invp -> part_count, sizeof(void*), part_compare);
-
-    printf("Part inventory:\n");
-    printf("---------------\n");
+char** to_part_array(inventory_t* invp) {
     
-    //there is at least one part
-    if(invp -> part_count > 0) {
-        printf("Part ID\n");
-        printf("===========\n");
-        
-        int i;
-        for(i = 0; i < invp -> part_count; i++) {
-            printf("%s\n", part_array[i] -> id);
+    //dynamically allocate an array of pointers
+    int count = invp -> part_count;
+    char** part_array = calloc(count, sizeof(char*));
+    struct part* part = PART_AT(invp, invp -> part_list);
+
+    //fill the array with values from the linked list
+    int i;
+    for(i = 0; i < count; i++) {
+        if(part != NULL) {
+            part_array[i] = PART_ID(invp, part);
+            part = PART_AT(invp, part -> next);
         }
-    
-    }    
-    //there are no parts
-    else {
-        printf("NO PARTS\n");
-    }
 
-    free(part_array);
+    }
+    
+    return part_array;
 
 }
 
 /*
- * Print all items from an items_needed_t* list
+ * Convert the assembly list to an array of the assemblies' IDs, each
+ * pointing at the assembly's ID in 'assembly_ids' (so ID_HANDLE finds the
+ * assembly)
  *
- * @param items_needed_t* items - the list containing the parts
+ * @param inventory_t* invp - the inventory holding the assembly list
+ *
+ * @return char** assembly_array - the array of IDs
  */
-void print_items_needed(items_needed_t* items) {
-    
-    //sort all items in the items_list
-    item_t** item_array = to_item_array(items -> item_count,
-    items -> item_list);
-    qsort(item_array, items -> item_count, sizeof(void*), item_compare);
+char** to_assembly_array(inventory_t* invp) {
 
+    //dynamically allocate an array of pointers
+    int count = invp -> assembly_count;
+    char** assembly_array = calloc(count, sizeof(char*));
+    struct assembly* assembly = ASSEMBLY_AT(invp, invp -> assembly_list);
 
-    printf("%-11s %s\n", "Part ID", "quantity");
-    printf("=========== ========\n");
-
-    if(items -> item_count > 0) {
-        int i;
-        for(i = 0; i < items -> item_count; i++) {
-            printf("%-11s %8d\n", item_array[i] -> id, 
-            item_array[i] -> quantity);
+    //fill the array with values from the linked list
+    int i;
+    for(i = 0; i < count; i++) {
+        if(assembly != NULL) {
+            assembly_array[i] = ASSEMBLY_ID(invp, assembly);
+            assembly = ASSEMBLY_AT(invp, assembly -> next);
         }
 
     }
-    else {
-        printf("NO PARTS\n");
-    }
 
-    free(item_array);
-}
+    return assembly_array;
 
-/* - - - PROCESS REQUESTS - - -*/
+}
 
 /*
- * Direct requests to the proper functions based on the string given
+ * Convert an item list to an array of items
  *
- * @param char* array[] - the array containing the command and its arguments
- * @param int size - the size of the array
+ * @param items_needed_t* items - the item list to be converted
  *
- * @return int - 0: if command was 'quit', halts processing
- *               1: all other cases
+ * @return item_t** item_array - the array of items
+ */
+item_t ** to_item_array(items_needed_t * items) {
+    
+    //dynamically allocate an array of void pointers
+    item_t** item_array = calloc(items -> item_count, sizeof(item_t*));
+
+    //fill the array in the order of the list
+    int i;
+    for(i = 0; i < items -> item_count; i++) {
+        item_array[i] = ITEM_AT(items, i);
+    }
+
+    return item_array;
+
+}
+
+/* - - - COMPARE - - -*/
+
+/*
+ * Compare two parts or two assemblies based on their IDs
+ * 
+ * @param const void* id1 - a pointer to a stored ID
+ * @param const void* id2 - a pointer to a stored ID
+ * 
+ * @return int - 0: the IDs are equal
+ *              <0: id1's ID is less than id2's ID
+ *              >0: id2's ID is less than id1's ID   
+ */
+int id_compare_at(const void* id1, const void* id2) {
+    
+    return id_compare(*(char**)id1, *(char**)id2);
+    
+}
+
+/*
+ * Compare two items based on their IDs
+ *
+ * @param const void* i1 - a void pointer representing an item
+ * @param const void* i2 - a void pointer representing an item
+ *
+ * @return int - 0: the IDs are equal
+ *              <0: i1's ID is less than i2's ID
+ *              >0: i2's ID is less than i1's ID
+ */
+int item_compare(const void* i1, const void* i2) {
+
+    const struct item* item1 = *(item_t**)i1;
+    const struct item* item2 = *(item_t**)i2;
+
+    return id_compare(item1 -> id, item2 -> id);
+
+}
+
+/* - - - MAKE/GET - - -*/
+
+/*
+ * Find the 'on_hand' value to use for an assembly. Outside a quote this is
+ * the assembly's own value (logged first if the order is a transaction), 
+ * in a quote it is the overlay's copy of it, which is created on first use 
+ * so only the assemblies touched by the order are ever copied.
+ *
+ * @param inventory_t* invp - the inventory holding the assembly
+ * @param assembly_t* assembly - the assembly whose 'on_hand' is needed
+ * @param order_t* order - the state of the order, or NULL
+ *
+ * @return long long* - the address of the 'on_hand' value to read and update
+ */
+static long long* lookup_on_hand(inventory_t* invp, assembly_t* assembly,
+                                 order_t* order) {
+
+    if(order == NULL) {
+        PRESERVE(invp, assembly);
+        return &(ON_HAND(invp, assembly)[0]);
+    }
+
+    if(order -> overlay == NULL) {
+        PRESERVE(invp, assembly);
+        //log the value before the caller changes it
+        undo_log_t* log = order -> log;
+        if(log != NULL) {
+            if(log -> undo_count == log -> undo_size) {
+                log -> undo_size = (log -> undo_size == 0) ? 
+                8 : log -> undo_size * 2;
+                log -> undo_array = realloc(log -> undo_array, 
+                log -> undo_size * sizeof(struct undo));
+                STATS_COUNT(invp, allocations);
+            }
+            log -> undo_array[log -> undo_count].assembly = assembly;
+            log -> undo_array[log -> undo_count].site = order -> site;
+            log -> undo_array[log -> undo_count].on_hand = 
+            ON_HAND(invp, assembly)[order -> site];
+            log -> undo_count++;
+        }
+        return &(ON_HAND(invp, assembly)[order -> site]);
+    }
+
+    overlay_t* overlay = order -> overlay;
+    int handle = assembly -> handle;
+    if(overlay -> generation == 0) {
+        //0 stamps no copy, so it is skipped when the generations wrap
+        if(++(invp -> shadow_generation) == 0) {
+            invp -> shadow_generation = 1;
+        }
+        overlay -> generation = invp -> shadow_generation;
+    }
+
+    //first time this assembly is touched, copy its value into the overlay
+    if(invp -> shadow_stamp[handle] != overlay -> generation) {
+        if(overlay -> touched_count == overlay -> touched_size) {
+            overlay -> touched_size = (overlay -> touched_size == 0) ?
+            8 : overlay -> touched_size * 2;
+            overlay -> touched = realloc(overlay -> touched,
+            overlay -> touched_size * sizeof(int));
+            STATS_COUNT(invp, allocations);
+        }
+        overlay -> touched[overlay -> touched_count++] = handle;
+        invp -> shadow_stamp[handle] = overlay -> generation;
+        invp -> shadow_on_hand[handle] = ON_HAND(invp, assembly)[order -> site];
+    }
+
+    return &(invp -> shadow_on_hand[handle]);
+}
+
+/*
+ * Put back every 'on_hand' value changed by an order, newest change first,
+ * and drop the units it held as pending
+ *
+ * @param inventory_t* invp - the inventory the order changed
+ * @param undo_log_t* log - the changes made by the order
+ */
+static void rollback(inventory_t* invp, undo_log_t* log) {
+    
+    int i;
+    for(i = log -> undo_count - 1; i >= 0; i--) {
+        struct undo* undo = &(log -> undo_array[i]);
+        PRESERVE(invp, undo -> assembly);
+        SET_ON_HAND(&(ON_HAND(invp, undo -> assembly)[undo -> site]),
+        undo -> on_hand);
+        (undo -> assembly) -> pending = 0;
+    }
+    log -> undo_count = 0;
+}
+
+/*
+ * Make a given amount of an assembly as part of an order, using up what is
+ * on hand first
+ *
+ * @param inventory_t* invp - the inventory holding the assembly
+ * @param assembly_t* assembly - the assembly to be made
+ * @param long long n - the number of assemblies needed
+ * @param order_t* order - the state of the order, or NULL
+ *
+ * @return int - 1: done, 0: a quantity needed was too large
+ */
+static int make_assembly(inventory_t* invp, assembly_t* assembly, long long n,
+                         order_t* order) {
+    int fits = 1;
+    STATS_ENTER_MAKE(invp);
+
+    long long* on_hand = lookup_on_hand(invp, assembly, order);
+    long long amount_to_make = 0;
+    if(n >= *on_hand) {
+        amount_to_make = n - *on_hand;
+        fprintf(invp -> out, ">>> make %lld units of assembly %s\n",
+        amount_to_make, ASSEMBLY_ID(invp, assembly));
+        report(invp, RECORD_MADE, ASSEMBLY_ID(invp, assembly),
+        amount_to_make, 0);
+        SET_ON_HAND(on_hand, 0);
+    }
+    else {
+        SET_ON_HAND(on_hand, *on_hand - n);
+    }
+    if(amount_to_make > 0) {
+        fits = make_items(invp, assembly, amount_to_make, order);
+    }
+
+    STATS_LEAVE_MAKE(invp);
+    return fits;
+}
+
+/*
+ * Take a given amount of sub-assemblies from stock as part of an order,
+ * making any shortfall
+ *
+ * @param inventory_t* invp - the inventory holding the assembly
+ * @param assembly_t* assembly - the assembly needed
+ * @param long long n - the number of assemblies needed
+ * @param order_t* order - the state of the order, or NULL
+ *
+ * @return int - 1: done, 0: a quantity needed was too large
+ */
+static int get_from(inventory_t* invp, assembly_t* assembly, long long n,
+                    order_t* order) {
+    int fits = 1;
+    long long* on_hand = lookup_on_hand(invp, assembly, order);
+    consume(invp, assembly, n, order);
+    //check if there are enough of this assembly in stock
+    if(*on_hand >= n) {
+        SET_ON_HAND(on_hand, *on_hand - n);
+    }
+    //more of this assembly will need to be made
+    else {
+        long long amount_to_make = n - *on_hand;
+        SET_ON_HAND(on_hand, 0);
+        fits = make_assembly(invp, assembly, amount_to_make, order); 
+    }
+    return fits;
+}
+
+/*
+ * Take the items for a number of units of an assembly: parts are added to
+ * the parts needed, and sub-assemblies are taken from stock (and made if
+ * there are not enough). The items are the assembly's row of the BOM
+ * graph, so this walks two arrays instead of a list.
+ *
+ * @param inventory_t* invp - the inventory holding the assembly
+ * @param assembly_t* assembly - the assembly
+ * @param long long n - the number of units being made
+ * @param order_t* order - the state of the order, or NULL
+ *
+ * @return int - 1: done, 0: a quantity needed was too large
+ */
+static int make_items(inventory_t* invp, assembly_t* assembly, long long n,
+                      order_t* order) {
+    int fits = 1;
+    long long quantity;
+    int entry = assembly -> bom_first;
+    int end = entry + assembly -> bom_length;
+
+    for(; entry < end && fits; entry++) {
+        int child = invp -> bom_child[entry];
+        fits = multiply_quantity(invp, child, invp -> bom_quantity[entry], n,
+        &quantity);
+        //a part
+        if(fits && child >= 0) {
+            fits = need_part(invp, child, quantity);
+        }
+        //a sub-assembly
+        else if(fits) {
+            fits = get_from(invp,
+            &(invp -> assembly_table[BOM_ASSEMBLY(child)]), quantity, order);
+        }
+    }
+    return fits;
+}
+
+/*
+ * Find the assembly of an order line, or say why the line is not valid
+ *
+ * @param inventory_t* invp - the inventory holding the assemblies
+ * @param char* id - the ID of the assembly ordered
+ * @param long long n - the number ordered
+ *
+ * @return assembly_t* - the assembly, NULL if 'n' is not positive or the
+ *                       assembly is not in the inventory
+ */
+static assembly_t* order_line(inventory_t* invp, char* id, long long n) {
+
+    //check for valid amount 
+    if(n <= 0) {
+        fprintf(invp -> err, 
+        "!!! %lld: illegal order quantity for ID %s -- order canceled\n", n,
+        id);
+        return NULL;
+    }
+    struct assembly* assembly = lookup_assembly(invp, id);
+    //assembly was not found
+    if(assembly == NULL) {
+        fprintf(invp -> err,
+        "!!! %s: assembly ID is not in the inventory -- order canceled\n",
+        id);
+    }
+    return assembly;
+}
+
+/*
+ * Make a given amount of assemblies as one line of an order
+ *
+ * @param inventory_t* invp - the inventory holding the assemblies
+ * @param char* id - the ID of the assembly to be made
+ * @param long long n - the number of assemblies needed
+ * @param order_t* order - the state of the order, or NULL
+ *
+ * @return int - 1: done (or the line was not valid), 0: a quantity needed
+ *               was too large
+ */
+static int make_from(inventory_t* invp, char* id, long long n,
+                     order_t* order) {
+    assembly_t* assembly = order_line(invp, id, n);
+    return (assembly != NULL) ? make_assembly(invp, assembly, n, order) : 1;
+}
+
+/*
+ * Quote a given amount of an assembly by pushing demand down the BOM graph
+ * level by level, a sparse matrix times a demand vector. Every assembly was
+ * added after the assemblies it is made from, so its handle is higher than
+ * theirs, and taking the highest handle with demand first reaches each
+ * assembly once, after all of its parents, with their demand on it added
+ * up. Taking that total from stock at once leaves the same amount on hand
+ * and makes the same amount as taking it one parent at a time.
+ *
+ * @param inventory_t* invp - the inventory holding the assemblies
+ * @param assembly_t* top - the assembly quoted
+ * @param long long n - the number quoted (more than 0)
+ * @param order_t* order - the quote's overlay and list of assemblies made
+ *
+ * @return int - 1: done, 0: a quantity needed was too large
+ */
+static int propagate(inventory_t* invp, assembly_t* top, long long n,
+                     order_t* order) {
+
+    int fits = add_demand(invp, top -> handle, n);
+    long long quantity;
+
+    while(invp -> demand_count > 0) {
+        int handle = next_demand(invp);
+        long long demand = invp -> demand[handle];
+        invp -> demand[handle] = 0;
+        //after a failure the queue is only emptied
+        if(!fits) {
+            continue;
+        }
+        STATS_COUNT(invp, make_calls);
+
+        assembly_t* assembly = &(invp -> assembly_table[handle]);
+        long long* on_hand = lookup_on_hand(invp, assembly, order);
+        long long amount_to_make = demand - *on_hand;
+        if(amount_to_make <= 0) {
+            SET_ON_HAND(on_hand, *on_hand - demand);
+            continue;
+        }
+        SET_ON_HAND(on_hand, 0);
+        fits = add_needed(invp, order -> made, ASSEMBLY_ID(invp, assembly),
+        -1, amount_to_make);
+
+        int entry = assembly -> bom_first;
+        int end = entry + assembly -> bom_length;
+        for(; entry < end && fits; entry++) {
+            int child = invp -> bom_child[entry];
+            fits = multiply_quantity(invp, child, invp -> bom_quantity[entry],
+            amount_to_make, &quantity);
+            if(fits && child >= 0) {
+                fits = need_part(invp, child, quantity);
+            }
+            else if(fits) {
+                fits = add_demand(invp, BOM_ASSEMBLY(child), quantity);
+            }
+        }
+    }
+    return fits;
+}
+
+/*
+ * Make a given amount of assemblies from an inventory
+ *
+ * @param inventory_t* invp - the inventory holding the assemblies
+ * @param char* id - the ID of the assembly to be made
+ * @param long long n - the number of assemblies needed
+ * @param items_needed* parts - the parts/sub-assemblies required to 
+ *                              create this assembly
+ *
+ * @return int - 1: done, 0: a quantity needed was too large
+ */
+int make(inventory_t* invp, char* id, long long n, items_needed_t* parts) {
+    return flush_parts(invp, parts, make_from(invp, id, n, NULL));
+}
+
+/*
+ * Determine if there is enough of a given amount of assemblies 
+ * from an inventory
+ *
+ * @param inventory_t* invp - the inventory holding the assembly
+ * @param char* id - the ID of the assembly to be made
+ * @param long long n - the number of assemblies needed
+ * @param items_needed* parts - the parts/sub-assemblies required to 
+ *                              create this assembly
+ *
+ * @return int - 1: done, 0: a quantity needed was too large
+ */
+int get(inventory_t * invp, char * id, long long n, items_needed_t * parts) {
+    int fits = 1;
+    //check for valid amount
+    if(n <= 0) {
+        fprintf(invp -> err, "!!! %lld: illegal order quantity for ID %s\n",
+        n, id);
+    }
+    else {
+        struct assembly* assembly = lookup_assembly(invp, id);
+        //assembly was not found
+        if(assembly == NULL) {
+            fprintf(invp -> err,
+            "!!! %s: assembly ID is not in the inventory -- order canceled\n",
+            id);
+        }
+        else {
+            fits = get_from(invp, assembly, n, NULL);
+        }
+    }
+    return flush_parts(invp, parts, fits);
+}
+
+/*
+ * Determine what making a given amount of assemblies would take, without
+ * changing the inventory. 'on_hand' values are read through the overlay, so
+ * several order lines can be quoted one after another against the same 
+ * overlay, and only the assemblies touched by the order are copied.
+ *
+ * @param inventory_t* invp - the inventory holding the assemblies
+ * @param char* id - the ID of the assembly to be quoted
+ * @param long long n - the number of assemblies needed
+ * @param overlay_t* overlay - the 'on_hand' values changed by the quote
+ * @param items_needed* made - the assemblies that would be made
+ * @param items_needed* parts - the parts that would be needed
+ *
+ * @return int - 1: done, 0: a quantity needed was too large
+ */
+int quote(inventory_t* invp, char* id, long long n, overlay_t* overlay,
+          items_needed_t* made, items_needed_t* parts) {
+
+    struct order order = { overlay, made, NULL, 0 };
+    assembly_t* assembly = order_line(invp, id, n);
+    int fits = (assembly != NULL) ? propagate(invp, assembly, n, &order) : 1;
+    return flush_parts(invp, parts, fits);
+}
+
+/*
+ * Fulfill an order as a single transaction. Every 'on_hand' change is 
+ * logged as the lines are made, and if any line turns out to be invalid the
+ * log is played back so the inventory is left as it was before the order.
+ * A line needing a quantity too large to count cancels the order too.
+ *
+ * @param inventory_t* invp - the inventory holding the assemblies
+ * @param int count - the number of lines in the order
+ * @param char* ids[] - the assembly ID of each line
+ * @param int amounts[] - the amount ordered on each line
+ * @param items_needed* parts - the parts required to fulfill the order
+ *
+ * @return int - 1: the order was fulfilled, 0: the order was rolled back
+ */
+int fulfill_order(inventory_t* invp, int site, int count, char* ids[],
+                  int amounts[], items_needed_t* parts) {
+
+    struct undo_log log = { NULL, 0, 0 };
+    struct order order = { NULL, NULL, &log, site };
+    int valid = 1;
+
+    int i;
+    for(i = 0; i < count; i++) {
+
+        //make will throw proper errors if needed
+        int fits = make_from(invp, ids[i], amounts[i], &order);
+        struct assembly* assembly = lookup_assembly(invp, ids[i]);
+        
+        //determine if the arguments are valid 
+        if(!fits || amounts[i] <= 0 || assembly == NULL) {
+            
+            //eject from the loop and undo the lines already made
+            valid = 0;
+            i = count;
+            rollback(invp, &log);
+        }
+        else {
+            consume(invp, assembly, amounts[i], &order);
+        }
+    
+    }
+
+    //the parts are only listed for an order that went through
+    if(!flush_parts(invp, parts, valid) && valid) {
+        valid = 0;
+        rollback(invp, &log);
+    }
+    //a fulfilled order is one more order of history for the velocities
+    if(valid) {
+        invp -> order_count++;
+        commit(invp, &log, 1);
+    }
+
+    free(log.undo_array);
+    return valid;
+}
+
+/* - - - PRINT - - -*/
+
+/*
+ * Print all assemblies in the inventory along with their capacity and
+ * the amount on hand of each
+ *
+ * @param inventory_t* invp - the inventory to be printed
+ */
+void print_inventory(inventory_t* invp) {
+
+    //sort all assemblies in the inventory 
+    char** assembly_array = to_assembly_array(invp);
+    STATS_COUNT(invp, allocations);
+    qsort(assembly_array, invp -> assembly_count, sizeof(char*),
+    id_compare_at);
+
+    fprintf(invp -> out, "Assembly inventory:\n");
+    fprintf(invp -> out, "-------------------\n");
+
+    //if there is at least one assembly in the inventory
+    if(invp -> assembly_count > 0) {
+    
+        fprintf(invp -> out, "Assembly ID Capacity On Hand\n");
+        fprintf(invp -> out, "=========== ======== =======\n");
+       
+        int i;
+        for(i = 0; i < invp -> assembly_count; i++) {
+            assembly_t* assembly = &(invp -> assembly_table[ID_HANDLE(
+            invp -> assembly_ids, assembly_array[i])]);
+            long long on_hand = STOCK_AT(invp, assembly, 0);
+            fprintf(invp -> out, "%-11s%9lld%8lld", assembly_array[i],
+            assembly -> capacity, on_hand);
+            report(invp, RECORD_ASSEMBLY, assembly_array[i],
+            assembly -> capacity, on_hand);
+            
+            if(on_hand < 
+            (double)(assembly -> capacity) / 2.0) {
+                fprintf(invp -> out, "*");
+            }
+            fprintf(invp -> out, "\n");
+        
+        }
+    }
+    else {
+        fprintf(invp -> out, "EMPTY INVENTORY\n");
+    }
+    
+    free(assembly_array);
+
+}
+
+/*
+ * Print all assemblies with their capacity and the amount on hand added up
+ * across every site (each site has a bin of the assembly's capacity)
+ *
+ * @param inventory_t* invp - the inventory to be printed
+ */
+void print_all_sites(inventory_t* invp) {
+
+    char** assembly_array = to_assembly_array(invp);
+    STATS_COUNT(invp, allocations);
+    qsort(assembly_array, invp -> assembly_count, sizeof(char*),
+    id_compare_at);
+
+    fprintf(invp -> out, "Assembly inventory (all sites):\n");
+    fprintf(invp -> out, "-------------------------------\n");
+    fprintf(invp -> out, "Sites:");
+    int site;
+    for(site = 0; site < invp -> site_count; site++) {
+        fprintf(invp -> out, " %s", invp -> site_names[site]);
+    }
+    fprintf(invp -> out, "\n");
+
+    if(invp -> assembly_count > 0) {
+
+        fprintf(invp -> out, "Assembly ID Capacity On Hand\n");
+        fprintf(invp -> out, "=========== ======== =======\n");
+
+        int i;
+        for(i = 0; i < invp -> assembly_count; i++) {
+            assembly_t* assembly = &(invp -> assembly_table[ID_HANDLE(
+            invp -> assembly_ids, assembly_array[i])]);
+            long long capacity = assembly -> capacity * invp -> site_count;
+            long long on_hand = total_on_hand(invp, assembly);
+            fprintf(invp -> out, "%-11s%9lld%8lld", assembly_array[i],
+            capacity, on_hand);
+            report(invp, RECORD_ASSEMBLY, assembly_array[i], capacity,
+            on_hand);
+
+            if(on_hand < (double)capacity / 2.0) {
+                fprintf(invp -> out, "*");
+            }
+            fprintf(invp -> out, "\n");
+        }
+    }
+    else {
+        fprintf(invp -> out, "EMPTY INVENTORY\n");
+    }
+
+    free(assembly_array);
+}
+
+/*
+ * Print the parts whose IDs start with a prefix, in order. The dictionary
+ * is read from the first ID not before the prefix for as long as its IDs
+ * start with it, and the few parts added since it was laid out are sorted
+ * and merged in, so nothing is sorted but those.
+ *
+ * @param inventory_t* invp - the inventory containing the parts
+ * @param char* prefix - the start of the IDs listed, NULL for every part
+ */
+void parts_request(inventory_t* invp, char* prefix) {
+
+    id_dict_t* dict = &(invp -> part_dict);
+    int tail = invp -> part_count - dict -> count;
+    char** added = dict_tail(dict, invp -> part_ids, invp -> part_count);
+    STATS_COUNT(invp, allocations);
+
+    prefix = (prefix != NULL) ? prefix : "";
+    size_t length = strlen(prefix);
+    dict_cursor_t cursor;
+    int j = 0;
+    //an ID never starts with a prefix too long to be stored
+    if(length > ID_MAX) {
+        cursor.at = dict -> count;
+        j = tail;
+    }
+    else {
+        id_key_t from;
+        id_key(&from, prefix);
+        dict_seek(invp, dict, &cursor, from.bytes);
+    }
+
+    fprintf(invp -> out, "Part inventory:\n");
+    fprintf(invp -> out, "---------------\n");
+
+    int listed = 0;
+    while(1) {
+        while(j < tail && strncmp(added[j], prefix, length) != 0) {
+            j++;
+        }
+        int in_dict = (cursor.at < dict -> count
+                       && strncmp(cursor.id.bytes, prefix, length) == 0);
+        if(!in_dict && j == tail) {
+            break;
+        }
+
+        //there is at least one part
+        if(listed++ == 0) {
+            fprintf(invp -> out, "Part ID\n");
+            fprintf(invp -> out, "===========\n");
+        }
+        if(in_dict && (j == tail
+           || id_compare(cursor.id.bytes, added[j]) < 0)) {
+            fprintf(invp -> out, "%s\n", cursor.id.bytes);
+            report(invp, RECORD_PART_ID, cursor.id.bytes, 0, 0);
+            dict_next(dict, &cursor);
+        }
+        else {
+            fprintf(invp -> out, "%s\n", added[j]);
+            report(invp, RECORD_PART_ID, added[j], 0, 0);
+            j++;
+        }
+    }
+    //there are no parts
+    if(listed == 0) {
+        fprintf(invp -> out, "NO PARTS\n");
+    }
+
+    free(added);
+}
+
+/*
+ * Print all parts currently registered in the inventory
+ *
+ * @param inventory_t* invp - the inventory containing the parts
+ */
+void print_parts(inventory_t* invp) {
+    parts_request(invp, NULL);
+}
+
+/*
+ * Print all items from an items_needed_t* list under a given column heading
+ *
+ * @param inventory_t* invp - the inventory the list came from
+ * @param items_needed_t* items - the list containing the items
+ * @param char* heading - the heading of the ID column
+ * @param char* none - the line printed if the list is empty
+ * @param int record - the kind of record each item is reported as
+ */
+static void print_item_table(inventory_t* invp, items_needed_t* items,
+                             char* heading, char* none, int record) {
+    
+    //sort all items in the items_list
+    item_t** item_array = to_item_array(items);
+    STATS_COUNT(invp, allocations);
+    qsort(item_array, items -> item_count, sizeof(void*), item_compare);
+
+
+    fprintf(invp -> out, "%-11s %s\n", heading, "quantity");
+    fprintf(invp -> out, "=========== ========\n");
+
+    if(items -> item_count > 0) {
+        int i;
+        for(i = 0; i < items -> item_count; i++) {
+            fprintf(invp -> out, "%-11s %8lld\n", item_array[i] -> id, 
+            item_array[i] -> quantity);
+            report(invp, record, item_array[i] -> id,
+            item_array[i] -> quantity, 0);
+        }
+
+    }
+    else {
+        fprintf(invp -> out, "%s\n", none);
+    }
+
+    free(item_array);
+}
+
+/*
+ * Print all items from an items_needed_t* list
+ *
+ * @param inventory_t* invp - the inventory the list came from
+ * @param items_needed_t* items - the list containing the parts
  */
-static int process_request(char* array[], int size) {
+void print_items_needed(inventory_t* invp, items_needed_t* items) {
+    print_item_table(invp, items, "Part ID", "NO PARTS", RECORD_PART);
+}
 
-    char* command = array[0];
-    
-    //***************************************************************ADD PART 
-    if(strncmp(command, "addPart", strlen(command)) == 0) {
-        
-        printf("+ addPart %s\n", array[1]);
+/* - - - PROCESS REQUESTS - - -*/
+
+/*
+ * Split a request line into its command and arguments. The line is trimmed
+ * and tokenized in place, and anything after a '#' is a comment. Tokens
+ * are separated by spaces, which are found a chunk of SCAN_WIDTH bytes at
+ * a time (see scan.h): a token starts at a byte that is not a space after
+ * one that is, and ends at a space after one that is not.
+ *
+ * @param char* line - the request line (changed in place)
+ * @param char* array[] - filled with the tokens of the request, must hold
+ *                       at least MAX_LENGTH tokens
+ *
+ * @return int - the number of tokens, 0 if the line holds no request
+ */
+int tokenize(char* line, char* array[]) {
+
+    char* end = line + strlen(line);
+    char* chunk = line;
+    unsigned int spaces, white, starts, ends, valid;
+    //the byte before the first is taken to be a space
+    unsigned int previous = 1;
+    int i = 0;
 
-        //check validity of part id
-        if(valid_part_id(array[1])) {
-            add_part(inventory, array[1]);
-            return 1;
+    //trailing whitespace is cut off, leading whitespace is skipped
+    while(end > line && scan_is_white(end[-1])) {
+        end--;
+    }
+    *end = '\0';
+    for(; chunk < end; chunk += SCAN_WIDTH) {
+        scan_span(chunk, end - chunk, &white);
+        valid = ~white & SCAN_VALID(end - chunk);
+        if(valid != 0) {
+            chunk += __builtin_ctz(valid);
+            break;
         }
+    }
 
-        return 1;
+    for(; chunk < end; chunk += SCAN_WIDTH) {
+        valid = SCAN_VALID(end - chunk);
+        spaces = scan_span(chunk, end - chunk, &white) & valid;
+        starts = ~spaces & ((spaces << 1) | previous) & valid;
+        ends = spaces & ~((spaces << 1) | previous);
+        previous = spaces >> (SCAN_WIDTH - 1);
+
+        //the starts and ends are taken in the order they are in the line
+        for(starts |= ends; starts != 0; starts &= starts - 1) {
+            char* at = chunk + __builtin_ctz(starts);
+            if(*at == ' ') {
+                *at = '\0';
+            }
+            //a token starting with '#' is a comment to the end of the line
+            else if(*at == '#' || i == MAX_LENGTH) {
+                return i;
+            }
+            else {
+                array[i++] = at;
+            }
+        }
     }
-    //***********************************************************ADD ASSEMBLY 
-    else if(strncmp(command, "addAssembly", strlen(command)) == 0) {
-        
-        printf("+ addAssembly ");
-        int i;
-        for(i = 1; i < size; i++) {
-            printf("%s ", array[i]);
+
+    return i;
+}
+
+/*
+ * Read a number the way strtol(text, NULL, 10) does: after any whitespace
+ * and a sign, as many digits as there are, with a number too large for a
+ * long read as LONG_MAX (LONG_MIN if negative) and no digits read as 0.
+ * The digits are converted 8 at a time (see scan.h).
+ *
+ * @param const char* text - the text the number is at the start of
+ *
+ * @return long - the number
+ */
+long parse_number(const char* text) {
+
+    //room for 20 digits (one more than a long holds) and a read past them
+    char digits[32];
+    size_t length;
+    int negative = 0;
+    int count, part;
+    unsigned long long value = 0;
+    static const unsigned long long powers[9] = {
+        1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000
+    };
+
+    while(scan_is_white(*text)) {
+        text++;
+    }
+    if(*text == '+' || *text == '-') {
+        negative = (*text == '-');
+        text++;
+    }
+    while(*text == '0') {
+        text++;
+    }
+    if(*text < '0' || *text > '9') {
+        return 0;
+    }
+
+    length = strnlen(text, 20);
+    memset(digits, 0, sizeof(digits));
+    memcpy(digits, text, length);
+    count = scan_digits(digits);
+    if(count == 8) {
+        count += scan_digits(digits + 8);
+        if(count == 16) {
+            count += scan_digits(digits + 16);
+        }
+    }
+
+    //more than 19 digits is more than an unsigned long long can hold
+    if(count > 19) {
+        return negative ? LONG_MIN : LONG_MAX;
+    }
+    for(part = 0; part < count; part += 8) {
+        int run = (count - part < 8) ? count - part : 8;
+        value = value * powers[run] + scan_value(digits + part, run);
+    }
+
+    if(negative) {
+        return (value > (unsigned long long)LONG_MAX) ? LONG_MIN
+        : -(long)value;
+    }
+    return (value > (unsigned long long)LONG_MAX) ? LONG_MAX : (long)value;
+}
+
+/*
+ * Get an argument of a request, or an empty string if it was not given
+ *
+ * @param char* array[] - the array containing the command and its arguments
+ * @param int size - the size of the array
+ * @param int i - the index of the argument
+ *
+ * @return char* - the argument
+ */
+static char* argument(char* array[], int size, int i) {
+    return (i < size) ? array[i] : "";
+}
+
+/*
+ * Determine which request a command names. Any leading part of a command
+ * name is accepted, with the lowest REQUEST_ code that matches winning.
+ *
+ * @param char* command - the command as given
+ *
+ * @return int - the REQUEST_ code of the command, REQUEST_UNKNOWN if none
+ */
+int lookup_command(char* command) {
+
+    int code;
+    for(code = 1; code < REQUEST_COUNT; code++) {
+        if(strncmp(command, command_names[code], strlen(command)) == 0) {
+            return code;
         }
-        printf("\n");
+    }
+    return REQUEST_UNKNOWN;
+}
+
+/*
+ * Print a parts needed list, if any parts were needed for a request
+ *
+ * @param inventory_t* invp - the inventory the request was made on
+ * @param items_needed_t* parts - the parts needed
+ * @param char* underline - the line printed under the title
+ */
+static void print_parts_needed(inventory_t* invp, items_needed_t* parts,
+                               char* underline) {
+    if(parts -> item_count > 0) {
+        fprintf(invp -> out, "Parts needed:\n");
+        fprintf(invp -> out, "%s\n", underline);
+        print_items_needed(invp, parts);
+    }
+}
+
+/*
+ * Check the parts needed by a request against part stock, and print the
+ * parts that are short, if any
+ *
+ * @param inventory_t* invp - the inventory the request was made on
+ * @param items_needed_t* parts - the parts needed
+ * @param int take - 1: take the parts out of stock, 0: only check them
+ */
+static void print_shortages(inventory_t* invp, items_needed_t* parts,
+                            int take) {
+
+    struct items_needed* shortages = calloc(1, sizeof(struct items_needed));
+    STATS_COUNT(invp, allocations);
+    take_parts(invp, parts, take, shortages);
+    if(shortages -> item_count > 0) {
+        fprintf(invp -> out, "Part shortages:\n");
+        fprintf(invp -> out, "---------------\n");
+        print_item_table(invp, shortages, "Part ID", "NO PARTS",
+        RECORD_SHORTAGE);
+    }
+    free_items_needed(shortages);
+}
+
+/*
+ * Add a part to the inventory (addPart ID)
+ *
+ * @param inventory_t* invp - the inventory
+ * @param char* id - the ID of the part
+ */
+void add_part_request(inventory_t* invp, char* id) {
+    //check validity of part id
+    if(valid_part_id(invp, id)) {
+        add_part(invp, id);
+    }
+}
+
+/*
+ * Add an assembly to the inventory (addAssembly ID capacity [x1 n1 ...])
+ *
+ * @param inventory_t* invp - the inventory
+ * @param char* id - the ID of the assembly
+ * @param int capacity - the capacity of the assembly's bin
+ * @param int count - the number of items the assembly is made from
+ * @param char* ids[] - the ID of each item
+ * @param int amounts[] - the quantity of each item
+ * @param char* amount_text[] - each quantity as it was given, for error
+ *                              messages (NULL if not given as text)
+ */
+void add_assembly_request(inventory_t* invp, char* id, int capacity,
+                          int count, char* ids[], int amounts[],
+                          char* amount_text[]) {
+
+    if(valid_assembly_id(invp, id)) {
 
         struct items_needed* items_needed = calloc(
         1, sizeof( struct items_needed));
-
-        items_needed -> item_count = 0;
+        STATS_COUNT(invp, allocations);
         
-        if(valid_assembly_id(array[1])) {
-
-            //check if there are items needed for the assembly
-            //array[0] = addAssembly
-            //array[1] = assembly ID
-            //array[2] = capacity
-            //array[3...] = items needed
-            int valid = 1;
-            //iterate through the given array of tokens and create items 
-            int i;
-            for(i = 3; i < size; i+=2) {
-                //if there is a value after the item ID
-                if((i + 1) < size) {
-                    
-                    valid = valid_item(inventory, array[i]);
-                    if(valid) {
-                        if(strtol(array[i+1], NULL, 10) > 0) {
-                            add_item(items_needed, array[i],
-                            strtol(array[i+1], NULL, 10));
-                        }
-                        else {
-                            fprintf(stderr, 
-                            "!!! %s: illegal quantity for ID %s\n",
-                            array[i+1], array[i]);
-                            //deem the request invalid and eject from the loop
-                            valid = 0;
-                            i = size;
-                        }
+        int valid = 1;
+        //iterate through the given items and create them 
+        int i;
+        for(i = 0; i < count; i++) {
+            
+            valid = valid_item(invp, ids[i]);
+            if(valid) {
+                if(amounts[i] > 0) {
+                    add_item(invp, items_needed, ids[i], amounts[i]);
+                }
+                else {
+                    if(amount_text != NULL) {
+                        fprintf(invp -> err, 
+                        "!!! %s: illegal quantity for ID %s\n",
+                        amount_text[i], ids[i]);
                     }
-                    //eject from the loop
                     else {
-                        i = size;
+                        fprintf(invp -> err, 
+                        "!!! %d: illegal quantity for ID %s\n",
+                        amounts[i], ids[i]);
                     }
-
+                    //deem the request invalid and eject from the loop
+                    valid = 0;
+                    i = count;
                 }
             }
-            //only add the assembly if all of it's needed items were valid
-            if(valid) {
-                add_assembly(inventory, array[1], strtol(array[2], NULL, 10)
-                , items_needed);
-            }
+            //eject from the loop
             else {
-                free_items_needed(items_needed);
+                i = count;
             }
 
         }
+        //only add the assembly if all of it's needed items were valid
+        if(valid) {
+            add_assembly(invp, id, capacity, items_needed);
+        }
+        else {
+            free_items_needed(items_needed);
+        }
 
-        return 1;
     }
-    //**********************************************************FULFILL ORDER 
-    else if(strncmp(command, "fulfillOrder", strlen(command)) == 0) {
-        
-        printf("+ fulfillOrder ");
+}
+
+/*
+ * Fulfill an order and print the parts it needed 
+ * (fulfillOrder [@site] [x1 n1 [x2 n2 ...]])
+ *
+ * @param inventory_t* invp - the inventory
+ * @param int site - the number of the site the order is filled from
+ * @param int count - the number of lines in the order
+ * @param char* ids[] - the assembly ID of each line
+ * @param int amounts[] - the amount ordered on each line
+ */
+void fulfill_order_request(inventory_t* invp, int site, int count,
+                           char* ids[], int amounts[]) {
+
+    struct items_needed* parts = calloc(1, sizeof(struct items_needed));
+    STATS_COUNT(invp, allocations);
+
+    //if the process was valid, show any parts needed for this request 
+    if(count > 0 && fulfill_order(invp, site, count, ids, amounts, parts)) {
+        print_parts_needed(invp, parts, "-------------");
+        print_shortages(invp, parts, 1);
+    }
+    
+    free_items_needed(parts);
+}
+
+/*
+ * Quote an order and print what it would take (quote [x1 n1 [x2 n2 ...]])
+ *
+ * @param inventory_t* invp - the inventory
+ * @param int count - the number of lines in the order
+ * @param char* ids[] - the assembly ID of each line
+ * @param int amounts[] - the amount ordered on each line
+ */
+void quote_request(inventory_t* invp, int count, char* ids[], int amounts[]) {
+
+    struct items_needed* made = calloc(1, sizeof(struct items_needed));
+    struct items_needed* parts = calloc(1, sizeof(struct items_needed));
+    struct overlay* overlay = calloc(1, sizeof(struct overlay));
+    STATS_ADD(invp, allocations, 3);
+
+    //same arguments as fulfillOrder, but nothing in the inventory changes
+    if(count > 0) {
+        int valid = 1;
         int i;
-        for(i = 1; i < size; i++) {
-            printf("%s ", array[i]);
+        for(i = 0; i < count; i++) {
+
+            int fits = quote(invp, ids[i], amounts[i], overlay, made, parts);
+
+            if(!fits || amounts[i] <= 0
+                || lookup_assembly(invp, ids[i]) == NULL) {
+                valid = 0;
+                i = count;
+            }
+
         }
-        printf("\n");    
+        if(valid) {
+            fprintf(invp -> out, "Assemblies to make:\n");
+            fprintf(invp -> out, "-------------------\n");
+            print_item_table(invp, made, "Assembly ID", "NO ASSEMBLIES", 
+            RECORD_QUOTED);
+            fprintf(invp -> out, "Parts needed:\n");
+            fprintf(invp -> out, "-------------\n");
+            print_items_needed(invp, parts);
+            //a quote only checks the part stock
+            print_shortages(invp, parts, 0);
+        }
+    }
 
-        struct items_needed* parts = calloc(1, sizeof(struct items_needed));
+    free_overlay(invp, overlay);
+    free_items_needed(made);
+    free_items_needed(parts);
+}
 
-        //array[0] = fulfillOrder
-        //array[1] = assembly1
-        //array[2] = amount1
-        //array[n] = assemblyn
-        //array[n+1] = amountn
-        if(size >= 3) {
-            int i;
-            int valid = 1;
-            for(i = 1; i < size; i+=2) {
-    
-                //make will throw proper errors if needed
-                make(inventory, array[i], strtol(array[i+1], NULL, 10)
-                , parts);
-                
-                //determine if the arguments are valid 
-                if(strtol(array[i+1], NULL, 10) <= 0 
-                    || lookup_assembly(inventory -> assembly_list,
-                        array[i]) == NULL) {
-                    
-                    //eject from the loop and do not proceed
-                    valid = 0;
-                    i = size;
-                }
-            
+/*
+ * Stock an assembly and print the parts it needed (stock [@site] ID n)
+ *
+ * @param inventory_t* invp - the inventory
+ * @param int site - the number of the site stocked (and its sub-assemblies
+ *                   taken from)
+ * @param char* id - the ID of the assembly
+ * @param int amount - the amount to stock
+ */
+void stock_request(inventory_t* invp, int site, char* id, int amount) {
+
+    struct items_needed* parts = calloc(1, sizeof(struct items_needed));
+    STATS_COUNT(invp, allocations);
+    struct undo_log log = { NULL, 0, 0 };
+    struct order order = { NULL, NULL, &log, site };
+
+    //a quantity too large to count undoes the whole request
+    int fits = stock(invp, id, amount, &order);
+    if(flush_parts(invp, parts, fits)) {
+        commit(invp, &log, 0);
+        print_parts_needed(invp, parts, "-----------");
+        print_shortages(invp, parts, 1);
+    }
+    else {
+        rollback(invp, &log);
+    }
+    free(log.undo_array);
+
+    //free the parts needed list no longer in use
+    free_items_needed(parts);
+}
+
+/*
+ * Add stock of a part (stockPart ID n). From then on the parts requests
+ * need are taken out of its stock, and any shortfall is reported.
+ *
+ * @param inventory_t* invp - the inventory
+ * @param char* id - the ID of the part
+ * @param int amount - the amount to add
+ */
+void stock_part_request(inventory_t* invp, char* id, int amount) {
+
+    if(amount <= 0) {
+        fprintf(invp -> err, "!!! %d: illegal quantity for ID %s\n",
+        amount, id);
+    }
+    else if(valid_part_id(invp, id)) {
+        struct part* part = lookup_part(invp, id);
+        if(part == NULL) {
+            fprintf(invp -> err, "!!! %s: part ID is not in the inventory\n",
+            id);
+        }
+        else {
+            long long* stock = &(invp -> part_stock[part -> handle]);
+            if(*stock == PART_UNTRACKED) {
+                *stock = 0;
             }
-            //if the process was valid and 
-            //if any parts were neeed for this request 
-            if(valid && parts -> item_count > 0) {   
-                printf("Parts needed:\n");
-                printf("-------------\n");
-                print_items_needed(parts);
+            if(__builtin_add_overflow(*stock, amount, stock)) {
+                fprintf(invp -> err, "!!! %s: quantity too large\n", id);
+                *stock = LLONG_MAX;
             }
+        }
+    }
+}
+
+/*
+ * Restock one assembly, or every assembly, and print the parts it needed
+ * (restock [--forecast] [ID])
+ *
+ * @param inventory_t* invp - the inventory
+ * @param char* id - the ID of the assembly, NULL to restock every assembly
+ * @param int forecast - 1: size builds from recent velocity, 0: fill the
+ *                       assemblies below half capacity to capacity
+ */
+void restock_request(inventory_t* invp, char* id, int forecast) {
+
+    struct items_needed* parts = calloc(1, sizeof(struct items_needed));
+    STATS_COUNT(invp, allocations);
+    struct undo_log log = { NULL, 0, 0 };
+    struct order order = { NULL, NULL, &log, 0 };
+
+    int fits = restock(invp, id, forecast, &order);
+    if(flush_parts(invp, parts, fits)) {
+        commit(invp, &log, 0);
+        print_parts_needed(invp, parts, "-------------");
+        print_shortages(invp, parts, 1);
+    }
+    else {
+        rollback(invp, &log);
+    }
+    free(log.undo_array);
+
+    //free the parts needed list no longer in use
+    free_items_needed(parts);
+}
+
+/*
+ * Set the amount of an assembly on hand to zero (empty ID)
+ *
+ * @param inventory_t* invp - the inventory
+ * @param char* id - the ID of the assembly
+ */
+void empty_request(inventory_t* invp, char* id) {
+    
+    if(id[0] != 'A') {
+        fprintf(invp -> err, "!!! %s: ID not an assembly\n", id); 
+        return;
+    }
+
+    struct assembly* assembly = lookup_assembly(invp, id);
+
+    if(assembly != NULL) {
+        PRESERVE(invp, assembly);
+        SET_ON_HAND(&(ON_HAND(invp, assembly)[0]), 0);
+    }
+    else {
+        fprintf(invp -> err,
+        "!!! %s: assembly ID is not in the inventory\n", id);
+    }
+}
+
+/*
+ * Print every assembly with its stock added up across all sites
+ * (inventory --all-sites)
+ *
+ * @param inventory_t* invp - the inventory
+ */
+void all_sites_request(inventory_t* invp) {
+    print_all_sites(invp);
+}
+
+/*
+ * Print every assembly, or one assembly and what it is made from
+ * (inventory [ID])
+ *
+ * @param inventory_t* invp - the inventory
+ * @param char* id - the ID of the assembly, NULL to print every assembly
+ */
+void inventory_request(inventory_t* invp, char* id) {
+    
+    if(id == NULL) {
+        print_inventory(invp);
+    }
+    else if(valid_assembly_id(invp, id)) {
         
-        } 
+        struct assembly* assembly = lookup_assembly(invp, id);
         
-        free_items_needed(parts);
-        return 1;
+        if(assembly != NULL) {
+            fprintf(invp -> out, "Assembly ID:\t%s\n",
+            ASSEMBLY_ID(invp, assembly));
+            fprintf(invp -> out, "bin capacity:\t%lld\n",
+            assembly -> capacity);
+            long long on_hand = STOCK_AT(invp, assembly, 0);
+            fprintf(invp -> out, "on hand:\t%lld\n", on_hand);
+            fprintf(invp -> out, "Parts list:\n");
+            fprintf(invp -> out, "-----------\n");
+            report(invp, RECORD_ASSEMBLY, ASSEMBLY_ID(invp, assembly),
+            assembly -> capacity, on_hand);
+            items_needed_t* items = bom_items(invp, assembly);
+            print_item_table(invp, items, "Part ID", "NO PARTS",
+            RECORD_COMPONENT);
+            free_items_needed(items);
+        }
+        else {
+            fprintf(invp -> err,
+            "!!! %s: part/assembly ID is not in the inventory\n", id);
+        }
+    }
+}
+
+/*
+ * Print the list of requests (help)
+ *
+ * @param inventory_t* invp - the inventory whose output stream is used
+ */
+void help_request(inventory_t* invp) {
+
+    fprintf(invp -> out, "Requests:\n");
+    fprintf(invp -> out, "\taddPart\n");
+    fprintf(invp -> out, "\taddAssembly ID capacity [x1 n1 [x2 n2 ...]]\n");
+    fprintf(invp -> out, "\tfulfillOrder [@site] [x1 n1 [x2 n2 ...]]\n");
+    fprintf(invp -> out, "\tquote [x1 n1 [x2 n2 ...]]\n");
+    fprintf(invp -> out, "\tstock [@site] ID n\n");
+    fprintf(invp -> out, "\tstockPart ID n\n");
+    fprintf(invp -> out, "\trestock [--forecast] [ID]\n");
+    fprintf(invp -> out, "\tempty ID\n");
+    fprintf(invp -> out, "\tinventory [ID | --all-sites]\n");
+    fprintf(invp -> out, "\tparts [prefix]\n");
+    fprintf(invp -> out, "\thelp\n");
+    fprintf(invp -> out, "\tclear\n");
+    fprintf(invp -> out, "\tquit\n");
+    fprintf(invp -> out, "\tstats [filename [n]]\n");
+    fprintf(invp -> out, "\tmemstats\n");
+}
+
+/*
+ * Print the command of a request and its arguments
+ *
+ * @param inventory_t* invp - the inventory the request is made on
+ * @param char* name - the name of the command
+ * @param char* array[] - the array containing the command and its arguments
+ * @param int size - the size of the array
+ */
+static void print_request(inventory_t* invp, char* name, char* array[],
+                          int size) {
 
+    fprintf(invp -> out, "+ %s ", name);
+    int i;
+    for(i = 1; i < size; i++) {
+        fprintf(invp -> out, "%s ", array[i]);
     }
-    //******************************************************************STOCK
-    else if(strncmp(command, "stock", strlen(command)) == 0) {
+    fprintf(invp -> out, "\n");
+}
+
+/*
+ * Split the ID/quantity pairs of a request into separate arrays. Each
+ * quantity is converted only once, and a missing last quantity counts as 0.
+ *
+ * @param char* array[] - the array containing the command and its arguments
+ * @param int size - the size of the array
+ * @param int first - the index of the first pair
+ * @param char* ids[] - filled with the ID of each pair
+ * @param int amounts[] - filled with the quantity of each pair
+ * @param char* amount_text[] - filled with each quantity as it was given
+ *
+ * @return int - the number of pairs
+ */
+static int split_pairs(char* array[], int size, int first, char* ids[],
+                       int amounts[], char* amount_text[]) {
+    
+    int count = 0;
+    int i;
+    for(i = first; i < size; i += 2) {
+        ids[count] = array[i];
+        amount_text[count] = argument(array, size, i + 1);
+        amounts[count] = parse_number(amount_text[count]);
+        count++;
+    }
+    return count;
+}
 
-        printf("+ stock %s %s\n", array[1], array[2]);
+/*
+ * Direct requests to the proper functions based on their command
+ *
+ * @param inventory_t* invp - the inventory the request is carried out on
+ * @param int code - the REQUEST_ code of the command
+ * @param char* array[] - the array containing the command and its arguments
+ * @param int size - the size of the array
+ *
+ * @return int - 0: if command was 'quit', halts processing
+ *               1: all other cases
+ */
+static int dispatch_request(inventory_t* invp, int code, char* array[],
+                            int size) {
 
-        struct items_needed* parts = calloc(1, sizeof(struct items_needed));
+    char* command = array[0];
 
-        if(size >= 3) {
-            
-            stock(inventory, array[1], strtol(array[2], NULL, 10), parts);
-            
-            //check if any parts were neeed for this request
-            if(parts -> item_count > 0) {
-                printf("Parts needed:\n");
-                printf("-----------\n");
-                print_items_needed(parts);
-            }
-            //free the parts needed list no longer in use
-            free_items_needed(parts);
+    //ID/quantity pairs of addAssembly, fulfillOrder and quote
+    char* ids[MAX_LENGTH / 2];
+    int amounts[MAX_LENGTH / 2];
+    char* amount_text[MAX_LENGTH / 2];
+    int count;
+    int at;      // 1 if the request names a site ('@site'), 0 if not
+    int site;
+    
+    switch(code) {
+
+    //***************************************************************ADD PART 
+    case REQUEST_ADD_PART:
+        fprintf(invp -> out, "+ addPart %s\n", argument(array, size, 1));
+        add_part_request(invp, argument(array, size, 1));
+        return 1;
+
+    //***********************************************************ADD ASSEMBLY 
+    case REQUEST_ADD_ASSEMBLY:
+        print_request(invp, "addAssembly", array, size);
+
+        //array[0] = addAssembly
+        //array[1] = assembly ID
+        //array[2] = capacity
+        //array[3...] = items needed (a last ID without a quantity is ignored)
+        count = split_pairs(array, size - ((size - 3) % 2 != 0), 3,
+        ids, amounts, amount_text);
+        add_assembly_request(invp, argument(array, size, 1),
+        parse_number(argument(array, size, 2)), count, ids, amounts,
+        amount_text);
+        return 1;
+
+    //**********************************************************FULFILL ORDER 
+    case REQUEST_FULFILL_ORDER:
+        print_request(invp, "fulfillOrder", array, size);
+
+        //array[0] = fulfillOrder
+        //array[1] = @site (optional)
+        //array[1] = assembly1
+        //array[2] = amount1
+        //array[n] = assemblyn
+        //array[n+1] = amountn
+        at = (size > 1 && array[1][0] == '@');
+        site = at ? lookup_site(invp, array[1] + 1) : 0;
+        count = (size >= 3 + at) ? 
+        split_pairs(array, size, 1 + at, ids, amounts, amount_text) : 0;
+        if(site >= 0) {
+            fulfill_order_request(invp, site, count, ids, amounts);
+        }
+        return 1;
 
-            return 1;
+    //******************************************************************STOCK
+    case REQUEST_STOCK:
+        at = (size > 1 && array[1][0] == '@');
+        if(at) {
+            fprintf(invp -> out, "+ stock %s %s %s\n", array[1],
+            argument(array, size, 2), argument(array, size, 3));
+        }
+        else {
+            fprintf(invp -> out, "+ stock %s %s\n", argument(array, size, 1),
+            argument(array, size, 2));
         }
 
+        if(size >= 3 + at) {
+            site = at ? lookup_site(invp, array[1] + 1) : 0;
+            if(site >= 0) {
+                stock_request(invp, site, array[1 + at],
+                parse_number(array[2 + at]));
+            }
+        }
         return 1;
 
-    }        
     //****************************************************************RESTOCK
-    else if(strncmp(command, "restock", strlen(command)) == 0) {
-
-        struct items_needed* parts = calloc(1, sizeof(struct items_needed));
-        
+    case REQUEST_RESTOCK:
+        //'--forecast' sizes the builds from recent velocity
+        if(size > 1 && strcmp(array[1], "--forecast") == 0) {
+            if(size == 3) {
+                fprintf(invp -> out, "+ restock --forecast %s\n", array[2]);
+                restock_request(invp, array[2], 1);
+            }
+            else if(size == 2) {
+                fprintf(invp -> out, "+ restock --forecast\n");
+                restock_request(invp, NULL, 1);
+            }
+        }
         //if an assembly ID was given
-        if(size == 2) {
-            printf("+ restock %s\n", array[1]);
-            restock(inventory, array[1], parts);
+        else if(size == 2) {
+            fprintf(invp -> out, "+ restock %s\n", array[1]);
+            restock_request(invp, array[1], 0);
         }
         //no assembly ID was given
         else if(size == 1) {
-            printf("+ restock\n");
-            restock(inventory, NULL, parts);
-        }
-        //incorrect number of arguments
-        else {
-            free_items_needed(parts);
-            return 1;
-        }
-            
-        //check if any parts were neeed for this request
-        if(parts -> item_count > 0) {
-            printf("Parts needed:\n");
-            printf("-------------\n");
-            print_items_needed(parts);
+            fprintf(invp -> out, "+ restock\n");
+            restock_request(invp, NULL, 0);
         }
-        //free the parts needed list no longer in use
-        free_items_needed(parts);
-
+        //incorrect number of arguments are ignored
         return 1;
-    
-    }    
-    //******************************************************************EMPTY
-    else if(strncmp(command, "empty", strlen(command)) == 0) {
-        
-        printf("+ empty %s\n", array[1]);
-        
-        if(array[1][0] != 'A') {
-            fprintf(stderr, "!!! %s: ID not an assembly\n",
-            array[1]); 
-            return 1;
-        }
-
-        struct assembly* assembly = lookup_assembly(
-        inventory -> assembly_list, array[1]);
 
-        if(assembly != NULL) {
-            assembly -> on_hand = 0;
-            return 1;
-        }
-        else {
-            fprintf(stderr, "!!! %s: assembly ID is not in the inventory\n",
-            array[1]);
-        }
-        
+    //******************************************************************EMPTY
+    case REQUEST_EMPTY:
+        fprintf(invp -> out, "+ empty %s\n", argument(array, size, 1));
+        empty_request(invp, argument(array, size, 1));
         return 1;
-    }
+
     //**************************************************************INVENTORY
-    else if(strncmp(command, "inventory", strlen(command)) == 0) {
+    case REQUEST_INVENTORY:
         //if no id argument was given
         if(size == 1) {
-            printf("+ inventory\n");
-            print_inventory(inventory);
+            fprintf(invp -> out, "+ inventory\n");
+            inventory_request(invp, NULL);
+        }
+        //stock added up across every site
+        else if(strcmp(array[1], "--all-sites") == 0) {
+            fprintf(invp -> out, "+ inventory --all-sites\n");
+            all_sites_request(invp);
         }
         //id argument was given
         else {
-            printf("+ inventory %s\n", array[1]);
-            if(valid_assembly_id(array[1])) {
-                
-                struct assembly* assembly = lookup_assembly(
-                inventory -> assembly_list, array[1]);
-                
-                if(assembly != NULL) {
-                    printf("Assembly ID:\t%s\n", assembly -> id);
-                    printf("bin capacity:\t%d\n", assembly -> capacity);
-                    printf("on hand:\t%d\n", assembly -> on_hand);
-                    printf("Parts list:\n");
-                    printf("-----------\n");
-                    print_items_needed(assembly -> items);
-                }
-                else {
-                    fprintf(stderr, "!!! %s: part/assembly ID is not in the inventory\n",
-                    array[1]);
-                    return 1;
-                }
-            }
-            else {
-                return 1;
-            }
+            fprintf(invp -> out, "+ inventory %s\n", array[1]);
+            inventory_request(invp, array[1]);
         }
         return 1;
-    }
+
     //******************************************************************PARTS 
-    else if(strncmp(command, "parts", strlen(command)) == 0) {
-        printf("+ parts\n");
-        print_parts(inventory);
+    case REQUEST_PARTS:
+        //a prefix lists only the parts whose IDs start with it
+        if(size > 1) {
+            fprintf(invp -> out, "+ parts %s\n", array[1]);
+            parts_request(invp, array[1]);
+        }
+        else {
+            fprintf(invp -> out, "+ parts\n");
+            print_parts(invp);
+        }
         return 1;
-    }
+
     //*******************************************************************HELP
-    else if(strncmp(command, "help", strlen(command)) == 0) {
-        printf("+ help\n");
-
-        printf("Requests:\n");
-        printf("\taddPart\n");
-        printf("\taddAssembly ID capacity [x1 n1 [x2 n2 ...]]\n");
-        printf("\tfulfillOrder [x1 n1 [x2 n2 ...]]\n");
-        printf("\tstock ID n\n");
-        printf("\trestock [ID]\n");
-        printf("\tempty ID\n");
-        printf("\tinventory [ID]\n");
-        printf("\tparts\n");
-        printf("\thelp\n");
-        printf("\tclear\n");
-        printf("\tquit\n");
-        
+    case REQUEST_HELP:
+        fprintf(invp -> out, "+ help\n");
+        help_request(invp);
         return 1;
-    }
+
     //******************************************************************CLEAR
-    else if(strncmp(command, "clear", strlen(command)) == 0) {
-        printf("+ clear\n");
-        
-        free_inventory(inventory);
-        inventory = malloc(sizeof(inventory_t));
-        inventory -> part_list = NULL;
-        inventory -> part_count = 0;
-        inventory -> assembly_list = NULL;
-        inventory -> assembly_count = 0;
-        
+    case REQUEST_CLEAR:
+        fprintf(invp -> out, "+ clear\n");
+        clear_inventory(invp);
         return 1;
-    }
+
     //*******************************************************************QUIT
-    else if(strncmp(command, "quit", strlen(command)) == 0) {
-        printf("+ quit\n");
+    case REQUEST_QUIT:
+        fprintf(invp -> out, "+ quit\n");
         return 0;
-    }
+
+    //******************************************************************QUOTE
+    case REQUEST_QUOTE:
+        print_request(invp, "quote", array, size);
+
+        count = (size >= 3) ? 
+        split_pairs(array, size, 1, ids, amounts, amount_text) : 0;
+        quote_request(invp, count, ids, amounts);
+        return 1;
+
+    //******************************************************************STATS
+    case REQUEST_STATS:
+        print_request(invp, "stats", array, size);
+
+        //with a file name, dump to that file every so many requests
+        if(size == 1) {
+            print_stats(invp, invp -> out);
+        }
+        else {
+            stats_dump_to(invp, array[1], 
+            parse_number(argument(array, size, 2)));
+        }
+        return 1;
+
+    //**************************************************************STOCKPART
+    case REQUEST_STOCK_PART:
+        fprintf(invp -> out, "+ stockPart %s %s\n", argument(array, size, 1),
+        argument(array, size, 2));
+
+        if(size >= 3) {
+            stock_part_request(invp, array[1], parse_number(array[2]));
+        }
+        return 1;
+
+    //***************************************************************MEMSTATS
+    case REQUEST_MEMSTATS:
+        fprintf(invp -> out, "+ memstats\n");
+        memstats_request(invp);
+        return 1;
+
     //****************************************************************UNKNOWN
-    else {
-        printf("+ %s\n", command);
-        fprintf(stderr, "!!! %s: unknown command\n", command);
+    default:
+        fprintf(invp -> out, "+ %s\n", command);
+        fprintf(invp -> err, "!!! %s: unknown command\n", command);
         return 1;
     }
 
 }
 
-/* - - - FREES - - -*/
+/*
+ * Carry out a tokenized request (timed when statistics are compiled in)
+ *
+ * @param inventory_t* invp - the inventory the request is carried out on
+ * @param char* array[] - the array containing the command and its arguments
+ * @param int size - the size of the array
+ *
+ * @return int - 0: if command was 'quit', halts processing
+ *               1: all other cases
+ */
+int process_request(inventory_t* invp, char* array[], int size) {
+
+    STATS_START(start);
+    int code = lookup_command(array[0]);
+    int request_return = dispatch_request(invp, code, array, size);
+    STATS_STOP(invp, code, start);
+
+    //an inventory kept in a store is written out every so often
+    if(invp -> store != NULL
+       && ++invp -> store -> requests >= STORE_CHECKPOINT) {
+        checkpoint_inventory(invp);
+    }
+
+    return request_return;
+}
 
 /*
- * Properly delete an items_needed list
+ * Carry out a report request (see REPORT_REQUEST) on a snapshot, as it
+ * would have printed when the snapshot was taken. This can be done on any
+ * thread, while the inventory carries on with other requests.
  *
- * @param items_needed_t* items - the list to be deleted from memory
+ * @param snapshot_t* snapshot - the snapshot
+ * @param FILE* out - the stream output is printed to
+ * @param FILE* err - the stream errors are printed to
+ * @param char* array[] - the array containing the command and its arguments
+ * @param int size - the size of the array
+ *
+ * @return int - 1: the request was carried out, 0: it is not a report
  */
-static void free_items_needed(items_needed_t* items) {
-    //free the parts needed list no longer in use
-    struct item* temp_item = items -> item_list;
-    while(temp_item != NULL) {
-        //"save" the next item for deletion before deleting the previous
-        struct item* temp_item_2 = temp_item;
-        temp_item = temp_item -> next;
-        free(temp_item_2);
+int snapshot_request(snapshot_t* snapshot, FILE* out, FILE* err,
+                     char* array[], int size) {
+
+    int code = lookup_command(array[0]);
+    if(!REPORT_REQUEST(code)) {
+        return 0;
     }
-    free(items);
+    set_output(&(snapshot -> view), out, err);
+    return dispatch_request(&(snapshot -> view), code, array, size);
 }
 
+/* - - - BATCH - - -*/
+
 /*
- * Properly delete the entire inventory
+ * Find a row of a batch
  *
- * @param inventory_t* invp - the inventory to be deleted from memory
+ * @param batch_t* batch - the batch
+ * @param int row - the number of the row
+ *
+ * @return long long* - its first value
  */
-void free_inventory(inventory_t* invp) {
-    
-    //free the parts list
-    struct part* temp_part = invp -> part_list;
+static long long* batch_row(batch_t* batch, int row) {
+    return batch -> values + (long)row * batch -> columns;
+}
 
-    //loop through the part_list if it is not empty
-    while(temp_part != NULL) {
-        //"save" the next item for deletion before deleting the previous
-        struct part* temp_part_2 = temp_part;
-        temp_part = temp_part -> next;
-        free(temp_part_2);
+/*
+ * Find the row of units of an assembly needed by each order of a batch,
+ * adding it (and its row of units made) and queueing the assembly to be
+ * expanded if it is not needed yet
+ *
+ * @param inventory_t* invp - the inventory holding the assembly
+ * @param batch_t* batch - the batch
+ * @param int handle - the handle of the assembly
+ *
+ * @return long long* - the row
+ */
+static long long* demand_row(inventory_t* invp, batch_t* batch, int handle) {
+
+    if(batch -> demand_row[handle] < 0) {
+        batch -> demand_row[handle] = batch -> row_count;
+        batch -> row_count += 2;
+        memset(batch_row(batch, batch -> demand_row[handle]), 0,
+        2 * batch -> columns * sizeof(long long));
+        queue_demand(invp, handle);
     }
+    return batch_row(batch, batch -> demand_row[handle]);
+}
 
-    //free the assemblylist
-    struct assembly* temp_assembly = invp -> assembly_list;
+/*
+ * Find the row of units of a part needed by each order of a batch, adding
+ * it if the part is not needed yet
+ *
+ * @param batch_t* batch - the batch
+ * @param int handle - the handle of the part
+ *
+ * @return long long* - the row
+ */
+static long long* part_row(batch_t* batch, int handle) {
 
-    //loop through the assembly_list if it is not empty
-    while(temp_assembly != NULL) {
-        
-        //free this assembly's items needed list
-        free_items_needed(temp_assembly -> items);
+    if(batch -> part_row[handle] < 0) {
+        batch -> part_row[handle] = batch -> row_count++;
+        batch -> parts[batch -> part_count++] = handle;
+        memset(batch_row(batch, batch -> part_row[handle]), 0,
+        batch -> columns * sizeof(long long));
+    }
+    return batch_row(batch, batch -> part_row[handle]);
+}
 
-        //continue to free the current assembly
-        //"save" the next item for deletion before deleting the previous
-        struct assembly* temp_assembly_2 = temp_assembly;
-        temp_assembly = temp_assembly -> next;
-        free(temp_assembly_2);
+/*
+ * Add a multiple of one row to another, across every order of a batch. The
+ * rows are side by side and the loop has no branches, so the compiler can
+ * do several orders per instruction.
+ *
+ * @param long long* row - the row added to
+ * @param long long* made - the row added (times 'quantity')
+ * @param long long quantity - the multiple, no more than BATCH_LIMIT over
+ *                             the largest value of 'made'
+ * @param int columns - the number of orders
+ *
+ * @return int - 1: every value is still within BATCH_LIMIT, 0: it is not
+ */
+static int add_scaled(long long* restrict row,
+                      const long long* restrict made,
+                      long long quantity, int columns) {
+
+    long long most = 0;
+    int k;
+    for(k = 0; k < columns; k++) {
+        row[k] += quantity * made[k];
+        most = (row[k] > most) ? row[k] : most;
     }
+    return most <= BATCH_LIMIT;
+}
 
-    free(invp);
+/*
+ * Expand the orders of a batch down the BOM graph together. Assemblies
+ * come off the queue after everything made from them (see propagate), so
+ * when an assembly is expanded its row holds every order's total need of
+ * it. Stock is taken from it in order sequence, each order at its own site,
+ * which leaves the same on hand as filling the orders one after another,
+ * and then each of its BOM entries is read once and applied to the units
+ * made for every order.
+ *
+ * @param inventory_t* invp - the inventory holding the assemblies
+ * @param batch_t* batch - the batch, with the orders' lines in its rows
+ * @param order_t* order - logs the 'on_hand' values changed
+ *
+ * @return int - 1: done, 0: a value went over BATCH_LIMIT
+ */
+static int expand_batch(inventory_t* invp, batch_t* batch, order_t* order) {
+
+    int fits = 1;
+    int columns = batch -> columns;
+
+    while(invp -> demand_count > 0) {
+        int handle = next_demand(invp);
+        //after a failure the queue is only emptied
+        if(!fits) {
+            continue;
+        }
+        STATS_COUNT(invp, make_calls);
+
+        assembly_t* assembly = &(invp -> assembly_table[handle]);
+        long long* demand = batch_row(batch, batch -> demand_row[handle]);
+        long long* made = demand + columns;
+        long long most = 0;
+        int low = columns;
+        int high = 0;
+        batch -> expanded[batch -> expanded_count++] = handle;
+
+        int k;
+        for(k = 0; k < columns; k++) {
+            if(demand[k] > 0) {
+                order -> site = batch -> sites[k];
+                long long* on_hand = lookup_on_hand(invp, assembly, order);
+                if(demand[k] >= *on_hand) {
+                    made[k] = demand[k] - *on_hand;
+                    SET_ON_HAND(on_hand, 0);
+                }
+                else {
+                    SET_ON_HAND(on_hand, *on_hand - demand[k]);
+                }
+                if(made[k] > 0) {
+                    low = (k < low) ? k : low;
+                    high = k + 1;
+                    most = (made[k] > most) ? made[k] : most;
+                }
+            }
+        }
+        if(most == 0) {
+            continue;
+        }
+
+        int entry = assembly -> bom_first;
+        int end = entry + assembly -> bom_length;
+        for(; entry < end && fits; entry++) {
+            int child = invp -> bom_child[entry];
+            long long quantity = invp -> bom_quantity[entry];
+            long long* row = (child >= 0) ? part_row(batch, child)
+            : demand_row(invp, batch, BOM_ASSEMBLY(child));
+            //only the orders from the first to the last making any
+            fits = (quantity <= BATCH_LIMIT / most)
+            && add_scaled(row + low, made + low, quantity, high - low);
+        }
+    }
+    return fits;
+}
+
+/*
+ * Add the units each order of a batch used up to the velocities, order by
+ * order, as committing the orders one after another would have
+ *
+ * @param inventory_t* invp - the inventory the batch was filled from
+ * @param batch_t* batch - the batch
+ */
+static void batch_velocity(inventory_t* invp, batch_t* batch) {
+
+    int i, k;
+    for(i = 0; i < batch -> expanded_count; i++) {
+        int handle = batch -> expanded[i];
+        assembly_t* assembly = &(invp -> assembly_table[handle]);
+        long long* demand = batch_row(batch, batch -> demand_row[handle]);
+        for(k = 0; k < batch -> columns; k++) {
+            if(demand[k] > 0) {
+                unsigned long clock = invp -> order_count + k + 1;
+                if(assembly -> velocity_order != clock) {
+                    assembly -> velocity *= decay(clock
+                    - assembly -> velocity_order);
+                    assembly -> velocity_order = clock;
+                }
+                assembly -> velocity += FORECAST_ALPHA * demand[k];
+            }
+        }
+    }
+    invp -> order_count += batch -> columns;
 }
 
-/* - - - MAIN - - -*/
+/*
+ * Sort what a batch made and needed by order. The rows are walked once
+ * each, in the order they were expanded, so each order's list of what it
+ * made comes out in that order too.
+ *
+ * @param inventory_t* invp - the inventory the batch was filled from
+ * @param batch_t* batch - the batch
+ * @param int offsets[] - set to where each order's makes start in
+ *                        'handles' (one more than the number of orders)
+ * @param int handles[] - set to the assemblies each order made (room for
+ *                        one per expanded assembly per order)
+ * @param items_needed_t* parts[] - the parts lists of the orders, added to
+ */
+static void collect_batch(inventory_t* invp, batch_t* batch, int offsets[],
+                          int handles[], items_needed_t* parts[]) {
+
+    int columns = batch -> columns;
+    int i, k;
+    memset(offsets, 0, (columns + 1) * sizeof(int));
+    for(i = 0; i < batch -> expanded_count; i++) {
+        long long* made = batch_row(batch,
+        batch -> demand_row[batch -> expanded[i]] + 1);
+        for(k = 0; k < columns; k++) {
+            offsets[k + 1] += (made[k] > 0);
+        }
+    }
+    for(k = 0; k < columns; k++) {
+        offsets[k + 1] += offsets[k];
+    }
+
+    //the offsets are moved along while filling, and then back
+    for(i = 0; i < batch -> expanded_count; i++) {
+        int handle = batch -> expanded[i];
+        long long* made = batch_row(batch, batch -> demand_row[handle] + 1);
+        for(k = 0; k < columns; k++) {
+            if(made[k] > 0) {
+                handles[offsets[k]++] = handle;
+            }
+        }
+    }
+    for(k = columns; k > 0; k--) {
+        offsets[k] = offsets[k - 1];
+    }
+    offsets[0] = 0;
+
+    //each part has one row, so no list has it yet
+    for(i = 0; i < batch -> part_count; i++) {
+        int handle = batch -> parts[i];
+        long long* needed = batch_row(batch, batch -> part_row[handle]);
+        for(k = 0; k < columns; k++) {
+            if(needed[k] > 0) {
+                push_needed(invp, parts[k], invp -> part_ids[handle],
+                handle, needed[k]);
+            }
+        }
+    }
+}
 
 /*
- * Main function primarily handles the allocation of the inventory 
- * struct and interpreting request lines from a file or stdin.
+ * Print what one order of a batch made and the parts it needed, and take
+ * the parts out of part stock
  *
- * @param int argc - the amount of arguments given
- * @param char* argv[] - the arguments given
+ * @param inventory_t* invp - the inventory the batch was filled from
+ * @param batch_t* batch - the batch
+ * @param int column - the order's column
+ * @param int handles[] - the assemblies the order made, in order
+ * @param int count - the number of assemblies it made
+ * @param items_needed_t* parts - the parts it needed
+ */
+static void print_batch_order(inventory_t* invp, batch_t* batch, int column,
+                              int handles[], int count,
+                              items_needed_t* parts) {
+
+    int i;
+    for(i = 0; i < count; i++) {
+        long long made = batch_row(batch,
+        batch -> demand_row[handles[i]] + 1)[column];
+        char* id = invp -> assembly_ids[handles[i]];
+        fprintf(invp -> out, ">>> make %lld units of assembly %s\n", made, id);
+        report(invp, RECORD_MADE, id, made, 0);
+    }
+    print_parts_needed(invp, parts, "-------------");
+    print_shortages(invp, parts, 1);
+}
+
+/*
+ * Fill a run of fulfillOrder requests together. The orders that go through
+ * become the columns of a batch and are expanded down the BOM graph at once
+ * (see expand_batch), and the rest only report their first bad line. If a
+ * quantity gets too large to batch, the orders are instead filled one at a
+ * time, which reports it as usual.
  *
- * @return int - EXIT_FAILURE: the input file could not be read, 
- *                             or there was an incorrect number of
- *                             command line arguments
- *               EXIT_SUCCESS: the program executed successfully
+ * @param inventory_t* invp - the inventory
+ * @param char** requests[] - the tokenized requests
+ * @param int sizes[] - the number of tokens of each request
+ * @param int count - the number of requests
+ * @param char* ids[] - the assembly ID of every order line
+ * @param int amounts[] - the amount of every order line
+ * @param int first[] - where each request's lines start in 'ids'
+ * @param int lines[] - the number of lines of each request
+ * @param int sites[] - the site of each request (-1 if it has no site)
+ * @param int columns[] - 0 for each request that goes through, -1 for the
+ *                        rest (set to each request's column)
  */
-int main(int argc, char* argv[]) {
-    
-    //initialize inventory
-    inventory = malloc(sizeof(inventory_t));
-    inventory -> part_list = NULL;
-    inventory -> part_count = 0; 
-    inventory -> assembly_list = NULL;
-    inventory -> assembly_count = 0;
+static void fill_batch(inventory_t* invp, char** requests[], int sizes[],
+                       int count, char* ids[], int amounts[], int first[],
+                       int lines[], int sites[], int columns[]) {
+
+    if(count == 0) {
+        return;
+    }
+
+    batch_t batch;
+    memset(&batch, 0, sizeof(batch));
+    batch.sites = malloc(count * sizeof(int));
+    int i, line;
+    for(i = 0; i < count; i++) {
+        if(columns[i] >= 0) {
+            columns[i] = batch.columns;
+            batch.sites[batch.columns++] = sites[i];
+        }
+    }
 
-    FILE* fp;
+    //every assembly and part could need a row, and the rows are kept for
+    //the next batch so their pages are only faulted in once
+    size_t values = (size_t)(2 * invp -> assembly_count + invp -> part_count)
+    * (batch.columns + 1);
+    if(values > invp -> batch_size) {
+        free(invp -> batch_values);
+        invp -> batch_values = malloc(values * sizeof(long long));
+        invp -> batch_size = values;
+        STATS_COUNT(invp, allocations);
+    }
+    batch.values = invp -> batch_values;
+    batch.demand_row = malloc((invp -> assembly_count + 1) * sizeof(int));
+    batch.part_row = malloc((invp -> part_count + 1) * sizeof(int));
+    batch.expanded = malloc((invp -> assembly_count + 1) * sizeof(int));
+    batch.parts = malloc((invp -> part_count + 1) * sizeof(int));
+    STATS_ADD(invp, allocations, 5);
+    memset(batch.demand_row, -1, invp -> assembly_count * sizeof(int));
+    memset(batch.part_row, -1, invp -> part_count * sizeof(int));
 
-    if(argc == 1) {
-        fp = stdin;
+    for(i = 0; i < count; i++) {
+        for(line = first[i]; columns[i] >= 0 && line < first[i] + lines[i];
+            line++) {
+            int handle = lookup_assembly(invp, ids[line]) -> handle;
+            demand_row(invp, &batch, handle)[columns[i]] += amounts[line];
+        }
     }
-    else if(argc == 2) {
-        fp = fopen(argv[1], "r");
 
-        if(!fp) {
-            perror(argv[1]);
-            return EXIT_FAILURE;
+    struct undo_log log = { NULL, 0, 0 };
+    struct order order = { NULL, NULL, &log, 0 };
+    int fits = expand_batch(invp, &batch, &order);
+
+    if(!fits) {
+        //put everything back and fill the orders one at a time
+        rollback(invp, &log);
+        for(i = 0; i < count; i++) {
+            print_request(invp, "fulfillOrder", requests[i], sizes[i]);
+            if(sites[i] >= 0) {
+                fulfill_order_request(invp, sites[i], lines[i],
+                ids + first[i], amounts + first[i]);
+            }
         }
     }
     else {
-        fprintf(stderr, "Useage: ./inventory [filename]");
-        printf("\n");
-        return EXIT_FAILURE;
+        batch_velocity(invp, &batch);
+        int* offsets = malloc((batch.columns + 1) * sizeof(int));
+        int* handles = malloc(((size_t)batch.expanded_count * batch.columns
+        + 1) * sizeof(int));
+        items_needed_t** parts = malloc((batch.columns + 1)
+        * sizeof(items_needed_t*));
+        STATS_ADD(invp, allocations, 3 + batch.columns);
+        for(i = 0; i < batch.columns; i++) {
+            parts[i] = calloc(1, sizeof(struct items_needed));
+        }
+        collect_batch(invp, &batch, offsets, handles, parts);
+
+        for(i = 0; i < count; i++) {
+            print_request(invp, "fulfillOrder", requests[i], sizes[i]);
+            if(columns[i] >= 0) {
+                int column = columns[i];
+                print_batch_order(invp, &batch, column,
+                handles + offsets[column],
+                offsets[column + 1] - offsets[column], parts[column]);
+                free_items_needed(parts[column]);
+            }
+            //an order that does not go through reports its first bad line
+            else if(sites[i] >= 0) {
+                for(line = first[i]; line < first[i] + lines[i]
+                    && order_line(invp, ids[line], amounts[line]) != NULL;
+                    line++);
+            }
+        }
+        free(offsets);
+        free(handles);
+        free(parts);
     }
-    
-    //getline() variables 
-    char* buffer = (char*) malloc(sizeof(char) * MAX_LENGTH);
-    size_t n = MAX_LENGTH;
-    ssize_t num  = 0;
 
-    //strtok() variables
-    char* token;
-    int i = 0;
-    int request_return = 1;
-    char* request_array[MAX_LENGTH];
-    
-    //extracing commands from file/stdin
-    while(request_return && (num = getline(&buffer, &n, fp) != -1)) {
-
-        //make sure the line is not blank
-        if(strlen(trim(buffer)) != 0) {
-            //catch entire line comments
-            if(buffer[0] != '#') {
-                //tokenize the line into a char* array
-                token = strtok(buffer, " ");
-                while(token != NULL) {
-                    //if a comment is reached, eject from loop
-                    if(token[0] == '#') {
-                        token = NULL;
-                    }
-                    else {
-                        request_array[i] = token;
-                        token = strtok(NULL, " ");
-                        //printf("%s\n", request_array[i]);
-                        i++;
-                    }
-            
-                }
-                
-                request_return = process_request(request_array, i);
-                
-                //reset/re-fill request_array
-                i = 0;
-                request_array[0] = '\0';
+    free(log.undo_array);
+    free(batch.sites);
+    free(batch.demand_row);
+    free(batch.part_row);
+    free(batch.expanded);
+    free(batch.parts);
+}
+
+/*
+ * Carry out fulfillOrder requests together, as if one after another. The
+ * parts each order needs and the assemblies it makes come out the same,
+ * but each order lists every assembly it made once, with its total,
+ * instead of each make as it happened. An order canceled after its first
+ * line prints what that line made from the stock left by the orders
+ * before it, so it is filled on its own between the batches around it.
+ *
+ * @param inventory_t* invp - the inventory
+ * @param char** requests[] - the tokenized requests (each a fulfillOrder)
+ * @param int sizes[] - the number of tokens of each request
+ * @param int count - the number of requests (at most BATCH_MAX)
+ */
+void process_batch(inventory_t* invp, char** requests[], int sizes[],
+                   int count) {
+
+    //each request's site and order lines, as the dispatcher reads them
+    int total = 0;
+    int i, line;
+    for(i = 0; i < count; i++) {
+        total += sizes[i];
+    }
+    char** ids = malloc(total * sizeof(char*));
+    char** amount_text = malloc(total * sizeof(char*));
+    int* amounts = malloc(total * sizeof(int));
+    int* first = malloc(count * sizeof(int));
+    int* lines = malloc(count * sizeof(int));
+    int* sites = malloc(count * sizeof(int));
+    int* columns = malloc(count * sizeof(int));
+    STATS_ADD(invp, allocations, 7);
+
+    int next = 0;
+    int start = 0;
+    for(i = 0; i < count; i++) {
+        char** array = requests[i];
+        int at = (sizes[i] > 1 && array[1][0] == '@');
+        first[i] = next;
+        sites[i] = at ? lookup_site(invp, array[1] + 1) : 0;
+        lines[i] = (sizes[i] >= 3 + at) ? split_pairs(array, sizes[i], 1 + at,
+        ids + next, amounts + next, amount_text + next) : 0;
+        next += lines[i];
+
+        //only orders that will go through are filled in the batch
+        int made = 0;
+        int valid = (sites[i] >= 0 && lines[i] > 0);
+        for(line = first[i]; line < next && valid; line++) {
+            valid = amounts[line] > 0 && lookup_assembly(invp, ids[line]);
+            made += valid;
+        }
+        columns[i] = valid ? 0 : -1;
+
+        if(!valid && made > 0) {
+            fill_batch(invp, requests + start, sizes + start, i - start, ids,
+            amounts, first + start, lines + start, sites + start,
+            columns + start);
+            print_request(invp, "fulfillOrder", array, sizes[i]);
+            fulfill_order_request(invp, sites[i], lines[i], ids + first[i],
+            amounts + first[i]);
+            start = i + 1;
+        }
+    }
+    fill_batch(invp, requests + start, sizes + start, count - start, ids,
+    amounts, first + start, lines + start, sites + start, columns + start);
+
+    free(ids);
+    free(amount_text);
+    free(amounts);
+    free(first);
+    free(lines);
+    free(sites);
+    free(columns);
+}
+
+/* - - - MEMORY - - -*/
+
+/*
+ * Print a line of the memory report and add its bytes to the totals
+ *
+ * @param inventory_t* invp - the inventory whose output stream is used
+ * @param char* name - what the bytes hold
+ * @param long long count - how many of them there are
+ * @param size_t live - the bytes they take
+ * @param size_t allocated - the bytes allocated for them (room to grow
+ *                           included)
+ * @param size_t totals[] - the live and allocated bytes so far, added to
+ */
+static void print_memory_line(inventory_t* invp, char* name,
+                              long long count, size_t live,
+                              size_t allocated, size_t totals[]) {
+
+    fprintf(invp -> out, "%-15s %9lld %12zu %12zu\n", name, count, live,
+    allocated);
+    totals[0] += live;
+    totals[1] += allocated;
+}
 
-            }   
+/*
+ * Print the bytes each kind of structure of an inventory takes, both in
+ * use and allocated, and what that comes to per SKU (each part and each
+ * assembly is a SKU). The allocator's own overhead is not counted; in a
+ * store the catalog's bytes are those handed out in the file.
+ *
+ * @param inventory_t* invp - the inventory
+ */
+void memstats_request(inventory_t* invp) {
+
+    size_t totals[2] = { 0, 0 };
+    long long parts = invp -> part_count;
+    long long assemblies = invp -> assembly_count;
+    size_t part_size = invp -> part_size;
+    size_t assembly_size = invp -> assembly_size;
+    size_t work = sizeof(long long) + sizeof(int);
+    //a quote's copies of 'on_hand' are kept by assembly handle as well
+    size_t shadow = sizeof(long long) + sizeof(unsigned int);
+
+    fprintf(invp -> out, "Memory:\n");
+    fprintf(invp -> out, "-------\n");
+    fprintf(invp -> out, "%-15s %9s %12s %12s\n", "Structure", "count",
+    "live bytes", "allocated");
+    fprintf(invp -> out, "=============== ========= ============ "
+    "============\n");
+
+    print_memory_line(invp, "parts", parts, parts * sizeof(part_t),
+    part_size * sizeof(part_t), totals);
+    print_memory_line(invp, "part IDs", parts, parts * ID_SIZE,
+    part_size * ID_SIZE, totals);
+    print_memory_line(invp, "part stock", parts, parts * sizeof(long long),
+    part_size * sizeof(long long), totals);
+    print_memory_line(invp, "assemblies", assemblies,
+    assemblies * sizeof(assembly_t), assembly_size * sizeof(assembly_t),
+    totals);
+    print_memory_line(invp, "assembly IDs", assemblies, assemblies * ID_SIZE,
+    assembly_size * ID_SIZE, totals);
+    print_memory_line(invp, "on hand", assemblies * invp -> site_count,
+    assemblies * invp -> site_count * sizeof(long long),
+    assembly_size * invp -> site_size * sizeof(long long), totals);
+    print_memory_line(invp, "BOM entries", invp -> bom_count,
+    invp -> bom_count * (sizeof(int) + sizeof(long long)),
+    invp -> bom_size * (sizeof(int) + sizeof(long long)), totals);
+    print_memory_line(invp, "BOM rows", invp -> bom_row_count,
+    invp -> bom_row_count * sizeof(bom_row_t),
+    invp -> bom_row_size * sizeof(bom_row_t), totals);
+    //a store's spare index counts as allocated too
+    print_memory_line(invp, "BOM index", invp -> bom_index_size,
+    invp -> bom_index_size * sizeof(int),
+    (invp -> bom_index_size + invp -> bom_spare_size) * sizeof(int),
+    totals);
+    long long blocks = invp -> part_filter.blocks
+    + invp -> assembly_filter.blocks;
+    print_memory_line(invp, "ID filters", blocks,
+    blocks * FILTER_BLOCK_WORDS * sizeof(unsigned long long),
+    blocks * FILTER_BLOCK_WORDS * sizeof(unsigned long long), totals);
+    print_memory_line(invp, "sites", invp -> site_count,
+    invp -> site_count * sizeof(*(invp -> site_names)),
+    invp -> site_size * sizeof(*(invp -> site_names)), totals);
+    //the demand vectors and queues of the walks, a quote's copies, and the
+    //batch rows
+    print_memory_line(invp, "work arrays", parts + assemblies,
+    (parts + assemblies) * work + assemblies * shadow
+    + invp -> batch_size * sizeof(long long),
+    (part_size + assembly_size) * work + assembly_size * shadow
+    + invp -> batch_size * sizeof(long long), totals);
+    id_dict_t* dicts[2] = { &(invp -> part_dict), &(invp -> assembly_dict) };
+    size_t dict_live = 0;
+    size_t dict_allocated = 0;
+    int i;
+    for(i = 0; i < 2; i++) {
+        int blocks = (dicts[i] -> count + DICT_BLOCK_IDS - 1)
+        >> DICT_BLOCK_SHIFT;
+        dict_live += dicts[i] -> count * sizeof(int)
+        + blocks * (ID_SIZE + sizeof(int)) + dicts[i] -> byte_count;
+        //a store's spare arrays count as allocated too
+        struct dict_arrays* sets[2] = { &(dicts[i] -> arrays),
+                                        &(dicts[i] -> spare) };
+        int j;
+        for(j = 0; j < 2; j++) {
+            dict_allocated += sets[j] -> size * sizeof(int)
+            + (sets[j] -> size >> DICT_BLOCK_SHIFT)
+            * (ID_SIZE + sizeof(int)) + sets[j] -> byte_size;
         }
     }
-   
-    fclose(fp);
-    free_inventory(inventory);
-    free(buffer);
+    print_memory_line(invp, "ID dictionaries", invp -> part_dict.count
+    + invp -> assembly_dict.count, dict_live, dict_allocated, totals);
+    long long versions;
+    size_t bytes = versions_bytes(invp, &versions);
+    print_memory_line(invp, "snapshot pages", versions, bytes, bytes,
+    totals);
+
+    fprintf(invp -> out, "%-15s %9s %12zu %12zu\n", "total", "", totals[0],
+    totals[1]);
+    if(parts + assemblies > 0) {
+        fprintf(invp -> out, "%-15s %9lld %12.1f %12.1f\n", "bytes per SKU",
+        parts + assemblies, (double)totals[0] / (parts + assemblies),
+        (double)totals[1] / (parts + assemblies));
+    }
+}
 
-    return EXIT_SUCCESS;
+/* - - - FREES - - -*/
+
+/*
+ * Properly delete an items_needed list
+ *
+ * @param items_needed_t* items - the list to be deleted from memory
+ */
+static void free_items_needed(items_needed_t* items) {
+    //the items are all in the one array
+    free(items -> item_array);
+    free(items);
+}
+
+/*
+ * Properly delete an overlay left over from a quote. The stamps of the
+ * copies it touched are reset, so none is taken for the copy of a later
+ * overlay once the generations wrap.
+ *
+ * @param inventory_t* invp - the inventory the overlay's copies are kept in
+ * @param overlay_t* overlay - the overlay to be deleted from memory
+ */
+void free_overlay(inventory_t* invp, overlay_t* overlay) {
+    int i;
+    for(i = 0; i < overlay -> touched_count; i++) {
+        invp -> shadow_stamp[overlay -> touched[i]] = 0;
+    }
+    free(overlay -> touched);
+    free(overlay);
+}
 
+/*
+ * Delete every part and assembly, leaving the inventory empty (the arrays
+ * they were in are kept for the next ones)
+ *
+ * @param inventory_t* invp - the inventory to be cleared
+ */
+void clear_inventory(inventory_t* invp) {
+    
+    wait_snapshots(invp);
+    invp -> part_list = LIST_END;
+    invp -> part_count = 0;
+    invp -> assembly_list = LIST_END;
+    invp -> assembly_count = 0;
+    invp -> bom_count = 0;
+    invp -> bom_row_count = 0;
+    refill_bom_index(invp, 0);
+    invp -> order_count = 0;
+    invp -> site_count = 1;
+    refill_filter(invp, &(invp -> part_filter));
+    refill_filter(invp, &(invp -> assembly_filter));
+    //the dictionaries keep their arrays for the next IDs
+    invp -> part_dict.count = 0;
+    invp -> part_dict.byte_count = 0;
+    invp -> assembly_dict.count = 0;
+    invp -> assembly_dict.byte_count = 0;
 }
 
+/*
+ * Properly delete the entire inventory
+ *
+ * @param inventory_t* invp - the inventory to be deleted from memory
+ */
+void free_inventory(inventory_t* invp) {
+    free_versions(invp);
+    STATS_FREE(invp);
+    free(invp -> part_demand);
+    free(invp -> part_touched);
+    free(invp -> demand);
+    free(invp -> demand_heap);
+    free(invp -> shadow_on_hand);
+    free(invp -> shadow_stamp);
+    free(invp -> batch_values);
+    //the catalog stays in the store, as of one last checkpoint
+    if(invp -> store != NULL) {
+        checkpoint_inventory(invp);
+        store_close(invp -> store);
+    }
+    else {
+        free(invp -> site_names);
+        free(invp -> part_stock);
+        free(invp -> part_table);
+        free(invp -> assembly_table);
+        free(invp -> on_hand);
+        //rows shared by several assemblies are freed once, with the rest
+        free(invp -> bom_child);
+        free(invp -> bom_quantity);
+        free(invp -> bom_rows);
+        free(invp -> bom_index);
+        free(invp -> part_ids);
+        free(invp -> assembly_ids);
+        free(invp -> part_filter.words);
+        free(invp -> assembly_filter.words);
+        free(invp -> part_dict.arrays.firsts);
+        free(invp -> part_dict.arrays.offsets);
+        free(invp -> part_dict.arrays.bytes);
+        free(invp -> part_dict.arrays.handles);
+        free(invp -> assembly_dict.arrays.firsts);
+        free(invp -> assembly_dict.arrays.offsets);
+        free(invp -> assembly_dict.arrays.bytes);
+        free(invp -> assembly_dict.arrays.handles);
+    }
+    free(invp);
+}
@@ -3,7 +3,8 @@
  *
  * Description: Function and struct definitions for an inventory system of
  *              parts and assemblies which are composed of parts and
- *              sub-assemblies
+ *              sub-assemblies (the library's own header; programs using
+ *              the library include libinventory.h)
  *
  * @author: Frank Abbey (fra1489)
  * @version: 4/23/2020
@@ -11,47 +12,308 @@
 #ifndef INVENTORY_H
 #define INVENTORY_H
 
+#include <stdio.h>
+#include <limits.h>
+#include "libinventory.h"
+#include "ids.h"
+#include "stats.h"
+
 //format a given string
 extern char * trim(char *);
 //extern int getline(char **, size_t *, FILE *);
 
-//All IDs must not exceed 11 in length
-#define ID_MAX 11
+//the parts and the assemblies are each kept in an array by handle, and
+//their lists are linked by handle rather than by pointer, so the arrays
+//can be moved (or mapped from a store file anywhere) without changing them
+#define LIST_END -1 // 'next' of the last part or assembly of a list
+
+//Their IDs are not kept in the structs: each ID is kept once, in
+//'part_ids' or 'assembly_ids' by handle (ID_MAX characters, then NULs,
+//see ids.h), side by side so lookups can search them eight at a time.
+#define PART_ID(invp, part) ((invp) -> part_ids[(part) -> handle])
+#define ASSEMBLY_ID(invp, assembly) \
+    ((invp) -> assembly_ids[(assembly) -> handle])
+//the handle of the ID 'id' points at in 'part_ids' or 'assembly_ids'
+#define ID_HANDLE(ids, id) ((int)(((id) - (ids)[0]) / ID_SIZE))
 
-//struct to represent a part in the inventory
+//struct to represent a part in the inventory, 8 bytes
 struct part {
-    char id[ID_MAX+1];        // ID_MAX plus NUL
-    struct part * next; // the next part in the list of parts
+    int handle;               // index of the part's stock in 'part_stock'
+    int next;                 // handle of the next part in the list of parts
 };
 
-//struct to represent an assembly in the inventory
+//'part_stock' value of a part never given stock, which is made as needed
+#define PART_UNTRACKED -1
+
+//quantities are 64-bit: an order multiplies them level by level down an
+//assembly, and a product too large to count is an error (never wrapped)
+
+//demand forecasting: an assembly's velocity is an exponential moving
+//average of the units of it used up per order
+#define FORECAST_ALPHA 0.2  // weight of the newest order in the average
+#define FORECAST_ORDERS 10  // orders of demand a forecast restock covers
+
+//struct to represent an assembly in the inventory, 48 bytes
 struct assembly {
-    char id[ID_MAX+1];
-    int capacity;
-    int on_hand;
-    struct items_needed * items; // parts/sub-assemblies needed for this ID
-    struct assembly * next;      // the next assembly in the inventory list
+    long long capacity;
+    double velocity;              // units used up per order (averaged)
+    unsigned long velocity_order; // order count 'velocity' is aged to
+    long long pending;            // units used by the order in progress
+    int handle;                   // index of the assembly in its arrays
+    int next;                     // handle of the next assembly in the list
+    int bom_first;                // first BOM entry of its items
+    int bom_length;               // BOM entries of its items
+};
+
+//the part or assembly with a handle, NULL for LIST_END
+#define PART_AT(invp, handle) \
+    (((handle) == LIST_END) ? NULL : &((invp) -> part_table[handle]))
+#define ASSEMBLY_AT(invp, handle) \
+    (((handle) == LIST_END) ? NULL : &((invp) -> assembly_table[handle]))
+
+//the amount of an assembly on hand at each site, by site number (a row of
+//'site_size' values in the inventory's 'on_hand' array)
+#define ON_HAND(invp, assembly) \
+    ((invp) -> on_hand + (size_t)(assembly) -> handle * (invp) -> site_size)
+//change an 'on_hand' value. Snapshots read the values on other threads
+//while requests change them (see snapshot_on_hand), so each change is a
+//relaxed atomic store, made after preserve_page() has marked its page.
+#define SET_ON_HAND(pointer, value) \
+    __atomic_store_n((pointer), (value), __ATOMIC_RELAXED)
+
+//the BOM graph is kept as rows of entries of 'bom_child' and
+//'bom_quantity': the items of an assembly are the 'bom_length' entries from
+//'bom_first' on. A child is a part handle, or an assembly handle passed
+//through BOM_ASSEMBLY (which makes it negative, and is its own inverse).
+#define BOM_ASSEMBLY(handle) (-(handle) - 1)
+
+//Catalogs are full of assemblies made from the same items (the variants
+//of a product), so each row is interned: an assembly whose items are those
+//of an assembly added before it, in the same order, shares that
+//assembly's row, which is never changed once it is added.
+#define BOM_INDEX_LOAD 2 // rows to a slot of the index, at least
+
+//a distinct row of the BOM graph
+struct bom_row {
+    unsigned int hash;  // hash of its children and quantities
+    int first;          // its first entry
+    int length;         // its entries
 };
 
-//struct to represent an inventory item (a part or an assembly)
+//struct to represent an inventory item (a part or an assembly), 32 bytes
+//with the ID and quantity side by side in the first 24
 struct item {
-    char id[ID_MAX+1];           // ID_MAX plus NUL
-    int quantity;
-    struct item * next; // next item in the part/assembly list
+    char id[ID_SIZE] ID_ALIGNED; // ID_MAX, then NULs (see ids.h)
+    long long quantity;
+    int handle;                  // part handle (parts only, -1 otherwise)
+};
+
+//the IDs of the parts and of the assemblies are also kept in a Bloom
+//filter each, so a lookup of an ID that is in neither (a typo, a
+//discontinued item) is nearly always turned away without searching a list.
+//A filter is an array of blocks of one cache line, and an ID sets
+//FILTER_PROBES bits in the one block its hash picks.
+#define FILTER_BLOCK_WORDS 8     // 64-bit words to a block (512 bits)
+#define FILTER_PROBES 6          // bits an ID sets in its block
+#define FILTER_IDS_PER_BLOCK 32  // IDs a block holds before the filter grows
+
+//a Bloom filter of IDs (an ID it does not have is surely not in the list)
+struct id_filter {
+    unsigned long long * words; // FILTER_BLOCK_WORDS words to a block
+    int blocks;                 // a power of two, 0 before the first ID
+    int count;                  // IDs added
 };
 
-//the inventory struct (parts and assemblies)
+//Lookups of IDs that pass a filter, and the parts listing, go through a
+//sorted dictionary of the IDs, front coded: the IDs are in blocks of
+//DICT_BLOCK_IDS, the first ID of each block is kept whole so a binary
+//search finds an ID's block, and each ID after it is kept as the length of
+//the prefix it shares with the ID before it (one nibble), the length of
+//the rest (the other nibble), and the rest. The dictionary holds the IDs
+//of the handles below its 'count'. Those added since are searched one by
+//one, until there are enough of them that they are merged in and the
+//dictionary is laid out again, which only a change to the catalog does
+//(so a snapshot reads the dictionary as it was). The fuzz harness makes
+//the blocks and the tail smaller, so its few IDs exercise both.
+#ifndef DICT_BLOCK_SHIFT
+#define DICT_BLOCK_SHIFT 4 // log2 of the IDs to a block
+#endif
+#define DICT_BLOCK_IDS (1 << DICT_BLOCK_SHIFT)
+#ifndef DICT_TAIL_MIN
+#define DICT_TAIL_MIN 64   // IDs past the dictionary before it is rebuilt,
+#endif
+#define DICT_TAIL_SHARE 64 // plus one for each this many IDs in it
+#if ID_MAX > 15
+#error "the lengths of a front-coded ID are a nibble each"
+#endif
+
+//the arrays a dictionary is laid out in
+struct dict_arrays {
+    char (* firsts)[ID_SIZE];   // the first ID of each block
+    int * offsets;              // where each block's other IDs are in 'bytes'
+    unsigned char * bytes;      // the other IDs, front coded
+    int * handles;              // the handle of each ID, in ID order
+    int size;                   // IDs the arrays can hold
+    int byte_size;              // bytes 'bytes' can hold
+};
+
+//a front-coded sorted dictionary of IDs. In a store, the arrays the last
+//checkpoint points at are never written over, since a store opened after
+//a crash reads them with the checkpoint's counts: the next layout goes
+//into the spare arrays and the two swap. The spare arrays are not in the
+//header, so a store that is reopened starts a new spare.
+struct id_dict {
+    struct dict_arrays arrays;  // the arrays it is in
+    struct dict_arrays spare;   // the arrays it was in before (store only)
+    int count;                  // IDs in it (handles 0 to count - 1)
+    int byte_count;             // bytes of 'arrays.bytes' in use
+    int checkpointed;           // 1: the store's header points at 'arrays'
+};
+
+//a position in a dictionary, for reading its IDs in order
+struct dict_cursor {
+    id_key_t id;                // the ID at the position
+    int at;                     // its place in ID order, 'count' at the end
+    const unsigned char * next; // the coded ID after it in its block
+};
+
+//the inventory struct (parts and assemblies). The catalog and the stock
+//(the part and assembly tables, the IDs, 'part_stock', 'on_hand', the BOM
+//graph, the sites, and the ID filters and dictionaries) are allocated from
+//the store when the inventory has one; everything else is only needed
+//while a request is carried out, and is always on the heap.
 struct inventory {
-    struct part * part_list;         // list of parts by ID
+    struct store * store;            // file the catalog is kept in, or NULL
+    int part_list;                   // handle of the first part of the list
     int part_count;                  // number of distinct parts
-    struct assembly * assembly_list; // list of assemblies by ID
+    long long * part_stock;          // stock of each part, by handle
+    struct part * part_table;        // each part, by handle
+    char (* part_ids)[ID_SIZE];      // the ID of each part, by handle (see
+                                     // PART_ID)
+    long long * part_demand;         // parts needed by the walk in progress
+    int * part_touched;              // handles with a 'part_demand' set
+    int part_touched_count;
+    int part_size;                   // parts the arrays by handle can hold
+    int assembly_list;               // handle of the first assembly
     int assembly_count;              // number of distinct assemblies
+    struct assembly * assembly_table; // each assembly, by handle
+    char (* assembly_ids)[ID_SIZE];  // the ID of each assembly, by handle
+                                     // (see ASSEMBLY_ID)
+    long long * on_hand;             // on hand at each site, by handle (see
+                                     // ON_HAND)
+    int * bom_child;                 // item of each BOM entry
+    long long * bom_quantity;        // quantity of each BOM entry
+    int bom_count;                   // BOM entries in use
+    int bom_size;                    // BOM entries the arrays can hold
+    struct bom_row * bom_rows;       // the distinct rows of the BOM graph
+    int bom_row_count;
+    int bom_row_size;                // rows 'bom_rows' can hold
+    int * bom_index;                 // hash table of 'bom_rows' (open
+                                     // addressing), -1: an empty slot
+    int bom_index_size;              // slots, a power of two
+    int * bom_spare;                 // the index it was in before (store
+                                     // only, see own_bom_index)
+    int bom_spare_size;
+    int bom_index_checkpointed;      // 1: the store's header points at
+                                     // 'bom_index'
+    long long * demand;              // quote: units needed, by handle
+    int * demand_heap;               // quote: handles with demand, highest
+                                     // first
+    int demand_count;
+    long long * shadow_on_hand;      // quote: 'on_hand' as the quote sees it,
+                                     // by handle (see struct overlay)
+    unsigned int * shadow_stamp;     // quote: generation of the overlay each
+                                     // copy belongs to, 0: no copy
+    unsigned int shadow_generation;  // generation of the newest overlay
+    int assembly_size;               // assemblies the arrays by handle hold
+    long long * batch_values;        // batch rows, kept for the next batch
+    struct id_filter part_filter;    // the IDs of the parts
+    struct id_filter assembly_filter; // the IDs of the assemblies
+    struct id_dict part_dict;        // the IDs of the parts, sorted
+    struct id_dict assembly_dict;    // the IDs of the assemblies, sorted
+    size_t batch_size;               // values 'batch_values' can hold
+    unsigned long order_count;       // orders fulfilled (forecast clock)
+    char (* site_names)[ID_MAX+1];   // name of each site, by site number
+    int site_count;                  // number of sites, the default included
+    int site_size;                   // sites the 'on_hand' arrays can hold
+    FILE * out;                      // stream request output is printed to
+    FILE * err;                      // stream request errors are printed to
+    record_fn_t record;              // called with every result row, or NULL
+    void * record_context;           // passed back to 'record'
+    struct versions * versions;      // past 'on_hand' pages kept for
+                                     // snapshots, NULL before the first
+    struct snapshot * snapshot;      // the snapshot this is the view of, or
+                                     // NULL for the inventory itself
+#ifdef STATS
+    stats_t stats;                   // request statistics of this inventory
+#endif
 };
 
-//parts/sub-assemblies needed to make required assemblies
+//parts/sub-assemblies needed to make required assemblies. The items are
+//kept side by side in the order they were added, and the list is that
+//order walked from the newest item back (see ITEM_AT).
 struct items_needed {
-    struct item * item_list;
+    struct item * item_array;
     int item_count;
+    int item_size;               // items 'item_array' can hold
+};
+
+//the item at a position of a list, 0 being the newest
+#define ITEM_AT(items, i) (&((items) -> item_array[(items) -> item_count \
+                                                   - 1 - (i)]))
+
+//on_hand values changed by a quote (only touched assemblies are copied).
+//The copies are kept in the inventory by assembly handle (see
+//'shadow_on_hand'), and one is this overlay's if it is stamped with the
+//overlay's generation, so a copy is found in one step.
+struct overlay {
+    unsigned int generation;    // stamp of the overlay's copies, 0: none yet
+    int * touched;              // handles of the assemblies copied
+    int touched_count;
+    int touched_size;           // handles 'touched' can hold
+};
+
+//struct to represent an 'on_hand' value as it was before an order changed it
+struct undo {
+    struct assembly * assembly; // the assembly that was changed
+    int site;                   // the site whose value was changed
+    long long on_hand;          // its 'on_hand' value before the change
+};
+
+//'on_hand' changes made by an order, so the order can be rolled back
+struct undo_log {
+    struct undo * undo_array;
+    int undo_count;             // number of changes logged
+    int undo_size;              // number of changes the array can hold
+};
+
+//state an order is evaluated against (any of these may be NULL)
+struct order {
+    struct overlay * overlay;   // quote: copy-on-write 'on_hand' values
+    struct items_needed * made; // quote: assemblies that would be made
+    struct undo_log * log;      // transaction: 'on_hand' changes to undo
+    int site;                   // the site the order is filled from
+};
+
+//largest value a batch row may hold, so adding a product no larger than
+//this to it cannot overflow (anything larger sends the batch back to being
+//filled one order at a time, which reports it)
+#define BATCH_LIMIT (LLONG_MAX / 2)
+
+//orders filled together: every assembly and part they touch gets a row of
+//values, with a column for each order
+struct batch {
+    int columns;                // orders of the batch that are filled
+    int * sites;                // the site of each column's order
+    long long * values;         // the rows, 'columns' values each
+    int row_count;              // rows handed out
+    int * demand_row;           // row of each assembly's units needed (the
+                                // next row holds the units made), -1: none
+    int * part_row;             // row of each part's units needed, -1: none
+    int * expanded;             // assemblies in the order they were expanded
+    int expanded_count;
+    int * parts;                // parts in the order they were first needed
+    int part_count;
 };
 
 //struct to represent a request and the function needed to process (unused)
@@ -61,18 +323,26 @@ struct req {
 };
 
 //struct typedef declarations for ease of use
-typedef struct inventory inventory_t;
 typedef struct items_needed items_needed_t;
 typedef struct item item_t;
 typedef struct part part_t;
 typedef struct assembly assembly_t;
+typedef struct overlay overlay_t;
+typedef struct undo undo_t;
+typedef struct undo_log undo_log_t;
+typedef struct order order_t;
+typedef struct batch batch_t;
+typedef struct id_filter id_filter_t;
+typedef struct id_dict id_dict_t;
+typedef struct dict_cursor dict_cursor_t;
+typedef struct bom_row bom_row_t;
 
-//determine if a part is in a parts list
-part_t * lookup_part(part_t * pp, char * id);
-//determine if an assembly is in an assembly list
-assembly_t * lookup_assembly(assembly_t * ap, char * id);
+//determine if a part is in an inventory
+part_t * lookup_part(inventory_t * invp, char * id);
+//determine if an assembly is in an inventory
+assembly_t * lookup_assembly(inventory_t * invp, char * id);
 //determine if an item is in an item list
-item_t * lookup_item(item_t * ip, char * id);
+item_t * lookup_item(inventory_t * invp, items_needed_t * items, char * id);
 
 //add a part identifier to the inventory
 void add_part(inventory_t * invp, char * id);
@@ -81,37 +351,57 @@ void add_assembly(inventory_t * invp,
                   char * id,
                   int capacity,
                   items_needed_t * items);
-//add an item (part or assembly) to an items_needed list
-void add_item(items_needed_t * items, char * id, int quantity);
+//add an item (part or assembly) to an items_needed list, returns 0 if
+//it could not be added
+int add_item(inventory_t * invp,
+             items_needed_t * items,
+             char * id,
+             long long quantity);
 
 // these are used for sorting purposes
-//convert a linked list of parts to an array or parts
-part_t ** to_part_array(int count, part_t * part_list);
-//convert a linked list of assemblies to an array of assemblies
-assembly_t ** to_assembly_array(int count, assembly_t * assembly_list);
-//convert a linked list of items to an array of items
-item_t ** to_item_array(int count, item_t * item_list);
-
-//compare two parts based on their IDs
-int part_compare(const void *, const void *);
-//compare two assemblies based on their IDs
-int assembly_compare(const void *, const void *);
+//convert the list of parts to an array of their IDs (in 'part_ids')
+char ** to_part_array(inventory_t * invp);
+//convert the list of assemblies to an array of their IDs (in
+//'assembly_ids')
+char ** to_assembly_array(inventory_t * invp);
+//convert a list of items to an array of items
+item_t ** to_item_array(items_needed_t * items);
+
+//compare two IDs of parts or assemblies, given pointers to them
+int id_compare_at(const void *, const void *);
 //compare two items based on their IDs
 int item_compare(const void *, const void *);
 
+//these return 0 if a quantity needed was too large to count
+
 //Make a given amount of assemblies from an inventory
-void make(inventory_t * invp, char * id, int n, items_needed_t * parts);
+int make(inventory_t * invp, char * id, long long n, items_needed_t * parts);
 //Determine if there is enough of a given amount of assemblies
-void get(inventory_t * invp, char * id, int n, items_needed_t * parts);
+int get(inventory_t * invp, char * id, long long n, items_needed_t * parts);
+//Determine what making a given amount of assemblies would need, without
+//changing the inventory (on_hand changes are kept in the overlay)
+int quote(inventory_t * invp,
+          char * id,
+          long long n,
+          overlay_t * overlay,
+          items_needed_t * made,
+          items_needed_t * parts);
+//Fulfill every line of an order, or none of them if any line is invalid
+int fulfill_order(inventory_t * invp,
+                  int site,
+                  int count,
+                  char * ids[],
+                  int amounts[],
+                  items_needed_t * parts);
 
 //display a sorted list of assemblies in the inventory
 void print_inventory(inventory_t * invp);
-//display a sorted list of parts
-void print_parts(inventory_t * invp);
+//display a sorted list of assemblies with their stock across every site
+void print_all_sites(inventory_t * invp);
 //display a sorted list of items from an items_needed list
-void print_items_needed(items_needed_t * items);
+void print_items_needed(inventory_t * invp, items_needed_t * items);
 
-//delete the entire inventory and free all allocated memory
-void free_inventory(inventory_t * invp);
+//delete an overlay left over from a quote
+void free_overlay(inventory_t * invp, overlay_t * overlay);
 
 #endif // INVENTORY_H
@@ -0,0 +1,161 @@
+/*
+ * File: libinventory.h
+ *
+ * Description: The public interface of the inventory library. An inventory
+ *              is an opaque handle, and every function works on the handle
+ *              it is given, so any number of inventories can be open in one
+ *              process at once. Requests print to the handle's output and
+ *              error streams, and can also report each result row they
+ *              print to a function set on the handle.
+ *
+ *              Built as libinventory.a and libinventory.so; the inventory
+ *              program is a front end over it (see main.c).
+ *
+ * @author: Frank Abbey (fra1489)
+ * @version: 10/19/2026
+ */
+#ifndef LIBINVENTORY_H
+#define LIBINVENTORY_H
+
+#include <stdio.h>
+
+//All IDs must not exceed 11 in length
+#define ID_MAX 11
+//longest request line read at once, and most tokens in a request
+#define MAX_LENGTH 351
+//most sites (warehouses) an inventory can stock assemblies at
+#define SITE_MAX 64
+//name of the site requests without an '@site' go to (site number 0)
+#define SITE_DEFAULT "main"
+//most fulfillOrder requests process_batch carries out together
+#define BATCH_MAX 256
+
+//request codes (binary protocol opcodes are the same numbers)
+#define REQUEST_UNKNOWN 0
+#define REQUEST_ADD_PART 1
+#define REQUEST_ADD_ASSEMBLY 2
+#define REQUEST_FULFILL_ORDER 3
+#define REQUEST_STOCK 4
+#define REQUEST_RESTOCK 5
+#define REQUEST_EMPTY 6
+#define REQUEST_INVENTORY 7
+#define REQUEST_PARTS 8
+#define REQUEST_HELP 9
+#define REQUEST_CLEAR 10
+#define REQUEST_QUIT 11
+#define REQUEST_QUOTE 12
+#define REQUEST_STATS 13
+#define REQUEST_STOCK_PART 14
+#define REQUEST_MEMSTATS 15
+#define REQUEST_COUNT 16
+//requests that only print what is in the inventory, which can be carried
+//out on a snapshot
+#define REPORT_REQUEST(code) \
+    ((code) == REQUEST_INVENTORY || (code) == REQUEST_PARTS)
+
+//kinds of result rows a request can report to the record function
+#define RECORD_MADE 1      // assembly made: id, amount made
+#define RECORD_RESTOCKED 2 // assembly restocked: id, amount made
+#define RECORD_PART 3      // part needed: id, quantity
+#define RECORD_QUOTED 4    // assembly a quote would make: id, amount
+#define RECORD_ASSEMBLY 5  // assembly listed: id, capacity, on hand
+#define RECORD_COMPONENT 6 // item an assembly is made from: id, quantity
+#define RECORD_PART_ID 7   // part listed: id
+#define RECORD_ERROR 8     // error: message
+#define RECORD_SHORTAGE 9  // part short of stock: id, quantity short
+
+//an inventory of parts and assemblies (the fields are in inventory.h)
+typedef struct inventory inventory_t;
+//a read-only view of an inventory as it was at one point in time
+typedef struct snapshot snapshot_t;
+
+//called with every result row a request prints, and the context it was
+//set with
+typedef void (* record_fn_t)(void * context, int type, char * text,
+                             long long a, long long b);
+
+//create an empty inventory printing to stdout/stderr
+inventory_t * new_inventory(void);
+//open an inventory kept in a store file (created if it does not exist),
+//returns NULL with errno set if the file could not be opened
+inventory_t * open_inventory(const char * path);
+//write an inventory's changes to its store file, returns 0 if they could
+//not be written (1 if it has no store file)
+int checkpoint_inventory(inventory_t * invp);
+//delete the entire inventory and free all allocated memory
+void free_inventory(inventory_t * invp);
+//delete every part and assembly, leaving the inventory empty
+void clear_inventory(inventory_t * invp);
+//set the streams the inventory's requests print output and errors to
+void set_output(inventory_t * invp, FILE * out, FILE * err);
+//set the function the inventory's requests report result rows to
+void set_record(inventory_t * invp, record_fn_t record, void * context);
+
+//name of each command by its REQUEST_ code
+extern char * command_names[REQUEST_COUNT];
+//find the REQUEST_ code of a command name (or any leading part of it)
+int lookup_command(char * command);
+//split a request line into tokens, returns the number of tokens
+int tokenize(char * line, char * array[]);
+//read a number the way strtol(text, NULL, 10) does
+long parse_number(const char * text);
+//carry out a tokenized request, returns 0 if the request was 'quit'
+int process_request(inventory_t * invp, char * array[], int size);
+//carry out up to BATCH_MAX tokenized fulfillOrder requests together, as if
+//one after another (each order lists what it made instead of each make)
+void process_batch(inventory_t * invp,
+                   char ** requests[],
+                   int sizes[],
+                   int count);
+//take a snapshot of an inventory as it is now (only on the thread carrying
+//out its requests). While there are snapshots, requests that change the
+//catalog wait until they are all released.
+snapshot_t * take_snapshot(inventory_t * invp);
+//release a snapshot (on any thread)
+void release_snapshot(snapshot_t * snapshot);
+//carry out a report request on a snapshot, printing to the given streams,
+//returns 0 if the request is not a report
+int snapshot_request(snapshot_t * snapshot,
+                     FILE * out,
+                     FILE * err,
+                     char * array[],
+                     int size);
+//find the number of a site by name, adding it if it is new (-1 if it
+//cannot be added)
+int lookup_site(inventory_t * invp, char * name);
+
+//requests, as called once their arguments are known
+void add_part_request(inventory_t * invp, char * id);
+void add_assembly_request(inventory_t * invp,
+                          char * id,
+                          int capacity,
+                          int count,
+                          char * ids[],
+                          int amounts[],
+                          char * amount_text[]);
+void fulfill_order_request(inventory_t * invp,
+                           int site,
+                           int count,
+                           char * ids[],
+                           int amounts[]);
+void quote_request(inventory_t * invp,
+                   int count,
+                   char * ids[],
+                   int amounts[]);
+void stock_request(inventory_t * invp, int site, char * id, int amount);
+void stock_part_request(inventory_t * invp, char * id, int amount);
+void restock_request(inventory_t * invp, char * id, int forecast);
+void empty_request(inventory_t * invp, char * id);
+void inventory_request(inventory_t * invp, char * id);
+void all_sites_request(inventory_t * invp);
+void help_request(inventory_t * invp);
+//display the bytes each kind of structure of an inventory takes, and the
+//bytes per part or assembly
+void memstats_request(inventory_t * invp);
+//display a sorted list of parts
+void print_parts(inventory_t * invp);
+//display a sorted list of the parts whose IDs start with a prefix (NULL
+//for every part)
+void parts_request(inventory_t * invp, char * prefix);
+
+#endif // LIBINVENTORY_H
@@ -0,0 +1,306 @@
+/*
+ * File: loadgen.c
+ *
+ * Description: Load generator for an inventory server. Each client
+ *              connection replays the requests of a request file against
+ *              the server, sending a request only once the reply to the
+ *              previous one has arrived, and the latency of every request
+ *              is recorded and summarized.
+ *
+ *              Useage: ./loadgen socket filename [clients [passes]]
+ *
+ * @author: Frank Abbey (fra1489)
+ * @version: 10/19/2026
+ */
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "trimit.h"
+
+//struct to represent one connection's progress through the requests
+struct session {
+    int fd;
+    long next;            // index of the next request to send
+    long sent;            // number of requests sent
+    int at_line_start;    // the last byte received ended a line
+    int at_dot;           // the current reply line so far is "."
+    struct timespec start; // when the outstanding request was sent
+};
+
+typedef struct session session_t;
+
+/*
+ * Nanoseconds between two times
+ *
+ * @param struct timespec* from - the earlier time
+ * @param struct timespec* to - the later time
+ *
+ * @return double - the nanoseconds between them
+ */
+static double elapsed(struct timespec* from, struct timespec* to) {
+    return (to -> tv_sec - from -> tv_sec) * 1e9
+    + (to -> tv_nsec - from -> tv_nsec);
+}
+
+/*
+ * Compare two latencies
+ *
+ * @param const void* l1 - a void pointer representing a latency
+ * @param const void* l2 - a void pointer representing a latency
+ *
+ * @return int - <0, 0, >0 as l1 is less than, equal to, greater than l2
+ */
+static int latency_compare(const void* l1, const void* l2) {
+    double d1 = *(const double*)l1;
+    double d2 = *(const double*)l2;
+    return (d1 > d2) - (d1 < d2);
+}
+
+/*
+ * Read the requests of a request file. Blank lines and comments are left
+ * out since the server does not reply to them, and so is 'quit' since it
+ * would end the session.
+ *
+ * @param char* filename - the request file
+ * @param long* count - set to the number of requests read
+ *
+ * @return char** - the request lines, each ending in a newline
+ */
+static char** read_requests(char* filename, long* count) {
+
+    FILE* fp = fopen(filename, "r");
+    if(!fp) {
+        perror(filename);
+        exit(EXIT_FAILURE);
+    }
+
+    char** requests = NULL;
+    long size = 0;
+    char* buffer = NULL;
+    size_t n = 0;
+    *count = 0;
+
+    while(getline(&buffer, &n, fp) != -1) {
+
+        char* line = trim(buffer);
+        size_t command = strcspn(line, " ");
+        if(*line == '\0' || *line == '#'
+           || strncmp(line, "quit", command) == 0) {
+            continue;
+        }
+
+        if(*count == size) {
+            size = (size == 0) ? 64 : size * 2;
+            requests = realloc(requests, size * sizeof(char*));
+        }
+        requests[*count] = malloc(strlen(line) + 2);
+        sprintf(requests[*count], "%s\n", line);
+        (*count)++;
+    }
+
+    free(buffer);
+    fclose(fp);
+    return requests;
+}
+
+/*
+ * Connect to the server's socket
+ *
+ * @param char* path - the file system path of the socket
+ *
+ * @return int - the connection
+ */
+static int connect_to(char* path) {
+
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(fd == -1
+       || connect(fd, (struct sockaddr*)&address, sizeof(address)) == -1) {
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+    return fd;
+}
+
+/*
+ * Send a session's next request
+ *
+ * @param session_t* session - the session
+ * @param char** requests - the request lines
+ * @param long count - the number of request lines
+ */
+static void send_request(session_t* session, char** requests, long count) {
+
+    char* line = requests[session -> next];
+    size_t length = strlen(line);
+    size_t done = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &(session -> start));
+    while(done < length) {
+        ssize_t num = write(session -> fd, line + done, length - done);
+        if(num == -1 && errno != EINTR) {
+            perror("write");
+            exit(EXIT_FAILURE);
+        }
+        if(num > 0) {
+            done += num;
+        }
+    }
+
+    session -> next = (session -> next + 1) % count;
+    session -> sent++;
+}
+
+/*
+ * Look through received bytes for the line that ends a reply
+ *
+ * @param session_t* session - the session the bytes arrived on
+ * @param char* bytes - the bytes received
+ * @param ssize_t n - the number of bytes received
+ *
+ * @return int - 1: the reply is complete, 0: more is coming
+ */
+static int reply_ended(session_t* session, char* bytes, ssize_t n) {
+
+    int ended = 0;
+    ssize_t i;
+    for(i = 0; i < n; i++) {
+        if(bytes[i] == '\n') {
+            if(session -> at_dot) {
+                ended = 1;
+            }
+            session -> at_line_start = 1;
+            session -> at_dot = 0;
+        }
+        else {
+            session -> at_dot = (session -> at_line_start && bytes[i] == '.');
+            session -> at_line_start = 0;
+        }
+    }
+    return ended;
+}
+
+/*
+ * Main function replays a request file over several connections at once
+ * and prints the throughput and latency percentiles of the requests
+ *
+ * @param int argc - the amount of arguments given
+ * @param char* argv[] - the arguments given
+ *
+ * @return int - EXIT_FAILURE: bad arguments or a connection failed
+ *               EXIT_SUCCESS: the load was run
+ */
+int main(int argc, char* argv[]) {
+
+    if(argc < 3 || argc > 5) {
+        fprintf(stderr,
+        "Useage: ./loadgen socket filename [clients [passes]]\n");
+        return EXIT_FAILURE;
+    }
+
+    int clients = (argc > 3) ? atoi(argv[3]) : 1;
+    int passes = (argc > 4) ? atoi(argv[4]) : 1;
+    long count;
+    char** requests = read_requests(argv[2], &count);
+
+    if(clients <= 0 || passes <= 0 || count == 0) {
+        fprintf(stderr, "!!! nothing to send\n");
+        return EXIT_FAILURE;
+    }
+
+    long per_client = count * passes;
+    long total = per_client * clients;
+    double* latencies = malloc(total * sizeof(double));
+    long done = 0;
+
+    session_t* sessions = calloc(clients, sizeof(session_t));
+    struct pollfd* fds = calloc(clients, sizeof(struct pollfd));
+
+    struct timespec begin, end, now;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+
+    //every session starts with one request outstanding
+    int i;
+    for(i = 0; i < clients; i++) {
+        sessions[i].fd = connect_to(argv[1]);
+        sessions[i].at_line_start = 1;
+        fds[i].fd = sessions[i].fd;
+        fds[i].events = POLLIN;
+        send_request(&sessions[i], requests, count);
+    }
+
+    char chunk[65536];
+    int active = clients;
+
+    while(active > 0) {
+
+        if(poll(fds, clients, -1) == -1) {
+            if(errno == EINTR) {
+                continue;
+            }
+            perror("poll");
+            return EXIT_FAILURE;
+        }
+
+        for(i = 0; i < clients; i++) {
+            if(fds[i].revents == 0) {
+                continue;
+            }
+
+            ssize_t num = read(fds[i].fd, chunk, sizeof(chunk));
+            if(num <= 0) {
+                fprintf(stderr, "!!! server closed the connection\n");
+                return EXIT_FAILURE;
+            }
+
+            if(reply_ended(&sessions[i], chunk, num)) {
+                clock_gettime(CLOCK_MONOTONIC, &now);
+                latencies[done++] = elapsed(&(sessions[i].start), &now);
+
+                if(sessions[i].sent < per_client) {
+                    send_request(&sessions[i], requests, count);
+                }
+                else {
+                    close(fds[i].fd);
+                    fds[i].fd = -1;
+                    active--;
+                }
+            }
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = elapsed(&begin, &end) / 1e9;
+
+    qsort(latencies, done, sizeof(double), latency_compare);
+    printf("requests:     %ld (%d clients x %d passes x %ld)\n",
+    done, clients, passes, count);
+    printf("seconds:      %.3f\n", seconds);
+    printf("requests/sec: %.0f\n", done / seconds);
+    printf("p50 usec:     %.1f\n", latencies[done / 2] / 1e3);
+    printf("p99 usec:     %.1f\n", latencies[(done * 99) / 100] / 1e3);
+    printf("max usec:     %.1f\n", latencies[done - 1] / 1e3);
+
+    long r;
+    for(r = 0; r < count; r++) {
+        free(requests[r]);
+    }
+    free(requests);
+    free(latencies);
+    free(sessions);
+    free(fds);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,163 @@
+/*
+ * File: main.c
+ *
+ * Description: The command line front end of the inventory system. Opens
+ *              one inventory and feeds it request lines from a file or
+ *              stdin, or hands it to the pipeline, the socket server, the
+ *              binary protocol tools, the order scheduler, the batch
+ *              filler or the timing harness. With '-m' the inventory is
+ *              kept in a store file, so its catalog and stock are still
+ *              there the next time the program is run. Everything else
+ *              lives in the inventory library (see libinventory.h).
+ *
+ * @author: Frank Abbey (fra1489)
+ * @version: 10/19/2026
+ */
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "libinventory.h"
+#include "pipeline.h"
+#include "server.h"
+#include "binproto.h"
+#include "bench.h"
+#include "schedule.h"
+#include "batch.h"
+
+/*
+ * Main function primarily handles the allocation of the inventory
+ * and interpreting request lines from a file or stdin (or from
+ * clients of a socket, when run as a server).
+ *
+ * @param int argc - the amount of arguments given
+ * @param char* argv[] - the arguments given
+ *
+ * @return int - EXIT_FAILURE: the input file could not be read,
+ *                             or there was an incorrect number of
+ *                             command line arguments
+ *               EXIT_SUCCESS: the program executed successfully
+ */
+int main(int argc, char* argv[]) {
+
+    FILE* fp;
+    char mode = 0;
+    char* store = NULL;
+
+    //'-m' keeps the inventory in a store file, whatever it is used for
+    if(argc > 2 && strcmp(argv[1], "-m") == 0) {
+        store = argv[2];
+        argc -= 2;
+        argv += 2;
+    }
+
+    //'-s' serves requests on a socket instead of reading them
+    if(argc == 3 && strcmp(argv[1], "-s") == 0) {
+        inventory_t* inventory = store ? open_inventory(store)
+        : new_inventory();
+        if(!inventory) {
+            perror(store);
+            return EXIT_FAILURE;
+        }
+        int status = run_server(inventory, argv[2]);
+        free_inventory(inventory);
+        return status;
+    }
+
+    //'-p' runs the requests through the pipeline, '-b' runs binary
+    //requests, '-e' encodes text requests, '-d' prints binary replies, '-q'
+    //schedules the orders by priority, '-k' fills the orders in batches,
+    //'-K' times the orders in batches of every size, '-t' times the
+    //requests and '-P' times splitting up the request lines
+    if(argc > 1 && (strcmp(argv[1], "-p") == 0 || strcmp(argv[1], "-b") == 0
+                    || strcmp(argv[1], "-e") == 0
+                    || strcmp(argv[1], "-d") == 0
+                    || strcmp(argv[1], "-q") == 0
+                    || strcmp(argv[1], "-k") == 0
+                    || strcmp(argv[1], "-K") == 0
+                    || strcmp(argv[1], "-t") == 0
+                    || strcmp(argv[1], "-P") == 0)) {
+        mode = argv[1][1];
+        argc--;
+        argv++;
+    }
+
+    if(argc == 1) {
+        fp = stdin;
+    }
+    else if(argc == 2) {
+        fp = fopen(argv[1], "r");
+
+        if(!fp) {
+            perror(argv[1]);
+            return EXIT_FAILURE;
+        }
+    }
+    else {
+        fprintf(stderr,
+        "Useage: ./inventory [-m store] [-p | -b | -e | -d | -q | -k | -K"
+        " | -t | -P] [filename] | ./inventory [-m store] -s socket");
+        printf("\n");
+        return EXIT_FAILURE;
+    }
+
+    inventory_t* inventory = store ? open_inventory(store) : new_inventory();
+    if(!inventory) {
+        perror(store);
+        if(fp != stdin) {
+            fclose(fp);
+        }
+        return EXIT_FAILURE;
+    }
+
+    //run the requests through the parse/execute/format pipeline
+    if(mode == 'p') {
+        int status = run_pipeline(inventory, fp);
+        fclose(fp);
+        free_inventory(inventory);
+        return status;
+    }
+    //the binary protocol tools, the order scheduler, the batch filler and
+    //the timing harnesses
+    if(mode == 'b' || mode == 'e' || mode == 'd' || mode == 'q'
+       || mode == 'k' || mode == 'K' || mode == 't' || mode == 'P') {
+        int status = (mode == 'b') ? run_binary(inventory, fp, stdout)
+        : (mode == 'e') ? encode_requests(fp, stdout)
+        : (mode == 'd') ? print_replies(fp, stdout)
+        : (mode == 'q') ? run_schedule(inventory, fp, SCHEDULE_WINDOW)
+        : (mode == 'k') ? run_batch(inventory, fp, BATCH_DEFAULT)
+        : (mode == 'K') ? sweep_batch(fp)
+        : (mode == 'P') ? run_parse_bench(fp)
+        : run_bench(inventory, fp);
+        fclose(fp);
+        free_inventory(inventory);
+        return status;
+    }
+
+    //getline() variables
+    char* buffer = (char*) malloc(sizeof(char) * MAX_LENGTH);
+    size_t n = MAX_LENGTH;
+    ssize_t num  = 0;
+
+    int i = 0;
+    int request_return = 1;
+    char* request_array[MAX_LENGTH];
+
+    //extracing commands from file/stdin
+    while(request_return && (num = getline(&buffer, &n, fp) != -1)) {
+
+        i = tokenize(buffer, request_array);
+        //the line was not blank or a comment
+        if(i != 0) {
+            request_return = process_request(inventory, request_array, i);
+        }
+    }
+
+    fclose(fp);
+    free_inventory(inventory);
+    free(buffer);
+
+    return EXIT_SUCCESS;
+
+}
@@ -0,0 +1,501 @@
+/*
+ * File: pipeline.c
+ *
+ * Description: Runs requests through four threads connected by bounded
+ *              rings. The parser reads and tokenizes lines, the executor
+ *              carries out the requests in order with their output captured
+ *              in memory, and the formatter writes that output to stdout
+ *              and stderr, so the result is the same as running serially.
+ *              Report requests (inventory, parts) are handed to the
+ *              reporter with a snapshot of the inventory as it was when
+ *              their turn came, so the executor goes on filling orders
+ *              while a large inventory is sorted and printed.
+ *
+ * Table of Contents:
+ *
+ *      Section:           Line:
+ *      ------------------ -----
+ *      RING                  35
+ *      STAGES               180
+ *      RUN                  436
+ *
+ * @author: Frank Abbey (fra1489)
+ * @version: 10/19/2026
+ */
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include "libinventory.h"
+#include "pipeline.h"
+
+/* - - - RING - - -*/
+
+/*
+ * Set up an empty ring
+ *
+ * @param ring_t* ring - the ring to be set up
+ */
+void ring_init(ring_t* ring) {
+    ring -> head = 0;
+    ring -> tail = 0;
+    ring -> closed = 0;
+    ring -> sleepers = 0;
+    pthread_mutex_init(&(ring -> lock), NULL);
+    pthread_cond_init(&(ring -> wake), NULL);
+}
+
+/*
+ * Wake the other side of a ring if it went to sleep waiting on it. The
+ * ring is only locked when someone is actually asleep.
+ *
+ * @param ring_t* ring - the ring that changed
+ */
+static void ring_wake(ring_t* ring) {
+    if(__atomic_load_n(&(ring -> sleepers), __ATOMIC_SEQ_CST) > 0) {
+        pthread_mutex_lock(&(ring -> lock));
+        pthread_cond_broadcast(&(ring -> wake));
+        pthread_mutex_unlock(&(ring -> lock));
+    }
+}
+
+/*
+ * Add an item to a ring, waiting while the ring is full
+ *
+ * @param ring_t* ring - the ring to add to
+ * @param void* item - the item to be added
+ *
+ * @return int - 1: the item was added, 0: the ring was closed
+ */
+int ring_push(ring_t* ring, void* item) {
+
+    size_t head = ring -> head;
+    int spins = 0;
+
+    while(head - __atomic_load_n(&(ring -> tail), __ATOMIC_SEQ_CST)
+          == RING_SIZE) {
+
+        if(__atomic_load_n(&(ring -> closed), __ATOMIC_SEQ_CST)) {
+            return 0;
+        }
+        //the consumer is usually about to take something, so wait a little
+        //before going to sleep
+        if(spins < RING_SPINS) {
+            spins++;
+            sched_yield();
+        }
+        else {
+            pthread_mutex_lock(&(ring -> lock));
+            __atomic_add_fetch(&(ring -> sleepers), 1, __ATOMIC_SEQ_CST);
+            while(head - __atomic_load_n(&(ring -> tail), __ATOMIC_SEQ_CST)
+                  == RING_SIZE
+                  && !__atomic_load_n(&(ring -> closed), __ATOMIC_SEQ_CST)) {
+                pthread_cond_wait(&(ring -> wake), &(ring -> lock));
+            }
+            __atomic_sub_fetch(&(ring -> sleepers), 1, __ATOMIC_SEQ_CST);
+            pthread_mutex_unlock(&(ring -> lock));
+        }
+    }
+
+    if(__atomic_load_n(&(ring -> closed), __ATOMIC_SEQ_CST)) {
+        return 0;
+    }
+
+    ring -> slots[head & (RING_SIZE - 1)] = item;
+    __atomic_store_n(&(ring -> head), head + 1, __ATOMIC_SEQ_CST);
+    ring_wake(ring);
+
+    return 1;
+}
+
+/*
+ * Remove the oldest item from a ring, waiting while the ring is empty
+ *
+ * @param ring_t* ring - the ring to remove from
+ *
+ * @return void* - the item, or NULL if the ring is closed and empty
+ */
+void* ring_pop(ring_t* ring) {
+
+    size_t tail = ring -> tail;
+    int spins = 0;
+
+    while(__atomic_load_n(&(ring -> head), __ATOMIC_SEQ_CST) == tail) {
+
+        if(__atomic_load_n(&(ring -> closed), __ATOMIC_SEQ_CST)) {
+            //the producer may have pushed just before it closed the ring
+            if(__atomic_load_n(&(ring -> head), __ATOMIC_SEQ_CST) == tail) {
+                return NULL;
+            }
+        }
+        else if(spins < RING_SPINS) {
+            spins++;
+            sched_yield();
+        }
+        else {
+            pthread_mutex_lock(&(ring -> lock));
+            __atomic_add_fetch(&(ring -> sleepers), 1, __ATOMIC_SEQ_CST);
+            while(__atomic_load_n(&(ring -> head), __ATOMIC_SEQ_CST) == tail
+                  && !__atomic_load_n(&(ring -> closed), __ATOMIC_SEQ_CST)) {
+                pthread_cond_wait(&(ring -> wake), &(ring -> lock));
+            }
+            __atomic_sub_fetch(&(ring -> sleepers), 1, __ATOMIC_SEQ_CST);
+            pthread_mutex_unlock(&(ring -> lock));
+        }
+    }
+
+    void* item = ring -> slots[tail & (RING_SIZE - 1)];
+    __atomic_store_n(&(ring -> tail), tail + 1, __ATOMIC_SEQ_CST);
+    ring_wake(ring);
+
+    return item;
+}
+
+/*
+ * Mark a ring as finished. Pushes fail from now on, and pops fail once
+ * whatever is left in the ring has been taken.
+ *
+ * @param ring_t* ring - the ring to be closed
+ */
+void ring_close(ring_t* ring) {
+    __atomic_store_n(&(ring -> closed), 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_lock(&(ring -> lock));
+    pthread_cond_broadcast(&(ring -> wake));
+    pthread_mutex_unlock(&(ring -> lock));
+}
+
+/*
+ * Release the resources of a ring (the items left in it are not freed)
+ *
+ * @param ring_t* ring - the ring to be destroyed
+ */
+void ring_destroy(ring_t* ring) {
+    pthread_mutex_destroy(&(ring -> lock));
+    pthread_cond_destroy(&(ring -> wake));
+}
+
+/* - - - STAGES - - -*/
+
+/*
+ * Properly delete a job
+ *
+ * @param job_t* job - the job to be deleted from memory
+ */
+static void free_job(job_t* job) {
+    free(job -> line);
+    free(job -> out_text);
+    free(job -> err_text);
+    free(job);
+}
+
+/*
+ * Free the line buffer of a parser that is canceled while reading
+ *
+ * @param void* arg - the address of the parser's line buffer
+ */
+static void free_line(void* arg) {
+    free(*(char**)arg);
+}
+
+/*
+ * Parser stage: read request lines and pass the tokenized requests on to
+ * the executor. The parser can only be canceled while it is reading, which
+ * is how it is stopped if the executor reaches a 'quit'.
+ *
+ * @param void* arg - the pipeline
+ *
+ * @return void* - NULL
+ */
+static void* parse_stage(void* arg) {
+
+    pipeline_t* pipeline = arg;
+    char* buffer = NULL;
+    size_t n = 0;
+
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+    //(the cleanup handler is setjmp() based, so no local in here is
+    //changed other than through its address: the loop is left by break)
+    pthread_cleanup_push(free_line, &buffer);
+
+    while(1) {
+
+        pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
+        ssize_t num = getline(&buffer, &n, pipeline -> fp);
+        pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+
+        if(num == -1) {
+            break;
+        }
+
+        //(only the tokens that are filled in are ever read)
+        job_t* job = malloc(sizeof(job_t));
+        job -> size = tokenize(buffer, job -> tokens);
+        job -> line = NULL;
+        job -> out_text = NULL;
+        job -> err_text = NULL;
+        job -> snapshot = NULL;
+        job -> pending = 0;
+
+        //blank lines and comments go no further
+        if(job -> size == 0) {
+            free(job);
+        }
+        //the job takes the line, the next getline() allocates a new one
+        else {
+            job -> line = buffer;
+            buffer = NULL;
+            n = 0;
+            if(!ring_push(&(pipeline -> parsed), job)) {
+                free_job(job);
+                break;
+            }
+        }
+    }
+
+    pthread_cleanup_pop(1);
+    ring_close(&(pipeline -> parsed));
+
+    return NULL;
+}
+
+/*
+ * Copy what a request printed to a capture stream, and empty the stream
+ *
+ * @param FILE* stream - the capture stream
+ * @param char* buffer - the capture stream's buffer
+ * @param size_t size - the number of bytes in the stream
+ * @param size_t* length - set to the number of bytes copied
+ *
+ * @return char* - the copy, or NULL if nothing was printed
+ */
+static char* take_output(FILE* stream, char* buffer, size_t size,
+                         size_t* length) {
+
+    char* text = NULL;
+    *length = size;
+
+    if(size > 0) {
+        text = malloc(size);
+        memcpy(text, buffer, size);
+        fseeko(stream, 0, SEEK_SET);
+    }
+
+    return text;
+}
+
+/*
+ * Executor stage: carry out the requests in the order they were read,
+ * capturing what each one prints, and pass them on to the formatter. A
+ * report is passed on to the reporter as well, with a snapshot to be
+ * carried out on, and the formatter waits for it.
+ *
+ * @param void* arg - the pipeline
+ *
+ * @return void* - NULL if a 'quit' was reached
+ */
+static void* execute_stage(void* arg) {
+
+    pipeline_t* pipeline = arg;
+
+    char* out_buffer = NULL;
+    char* err_buffer = NULL;
+    size_t out_size = 0;
+    size_t err_size = 0;
+    FILE* out = open_memstream(&out_buffer, &out_size);
+    FILE* err = open_memstream(&err_buffer, &err_size);
+    set_output(pipeline -> invp, out, err);
+
+    int request_return = 1;
+    job_t* job;
+
+    while(request_return
+          && (job = ring_pop(&(pipeline -> parsed))) != NULL) {
+
+        if(REPORT_REQUEST(lookup_command(job -> tokens[0]))) {
+            job -> snapshot = take_snapshot(pipeline -> invp);
+            job -> pending = 1;
+            ring_push(&(pipeline -> reports), job);
+        }
+        else {
+            request_return = process_request(pipeline -> invp,
+            job -> tokens, job -> size);
+
+            fflush(out);
+            fflush(err);
+            job -> out_text = take_output(out, out_buffer, out_size,
+            &(job -> out_length));
+            job -> err_text = take_output(err, err_buffer, err_size,
+            &(job -> err_length));
+        }
+
+        ring_push(&(pipeline -> executed), job);
+    }
+
+    //a 'quit' was reached, the parser has to stop too
+    if(!request_return) {
+        ring_close(&(pipeline -> parsed));
+    }
+    ring_close(&(pipeline -> executed));
+    ring_close(&(pipeline -> reports));
+
+    set_output(pipeline -> invp, stdout, stderr);
+    fclose(out);
+    fclose(err);
+    free(out_buffer);
+    free(err_buffer);
+
+    return (void*)(long)request_return;
+}
+
+/*
+ * Reporter stage: carry out the reports on their snapshots, capturing what
+ * each one prints, and let the formatter know when each is done
+ *
+ * @param void* arg - the pipeline
+ *
+ * @return void* - NULL
+ */
+static void* report_stage(void* arg) {
+
+    pipeline_t* pipeline = arg;
+
+    char* out_buffer = NULL;
+    char* err_buffer = NULL;
+    size_t out_size = 0;
+    size_t err_size = 0;
+    FILE* out = open_memstream(&out_buffer, &out_size);
+    FILE* err = open_memstream(&err_buffer, &err_size);
+
+    job_t* job;
+    while((job = ring_pop(&(pipeline -> reports))) != NULL) {
+
+        snapshot_request(job -> snapshot, out, err, job -> tokens,
+        job -> size);
+        release_snapshot(job -> snapshot);
+
+        fflush(out);
+        fflush(err);
+        job -> out_text = take_output(out, out_buffer, out_size,
+        &(job -> out_length));
+        job -> err_text = take_output(err, err_buffer, err_size,
+        &(job -> err_length));
+
+        //the formatter may free the job as soon as this is seen
+        pthread_mutex_lock(&(pipeline -> lock));
+        __atomic_store_n(&(job -> pending), 0, __ATOMIC_RELEASE);
+        pthread_cond_broadcast(&(pipeline -> reported));
+        pthread_mutex_unlock(&(pipeline -> lock));
+    }
+
+    fclose(out);
+    fclose(err);
+    free(out_buffer);
+    free(err_buffer);
+
+    return NULL;
+}
+
+/*
+ * Formatter stage: write out what each request printed, in order
+ *
+ * @param void* arg - the pipeline
+ *
+ * @return void* - NULL
+ */
+static void* format_stage(void* arg) {
+
+    pipeline_t* pipeline = arg;
+    job_t* job;
+
+    while((job = ring_pop(&(pipeline -> executed))) != NULL) {
+        //a report may still be being carried out
+        if(__atomic_load_n(&(job -> pending), __ATOMIC_ACQUIRE)) {
+            pthread_mutex_lock(&(pipeline -> lock));
+            while(job -> pending) {
+                pthread_cond_wait(&(pipeline -> reported),
+                &(pipeline -> lock));
+            }
+            pthread_mutex_unlock(&(pipeline -> lock));
+        }
+        if(job -> out_length > 0) {
+            fwrite(job -> out_text, 1, job -> out_length, stdout);
+        }
+        if(job -> err_length > 0) {
+            fwrite(job -> err_text, 1, job -> err_length, stderr);
+        }
+        free_job(job);
+    }
+    fflush(stdout);
+
+    return NULL;
+}
+
+/* - - - RUN - - -*/
+
+/*
+ * Run every request in a file through the pipeline. The output is exactly
+ * what running the requests one after another would print.
+ *
+ * @param inventory_t* invp - the inventory the requests are carried out on
+ * @param FILE* fp - the file the requests are read from
+ *
+ * @return int - EXIT_SUCCESS: every request was run
+ */
+int run_pipeline(inventory_t* invp, FILE* fp) {
+
+    pipeline_t* pipeline = malloc(sizeof(pipeline_t));
+    pipeline -> fp = fp;
+    pipeline -> invp = invp;
+    ring_init(&(pipeline -> parsed));
+    ring_init(&(pipeline -> executed));
+    ring_init(&(pipeline -> reports));
+    pthread_mutex_init(&(pipeline -> lock), NULL);
+    pthread_cond_init(&(pipeline -> reported), NULL);
+
+    pthread_t parser, executor, reporter, formatter;
+    void* request_return;
+
+    if(pthread_create(&parser, NULL, parse_stage, pipeline) != 0) {
+        perror("pipeline");
+        exit(EXIT_FAILURE);
+    }
+    if(pthread_create(&executor, NULL, execute_stage, pipeline) != 0) {
+        perror("pipeline");
+        exit(EXIT_FAILURE);
+    }
+    if(pthread_create(&reporter, NULL, report_stage, pipeline) != 0) {
+        perror("pipeline");
+        exit(EXIT_FAILURE);
+    }
+    if(pthread_create(&formatter, NULL, format_stage, pipeline) != 0) {
+        perror("pipeline");
+        exit(EXIT_FAILURE);
+    }
+
+    pthread_join(executor, &request_return);
+    pthread_join(reporter, NULL);
+    pthread_join(formatter, NULL);
+
+    //after a 'quit' the parser may be waiting on input that is not needed
+    if(request_return == NULL) {
+        pthread_cancel(parser);
+    }
+    pthread_join(parser, NULL);
+
+    //requests read after a 'quit' are never run
+    job_t* job;
+    while((job = ring_pop(&(pipeline -> parsed))) != NULL) {
+        free_job(job);
+    }
+
+    ring_destroy(&(pipeline -> parsed));
+    ring_destroy(&(pipeline -> executed));
+    ring_destroy(&(pipeline -> reports));
+    pthread_mutex_destroy(&(pipeline -> lock));
+    pthread_cond_destroy(&(pipeline -> reported));
+    free(pipeline);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,81 @@
+/*
+ * File: pipeline.h
+ *
+ * Description: Function and struct definitions for running requests through
+ *              a pipeline of threads: a parser that reads and tokenizes
+ *              request lines, an executor that carries them out against
+ *              the inventory in order, a reporter that carries out the
+ *              report requests on snapshots while the executor goes on,
+ *              and a formatter that writes out what each request printed
+ *
+ * @author: Frank Abbey (fra1489)
+ * @version: 10/19/2026
+ */
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stdio.h>
+#include <pthread.h>
+#include "libinventory.h"
+
+//number of requests that can wait between two stages (must be a power of 2)
+#define RING_SIZE 1024
+//times a stage retries a full/empty ring before going to sleep on it
+#define RING_SPINS 64
+
+//bounded queue between two stages, with one producer and one consumer
+struct ring {
+    void * slots[RING_SIZE];
+    size_t head;           // next slot to be written (written by producer)
+    size_t tail;           // next slot to be read (written by consumer)
+    int closed;            // set once either side is finished with the ring
+    int sleepers;          // number of stages asleep on the ring
+    pthread_mutex_t lock;  // only taken to sleep or to wake a sleeper
+    pthread_cond_t wake;
+};
+
+//a request as it moves through the pipeline
+struct job {
+    char * line;                // the request line, the tokens point into it
+    char * tokens[MAX_LENGTH];  // the command and its arguments
+    int size;                   // number of tokens
+    char * out_text;            // what the request printed as output
+    size_t out_length;
+    char * err_text;            // what the request printed as errors
+    size_t err_length;
+    snapshot_t * snapshot;      // report: the inventory it is carried out on
+    int pending;                // report: set until the reporter is done
+};
+
+//the stages' shared state
+struct pipeline {
+    FILE * fp;            // where request lines are read from
+    inventory_t * invp;   // the inventory the executor carries them out on
+    struct ring parsed;   // parser -> executor
+    struct ring executed; // executor -> formatter
+    struct ring reports;  // executor -> reporter
+    pthread_mutex_t lock; // guards the 'pending' of every job
+    pthread_cond_t reported; // signaled when a report is done
+};
+
+//struct typedef declarations for ease of use
+typedef struct ring ring_t;
+typedef struct job job_t;
+typedef struct pipeline pipeline_t;
+
+//set up an empty ring
+void ring_init(ring_t * ring);
+//add an item to a ring, waiting for room, returns 0 if the ring is closed
+int ring_push(ring_t * ring, void * item);
+//remove an item from a ring, waiting for one, returns NULL once the ring
+//is closed and empty
+void * ring_pop(ring_t * ring);
+//mark a ring as finished and wake anyone waiting on it
+void ring_close(ring_t * ring);
+//release the resources of a ring
+void ring_destroy(ring_t * ring);
+
+//run every request in a file through the pipeline
+int run_pipeline(inventory_t * invp, FILE * fp);
+
+#endif // PIPELINE_H
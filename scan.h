@@ -0,0 +1,174 @@
+/*
+ * File: scan.h
+ *
+ * Description: Request line scanning kernels. A line is looked at
+ *              SCAN_WIDTH bytes at a time: one compare finds every space
+ *              (the token separator) in a chunk and a few more find every
+ *              whitespace character, each as a bitmask with a bit per
+ *              byte, so token boundaries are where the space mask changes.
+ *              AVX2 does 32 bytes at a time, SSE2 16, and without either
+ *              the masks are built 8 bytes at a time.
+ *
+ *              Numbers are read 8 digits at a time (SWAR, SIMD within a
+ *              register): one word test finds how many of the next 8
+ *              bytes are digits, and three multiplies turn them into their
+ *              value.
+ *
+ * @author: Frank Abbey (fra1489)
+ * @version: 10/19/2026
+ */
+#ifndef SCAN_H
+#define SCAN_H
+
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SCAN_WIDTH 32
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SCAN_WIDTH 16
+#else
+#define SCAN_WIDTH 8
+#endif
+
+//mask with a bit for each byte of a chunk with 'n' bytes left in the line
+#define SCAN_VALID(n) (((n) >= SCAN_WIDTH) ? 0xffffffffU >> (32 - SCAN_WIDTH) \
+                       : (1U << (n)) - 1)
+
+/*
+ * Determine if a character is whitespace (what isspace() is in the "C"
+ * locale: space, tab, newline, vertical tab, form feed, carriage return)
+ *
+ * @param char c - the character
+ *
+ * @return int - 1: whitespace, 0: not
+ */
+static inline int scan_is_white(char c) {
+    return c == ' ' || (unsigned char)(c - '\t') <= '\r' - '\t';
+}
+
+/*
+ * Find the spaces and the whitespace in a chunk of a line
+ *
+ * @param const char* chunk - SCAN_WIDTH bytes of the line
+ * @param unsigned int* white - set to a bit for each whitespace byte
+ *
+ * @return unsigned int - a bit for each space
+ */
+static inline unsigned int scan_chunk(const char* chunk, unsigned int* white) {
+
+#if defined(__AVX2__)
+    __m256i bytes = _mm256_loadu_si256((const __m256i*)chunk);
+    __m256i spaces = _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' '));
+    //'\t' to '\r' are the only bytes left at most 4 after taking '\t' off
+    __m256i control = _mm256_sub_epi8(bytes, _mm256_set1_epi8('\t'));
+    control = _mm256_cmpeq_epi8(_mm256_min_epu8(control,
+    _mm256_set1_epi8('\r' - '\t')), control);
+    *white = _mm256_movemask_epi8(_mm256_or_si256(spaces, control));
+    return _mm256_movemask_epi8(spaces);
+#elif defined(__SSE2__)
+    __m128i bytes = _mm_loadu_si128((const __m128i*)chunk);
+    __m128i spaces = _mm_cmpeq_epi8(bytes, _mm_set1_epi8(' '));
+    //'\t' to '\r' are the only bytes left at most 4 after taking '\t' off
+    __m128i control = _mm_sub_epi8(bytes, _mm_set1_epi8('\t'));
+    control = _mm_cmpeq_epi8(_mm_min_epu8(control,
+    _mm_set1_epi8('\r' - '\t')), control);
+    *white = _mm_movemask_epi8(_mm_or_si128(spaces, control));
+    return _mm_movemask_epi8(spaces);
+#else
+    unsigned int spaces = 0;
+    int i;
+    *white = 0;
+    for(i = 0; i < SCAN_WIDTH; i++) {
+        spaces |= (unsigned int)(chunk[i] == ' ') << i;
+        *white |= (unsigned int)scan_is_white(chunk[i]) << i;
+    }
+    return spaces;
+#endif
+}
+
+/*
+ * Find the spaces and the whitespace in the next bytes of a line, which
+ * may be fewer than SCAN_WIDTH (the last of them are copied so nothing
+ * past the line is read)
+ *
+ * @param const char* text - the bytes
+ * @param size_t left - the number of bytes left in the line
+ * @param unsigned int* white - set to a bit for each whitespace byte
+ *
+ * @return unsigned int - a bit for each space
+ */
+static inline unsigned int scan_span(const char* text, size_t left,
+                                     unsigned int* white) {
+
+    char tail[SCAN_WIDTH];
+    if(left >= SCAN_WIDTH) {
+        return scan_chunk(text, white);
+    }
+    //the copy is padded with '\0', which is neither a space nor whitespace
+    memset(tail, 0, SCAN_WIDTH);
+    memcpy(tail, text, left);
+    return scan_chunk(tail, white);
+}
+
+/*
+ * Count the digits at the start of 8 bytes
+ *
+ * @param const char* text - 8 readable bytes
+ *
+ * @return int - the number of leading digits, 0 to 8
+ */
+static inline int scan_digits(const char* text) {
+
+    unsigned long long word;
+    memcpy(&word, text, 8);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    //a byte's high bit ends up set unless it is '0' (0x30) to '9' (0x39):
+    //adding 0x46 carries a byte above '9' past 0x7f, and subtracting 0x30
+    //borrows from a byte below '0'
+    unsigned long long other = ((word + 0x4646464646464646ULL)
+    | (word - 0x3030303030303030ULL)) & 0x8080808080808080ULL;
+    //(a borrow can only set bits above the first byte that is not a digit)
+    return (other == 0) ? 8 : __builtin_ctzll(other) / 8;
+#else
+    int count = 0;
+    while(count < 8 && text[count] >= '0' && text[count] <= '9') {
+        count++;
+    }
+    return count;
+#endif
+}
+
+/*
+ * Find the value of a run of 1 to 8 digits
+ *
+ * @param const char* text - the digits, with 8 readable bytes
+ * @param int count - the number of digits
+ *
+ * @return unsigned long long - their value
+ */
+static inline unsigned long long scan_value(const char* text, int count) {
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    unsigned long long word;
+    memcpy(&word, text, 8);
+    //the first digit is the lowest byte: the digits are turned into 0 to 9
+    //and moved up so the last is the highest byte, with zeros before them
+    word = (word - 0x3030303030303030ULL) << (8 * (8 - count));
+    //then pairs of digits, pairs of pairs and pairs of those are combined
+    word = (word * 10 + (word >> 8)) & 0x00ff00ff00ff00ffULL;
+    word = (word * 100 + (word >> 16)) & 0x0000ffff0000ffffULL;
+    word = (word * 10000 + (word >> 32)) & 0x00000000ffffffffULL;
+    return word;
+#else
+    unsigned long long value = 0;
+    int i;
+    for(i = 0; i < count; i++) {
+        value = value * 10 + (text[i] - '0');
+    }
+    return value;
+#endif
+}
+
+#endif // SCAN_H
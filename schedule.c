@@ -0,0 +1,283 @@
+/*
+ * File: schedule.c
+ *
+ * Description: Runs a request file with its orders scheduled. An order
+ *              line may carry a priority ('!n', higher first, default 0)
+ *              and a deadline ('^n', earlier first among equal
+ *              priorities), and up to a window of orders are held in a
+ *              binary heap so a large low-priority order cannot take the
+ *              stock an urgent one right behind it needs. When the window
+ *              is full the most urgent order is filled to make room, and
+ *              every other request (stock, inventory, ...) first fills all
+ *              the orders waiting, so it sees them done just as it would
+ *              have without the scheduler. Ties go to the order read
+ *              first, so a file is always filled in the same order.
+ *
+ *              Afterwards the number of orders, orders per second and how
+ *              long orders waited in the heap are printed to stderr.
+ *
+ * @author: Frank Abbey (fra1489)
+ * @version: 10/19/2026
+ */
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "libinventory.h"
+#include "schedule.h"
+
+/*
+ * Nanoseconds between two times
+ *
+ * @param struct timespec* from - the earlier time
+ * @param struct timespec* to - the later time
+ *
+ * @return double - the nanoseconds between them
+ */
+static double elapsed(struct timespec* from, struct timespec* to) {
+    return (to -> tv_sec - from -> tv_sec) * 1e9
+    + (to -> tv_nsec - from -> tv_nsec);
+}
+
+/*
+ * Compare two latencies
+ *
+ * @param const void* l1 - a void pointer representing a latency
+ * @param const void* l2 - a void pointer representing a latency
+ *
+ * @return int - <0, 0, >0 as l1 is less than, equal to, greater than l2
+ */
+static int latency_compare(const void* l1, const void* l2) {
+    double d1 = *(const double*)l1;
+    double d2 = *(const double*)l2;
+    return (d1 > d2) - (d1 < d2);
+}
+
+/*
+ * Determine if one order is more urgent than another
+ *
+ * @param scheduled_t* o1 - an order
+ * @param scheduled_t* o2 - another order
+ *
+ * @return int - 1: o1 is filled before o2, 0: it is not
+ */
+static int more_urgent(scheduled_t* o1, scheduled_t* o2) {
+
+    if(o1 -> priority != o2 -> priority) {
+        return o1 -> priority > o2 -> priority;
+    }
+    if(o1 -> deadline != o2 -> deadline) {
+        return o1 -> deadline < o2 -> deadline;
+    }
+    return o1 -> sequence < o2 -> sequence;
+}
+
+/*
+ * Read a scheduling token ('!n' or '^n')
+ *
+ * @param char* token - the token
+ * @param char mark - the character the token has to start with
+ * @param long* value - set to the number after the mark
+ *
+ * @return int - 1: the token is a scheduling token, 0: it is not
+ */
+static int scheduling_token(char* token, char mark, long* value) {
+
+    char* end;
+    if(token[0] != mark || token[1] == '\0') {
+        return 0;
+    }
+    *value = strtol(token + 1, &end, 10);
+    return *end == '\0';
+}
+
+/*
+ * Add an order to the heap
+ *
+ * @param schedule_t* schedule - the scheduler
+ * @param scheduled_t* order - the order (copied into the heap)
+ */
+static void push_order(schedule_t* schedule, scheduled_t* order) {
+
+    scheduled_t* heap = schedule -> heap;
+    int i = schedule -> count++;
+    //move parents down until the order's place is found
+    while(i > 0 && more_urgent(order, &heap[(i - 1) / 2])) {
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap[i] = *order;
+}
+
+/*
+ * Take the most urgent order off the heap
+ *
+ * @param schedule_t* schedule - the scheduler (with at least one order)
+ *
+ * @return scheduled_t - the order
+ */
+static scheduled_t pop_order(schedule_t* schedule) {
+
+    scheduled_t* heap = schedule -> heap;
+    scheduled_t top = heap[0];
+    scheduled_t last = heap[--schedule -> count];
+    int count = schedule -> count;
+
+    //move the more urgent child up until the last order's place is found
+    int i = 0;
+    while(2 * i + 1 < count) {
+        int child = 2 * i + 1;
+        if(child + 1 < count && more_urgent(&heap[child + 1], &heap[child])) {
+            child++;
+        }
+        if(!more_urgent(&heap[child], &last)) {
+            break;
+        }
+        heap[i] = heap[child];
+        i = child;
+    }
+    if(count > 0) {
+        heap[i] = last;
+    }
+    return top;
+}
+
+/*
+ * Fill the most urgent order waiting, and record how long it waited
+ *
+ * @param inventory_t* invp - the inventory the order is filled from
+ * @param schedule_t* schedule - the scheduler (with at least one order)
+ */
+static void fill_next(inventory_t* invp, schedule_t* schedule) {
+
+    scheduled_t order = pop_order(schedule);
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    if(schedule -> wait_count == schedule -> wait_size) {
+        schedule -> wait_size = (schedule -> wait_size == 0) ?
+        1024 : schedule -> wait_size * 2;
+        schedule -> waits = realloc(schedule -> waits,
+        schedule -> wait_size * sizeof(double));
+    }
+    schedule -> waits[schedule -> wait_count++] = elapsed(&order.queued, &now);
+
+    process_request(invp, order.tokens, order.size);
+    free(order.tokens);
+    free(order.line);
+}
+
+/*
+ * Hold an order line back in the heap, filling the most urgent order
+ * first if the window is full
+ *
+ * @param inventory_t* invp - the inventory orders are filled from
+ * @param schedule_t* schedule - the scheduler
+ * @param char* line - the order line (kept by the scheduler)
+ * @param char* array[] - the tokens of the line
+ * @param int size - the number of tokens
+ */
+static void queue_order(inventory_t* invp, schedule_t* schedule, char* line,
+                        char* array[], int size) {
+
+    scheduled_t order;
+    order.priority = 0;
+    order.deadline = SCHEDULE_NO_DEADLINE;
+    order.sequence = schedule -> arrivals++;
+    order.line = line;
+    order.tokens = malloc(size * sizeof(char*));
+    order.size = 0;
+    clock_gettime(CLOCK_MONOTONIC, &order.queued);
+
+    //the scheduling tokens are taken out, the rest is the request
+    int i;
+    for(i = 0; i < size; i++) {
+        if(i == 0 || (!scheduling_token(array[i], '!', &order.priority)
+                      && !scheduling_token(array[i], '^', &order.deadline))) {
+            order.tokens[order.size++] = array[i];
+        }
+    }
+
+    if(schedule -> count == schedule -> window) {
+        fill_next(invp, schedule);
+    }
+    push_order(schedule, &order);
+}
+
+/*
+ * Run a request file with its orders scheduled by priority and deadline,
+ * and print the throughput and how long orders waited to stderr (stdout
+ * has what the requests print)
+ *
+ * @param inventory_t* invp - the inventory the requests are carried out on
+ * @param FILE* fp - the file the requests are read from
+ * @param int window - the most orders held back at once
+ *
+ * @return int - EXIT_SUCCESS: every request was run
+ */
+int run_schedule(inventory_t* invp, FILE* fp, int window) {
+
+    schedule_t schedule;
+    memset(&schedule, 0, sizeof(schedule));
+    schedule.window = (window > 0) ? window : 1;
+    schedule.heap = malloc(schedule.window * sizeof(scheduled_t));
+
+    char* buffer = NULL;
+    size_t n = 0;
+    char* request_array[MAX_LENGTH];
+    int request_return = 1;
+    struct timespec begin, finish;
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+
+    while(request_return && getline(&buffer, &n, fp) != -1) {
+
+        //the tokens point into the line, so each line is kept until it runs
+        char* line = strdup(buffer);
+        int size = tokenize(line, request_array);
+        if(size == 0) {
+            free(line);
+        }
+        else if(lookup_command(request_array[0]) == REQUEST_FULFILL_ORDER) {
+            queue_order(invp, &schedule, line, request_array, size);
+        }
+        else {
+            //anything else happens after every order read before it
+            while(schedule.count > 0) {
+                fill_next(invp, &schedule);
+            }
+            request_return = process_request(invp, request_array, size);
+            free(line);
+        }
+    }
+    while(schedule.count > 0) {
+        fill_next(invp, &schedule);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &finish);
+    //the report follows what the requests printed
+    fflush(stdout);
+
+    double seconds = elapsed(&begin, &finish) / 1e9;
+    long count = schedule.wait_count;
+    double* waits = schedule.waits;
+    fprintf(stderr, "orders:       %ld (window %d)\n", count,
+    schedule.window);
+    fprintf(stderr, "seconds:      %.3f\n", seconds);
+    fprintf(stderr, "orders/sec:   %.0f\n",
+    (seconds > 0) ? count / seconds : 0.0);
+    if(count > 0) {
+        qsort(waits, count, sizeof(double), latency_compare);
+        fprintf(stderr, "queued usec:  p50 %.1f  p99 %.1f  max %.1f\n",
+        waits[count / 2] / 1e3, waits[(count * 99) / 100] / 1e3,
+        waits[count - 1] / 1e3);
+    }
+
+    free(schedule.heap);
+    free(schedule.waits);
+    free(buffer);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,53 @@
+/*
+ * File: schedule.h
+ *
+ * Description: Function and struct definitions for the order scheduler,
+ *              which holds a window of orders in a binary heap and fills
+ *              the most urgent first
+ *
+ * @author: Frank Abbey (fra1489)
+ * @version: 10/19/2026
+ */
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+#include <stdio.h>
+#include <time.h>
+#include "libinventory.h"
+
+//most orders held back at once
+#define SCHEDULE_WINDOW 32
+//deadline of an order that was not given one
+#define SCHEDULE_NO_DEADLINE 0x7fffffffL
+
+//an order waiting to be filled
+struct scheduled {
+    long priority;           // higher is filled first
+    long deadline;           // earlier is filled first, at equal priority
+    unsigned long sequence;  // order of arrival, the last tie-break
+    struct timespec queued;  // when the order was read
+    char * line;             // the request line, the tokens point into it
+    char ** tokens;          // the request without its scheduling tokens
+    int size;                // number of tokens
+};
+
+//the orders waiting and what the scheduler has measured
+struct schedule {
+    struct scheduled * heap; // most urgent order first
+    int count;               // orders waiting
+    int window;              // most orders waiting at once
+    unsigned long arrivals;  // orders read so far
+    double * waits;          // nanoseconds each order waited, in order filled
+    long wait_count;
+    long wait_size;
+};
+
+//struct typedef declarations for ease of use
+typedef struct scheduled scheduled_t;
+typedef struct schedule schedule_t;
+
+//run a request file with its orders scheduled by priority and deadline,
+//and print the throughput and queueing latency to stderr
+int run_schedule(inventory_t * invp, FILE * fp, int window);
+
+#endif // SCHEDULE_H
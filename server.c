@@ -0,0 +1,546 @@
+/*
+ * File: server.c
+ *
+ * Description: Serves requests over a Unix domain socket. One inventory is
+ *              kept resident for as long as the server runs, and any number
+ *              of clients can connect and send request lines in the same
+ *              grammar as a request file. Each request's output (errors
+ *              included) is sent back followed by a line holding a single
+ *              '.', and 'quit' ends only that client's session. A client
+ *              whose first bytes are the binary magic speaks the binary
+ *              protocol instead, with a reply frame for every request frame.
+ *
+ * Table of Contents:
+ *
+ *      Section:           Line:
+ *      ------------------ -----
+ *      CLIENTS               47
+ *      REQUESTS             191
+ *      EVENT LOOP           391
+ *
+ * @author: Frank Abbey (fra1489)
+ * @version: 10/19/2026
+ */
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include "libinventory.h"
+#include "server.h"
+#include "binproto.h"
+
+//set by SIGINT/SIGTERM to shut the server down
+static volatile sig_atomic_t stopping = 0;
+//every connected client
+static client_t* client_list = NULL;
+
+/* - - - CLIENTS - - -*/
+
+/*
+ * Ask the event loop to stop
+ *
+ * @param int signal - the signal that was caught
+ */
+static void stop_server(int signal) {
+    (void)signal;
+    stopping = 1;
+}
+
+/*
+ * Add bytes to the end of a growable buffer
+ *
+ * @param char** buffer - the buffer
+ * @param size_t* length - the number of bytes in the buffer
+ * @param size_t* size - the number of bytes the buffer can hold
+ * @param const char* bytes - the bytes to be added
+ * @param size_t n - the number of bytes to be added
+ */
+static void append(char** buffer, size_t* length, size_t* size,
+                   const char* bytes, size_t n) {
+
+    if(*length + n > *size) {
+        while(*length + n > *size) {
+            *size = (*size == 0) ? 256 : *size * 2;
+        }
+        *buffer = realloc(*buffer, *size);
+    }
+    memcpy(*buffer + *length, bytes, n);
+    *length += n;
+}
+
+/*
+ * Add a newly accepted connection to the client list
+ *
+ * @param int epfd - the event loop's epoll instance
+ * @param int fd - the connection
+ */
+static void add_client(int epfd, int fd) {
+
+    client_t* client = calloc(1, sizeof(client_t));
+    client -> fd = fd;
+
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = client;
+
+    if(epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &event) == -1) {
+        perror("epoll_ctl");
+        close(fd);
+        free(client);
+        return;
+    }
+
+    client -> next = client_list;
+    client_list = client;
+}
+
+/*
+ * Disconnect a client and remove it from the client list
+ *
+ * @param int epfd - the event loop's epoll instance
+ * @param client_t* client - the client to be removed
+ */
+static void remove_client(int epfd, client_t* client) {
+
+    epoll_ctl(epfd, EPOLL_CTL_DEL, client -> fd, NULL);
+    close(client -> fd);
+
+    //unlink the client from the list
+    if(client_list == client) {
+        client_list = client -> next;
+    }
+    else {
+        client_t* previous = client_list;
+        while(previous -> next != client) {
+            previous = previous -> next;
+        }
+        previous -> next = client -> next;
+    }
+
+    free(client -> in_buffer);
+    free(client -> out_buffer);
+    free(client);
+}
+
+/*
+ * Write as much of a client's pending replies as the socket will take
+ *
+ * @param client_t* client - the client to write to
+ *
+ * @return int - 1: the write went fine (some may still be pending),
+ *               0: the client is gone
+ */
+static int flush_client(client_t* client) {
+
+    while(client -> out_sent < client -> out_length) {
+        ssize_t num = send(client -> fd,
+        client -> out_buffer + client -> out_sent,
+        client -> out_length - client -> out_sent, MSG_NOSIGNAL);
+
+        if(num > 0) {
+            client -> out_sent += num;
+        }
+        else if(num == -1 && errno == EINTR) {
+            continue;
+        }
+        else if(num == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return 1;
+        }
+        else {
+            return 0;
+        }
+    }
+
+    client -> out_length = 0;
+    client -> out_sent = 0;
+    return 1;
+}
+
+/*
+ * Wait for writes only while replies are pending, and stop reading from a
+ * client that is closing
+ *
+ * @param int epfd - the event loop's epoll instance
+ * @param client_t* client - the client to be updated
+ */
+static void watch_client(int epfd, client_t* client) {
+
+    struct epoll_event event;
+    event.events = 0;
+    event.data.ptr = client;
+
+    if(!(client -> closing)) {
+        event.events |= EPOLLIN;
+    }
+    if(client -> out_sent < client -> out_length) {
+        event.events |= EPOLLOUT;
+    }
+    epoll_ctl(epfd, EPOLL_CTL_MOD, client -> fd, &event);
+}
+
+/* - - - REQUESTS - - -*/
+
+/*
+ * Run every complete request frame a binary client has sent, and queue the
+ * reply frames
+ *
+ * @param inventory_t* invp - the inventory the requests are carried out on
+ * @param frames_t* frames - the binary session the frames are run in
+ * @param client_t* client - the client whose requests are run
+ * @param FILE* reply - the stream the reply frames are built in
+ * @param char** reply_buffer - the reply stream's buffer
+ * @param size_t* reply_size - the number of bytes in the reply stream
+ *
+ * @return size_t - the number of bytes of the client's input used up
+ */
+static size_t run_frames(inventory_t* invp, frames_t* frames,
+                         client_t* client, FILE* reply, char** reply_buffer,
+                         size_t* reply_size) {
+
+    const unsigned char* input = (unsigned char*)(client -> in_buffer);
+    size_t start = 0;
+
+    while(!(client -> closing) && client -> in_length - start >= 4) {
+
+        size_t length = get_length(input + start);
+        if(length > BINARY_MAX_FRAME) {
+            fprintf(stderr, "!!! client frame too long\n");
+            client -> closing = 1;
+            return client -> in_length;
+        }
+        //wait for the rest of the frame
+        if(client -> in_length - start - 4 < length) {
+            return start;
+        }
+
+        if(!run_frame(invp, frames, input + start + 4, length, reply)) {
+            client -> closing = 1;
+        }
+        start += 4 + length;
+
+        fflush(reply);
+        append(&(client -> out_buffer), &(client -> out_length),
+        &(client -> out_size), *reply_buffer, *reply_size);
+        fseeko(reply, 0, SEEK_SET);
+    }
+    return start;
+}
+
+/*
+ * Run every complete request line a text client has sent, and queue the
+ * replies
+ *
+ * @param inventory_t* invp - the inventory the requests are carried out on
+ * @param client_t* client - the client whose requests are run
+ * @param FILE* reply - the stream requests print their output to
+ * @param char** reply_buffer - the reply stream's buffer
+ * @param size_t* reply_size - the number of bytes in the reply stream
+ *
+ * @return size_t - the number of bytes of the client's input used up
+ */
+static size_t run_lines(inventory_t* invp, client_t* client, FILE* reply,
+                        char** reply_buffer, size_t* reply_size) {
+
+    char* request_array[MAX_LENGTH];
+    size_t start = 0;
+    char* newline;
+
+    while(!(client -> closing)
+          && (newline = memchr(client -> in_buffer + start, '\n',
+              client -> in_length - start)) != NULL) {
+
+        char* line = client -> in_buffer + start;
+        *newline = '\0';
+        start = (newline - client -> in_buffer) + 1;
+
+        int size = tokenize(line, request_array);
+        //blank lines and comments get no reply
+        if(size != 0) {
+            set_output(invp, reply, reply);
+            if(!process_request(invp, request_array, size)) {
+                client -> closing = 1;
+            }
+            set_output(invp, stdout, stderr);
+
+            fflush(reply);
+            append(&(client -> out_buffer), &(client -> out_length),
+            &(client -> out_size), *reply_buffer, *reply_size);
+            append(&(client -> out_buffer), &(client -> out_length),
+            &(client -> out_size), REPLY_END, strlen(REPLY_END));
+            fseeko(reply, 0, SEEK_SET);
+        }
+    }
+    return start;
+}
+
+/*
+ * Run every complete request a client has sent, and queue the replies. The
+ * first bytes a client sends decide whether it speaks text or binary.
+ *
+ * @param inventory_t* invp - the inventory the requests are carried out on
+ * @param frames_t* frames - the binary session frames are run in
+ * @param client_t* client - the client whose requests are run
+ * @param FILE* reply - the stream requests print their output to
+ * @param char** reply_buffer - the reply stream's buffer
+ * @param size_t* reply_size - the number of bytes in the reply stream
+ */
+static void run_requests(inventory_t* invp, frames_t* frames,
+                         client_t* client, FILE* reply, char** reply_buffer,
+                         size_t* reply_size) {
+
+    size_t start = 0;
+
+    if(client -> in_length == 0) {
+        return;
+    }
+
+    if(client -> format == CLIENT_UNKNOWN) {
+        if(client -> in_buffer[0] != '\0') {
+            client -> format = CLIENT_TEXT;
+        }
+        else if(client -> in_length < BINARY_MAGIC_LENGTH) {
+            return;
+        }
+        else if(memcmp(client -> in_buffer, BINARY_MAGIC,
+                BINARY_MAGIC_LENGTH) == 0) {
+            //binary replies start with the magic too
+            client -> format = CLIENT_BINARY;
+            append(&(client -> out_buffer), &(client -> out_length),
+            &(client -> out_size), BINARY_MAGIC, BINARY_MAGIC_LENGTH);
+            start = BINARY_MAGIC_LENGTH;
+        }
+        else {
+            fprintf(stderr, "!!! client sent a bad binary magic\n");
+            client -> closing = 1;
+            start = client -> in_length;
+        }
+    }
+
+    //drop the magic before running any requests
+    if(start > 0) {
+        memmove(client -> in_buffer, client -> in_buffer + start,
+        client -> in_length - start);
+        client -> in_length -= start;
+    }
+
+    start = 0;
+    if(client -> format == CLIENT_BINARY) {
+        start = run_frames(invp, frames, client, reply, reply_buffer,
+        reply_size);
+    }
+    else if(client -> format == CLIENT_TEXT) {
+        start = run_lines(invp, client, reply, reply_buffer, reply_size);
+    }
+
+    //keep whatever is left of a partial request for the next read
+    memmove(client -> in_buffer, client -> in_buffer + start,
+    client -> in_length - start);
+    client -> in_length -= start;
+}
+
+/*
+ * Read what a client has sent so far. Reading stops once more than
+ * MAX_REQUEST bytes are buffered, so the complete requests can be run
+ * before the rest is read on the next event.
+ *
+ * @param client_t* client - the client to read from
+ *
+ * @return int - 1: the client is still connected, 
+ *               0: the client closed its end of the connection,
+ *              -1: the connection failed
+ */
+static int read_client(client_t* client) {
+
+    char chunk[4096];
+
+    while(client -> in_length <= MAX_REQUEST) {
+        ssize_t num = read(client -> fd, chunk, sizeof(chunk));
+
+        if(num > 0) {
+            append(&(client -> in_buffer), &(client -> in_length),
+            &(client -> in_size), chunk, num);
+        }
+        else if(num == -1 && errno == EINTR) {
+            continue;
+        }
+        else if(num == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return 1;
+        }
+        else if(num == 0) {
+            return 0;
+        }
+        else {
+            return -1;
+        }
+    }
+    return 1;
+}
+
+/* - - - EVENT LOOP - - -*/
+
+/*
+ * Open a listening Unix domain socket, replacing a stale socket file
+ *
+ * @param char* path - the file system path of the socket
+ *
+ * @return int - the listening socket, -1 if it could not be opened
+ */
+static int listen_on(char* path) {
+
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+
+    if(strlen(path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "!!! %s: socket path too long\n", path);
+        return -1;
+    }
+    strcpy(address.sun_path, path);
+
+    //a socket left behind by an earlier server is removed, nothing else is
+    struct stat info;
+    if(stat(path, &info) == 0 && S_ISSOCK(info.st_mode)) {
+        unlink(path);
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if(fd == -1
+       || bind(fd, (struct sockaddr*)&address, sizeof(address)) == -1
+       || listen(fd, SOMAXCONN) == -1) {
+        perror(path);
+        if(fd != -1) {
+            close(fd);
+        }
+        return -1;
+    }
+
+    return fd;
+}
+
+/*
+ * Serve requests on a Unix domain socket until the server is sent SIGINT
+ * or SIGTERM. The inventory is shared by every client, and the requests
+ * are run one at a time in the order they arrive.
+ *
+ * @param inventory_t* invp - the inventory the requests are carried out on
+ * @param char* path - the file system path of the socket
+ *
+ * @return int - EXIT_FAILURE: the socket could not be opened
+ *               EXIT_SUCCESS: the server was shut down
+ */
+int run_server(inventory_t* invp, char* path) {
+
+    int listen_fd = listen_on(path);
+    if(listen_fd == -1) {
+        return EXIT_FAILURE;
+    }
+
+    int epfd = epoll_create1(0);
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = NULL;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, listen_fd, &event);
+
+    //without SA_RESTART, epoll_wait() returns when a signal arrives
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = stop_server;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    //requests print into this stream, which is copied to the client
+    char* reply_buffer = NULL;
+    size_t reply_size = 0;
+    FILE* reply = open_memstream(&reply_buffer, &reply_size);
+    //binary clients take turns, so they can share one session
+    frames_t* frames = open_frames();
+
+    struct epoll_event events[MAX_EVENTS];
+
+    while(!stopping) {
+
+        int count = epoll_wait(epfd, events, MAX_EVENTS, -1);
+        if(count == -1) {
+            if(errno != EINTR) {
+                perror("epoll_wait");
+                stopping = 1;
+            }
+            count = 0;
+        }
+
+        int i;
+        for(i = 0; i < count; i++) {
+
+            client_t* client = events[i].data.ptr;
+
+            //new connections
+            if(client == NULL) {
+                int fd;
+                while((fd = accept(listen_fd, NULL, NULL)) != -1) {
+                    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+                    add_client(epfd, fd);
+                }
+            }
+            else {
+                int connected = 1;
+
+                if(events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                    int status = read_client(client);
+                    run_requests(invp, frames, client, reply, &reply_buffer,
+                    &reply_size);
+                    //a client that is done sending still gets its replies
+                    if(status == 0) {
+                        client -> closing = 1;
+                    }
+                    else if(status == -1) {
+                        connected = 0;
+                    }
+                    //what is left is one unfinished line: refuse to hold an
+                    //endless one. run_frames() already caps binary frames.
+                    else if(client -> format != CLIENT_BINARY
+                            && !(client -> closing)
+                            && client -> in_length > MAX_REQUEST) {
+                        fprintf(stderr, "!!! client request too long\n");
+                        connected = 0;
+                    }
+                }
+                if(!flush_client(client)) {
+                    connected = 0;
+                }
+
+                //a client that is closing goes once it has its replies
+                if(client -> closing && client -> out_length == 0) {
+                    connected = 0;
+                }
+
+                if(connected) {
+                    watch_client(epfd, client);
+                }
+                else {
+                    remove_client(epfd, client);
+                }
+            }
+        }
+    }
+
+    while(client_list != NULL) {
+        remove_client(epfd, client_list);
+    }
+    close(epfd);
+    close(listen_fd);
+    unlink(path);
+    fclose(reply);
+    free(reply_buffer);
+    close_frames(frames);
+
+    return EXIT_SUCCESS;
+}
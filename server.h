@@ -0,0 +1,50 @@
+/*
+ * File: server.h
+ *
+ * Description: Function and struct definitions for serving requests to
+ *              many clients over a Unix domain socket, with one inventory
+ *              kept resident between client sessions
+ *
+ * @author: Frank Abbey (fra1489)
+ * @version: 10/19/2026
+ */
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <stddef.h>
+#include "libinventory.h"
+
+//most epoll events handled per wait
+#define MAX_EVENTS 64
+//longest request line a client may send before it is disconnected
+#define MAX_REQUEST 65536
+//line that ends every reply, so clients know the request is done
+#define REPLY_END ".\n"
+
+//what a client speaks, known from the first byte it sends
+#define CLIENT_UNKNOWN 0
+#define CLIENT_TEXT 1
+#define CLIENT_BINARY 2
+
+//struct to represent a connected client
+struct client {
+    int fd;
+    char * in_buffer;     // bytes read but not yet run as requests
+    size_t in_length;
+    size_t in_size;
+    char * out_buffer;    // replies not yet written to the client
+    size_t out_length;
+    size_t out_size;
+    size_t out_sent;      // bytes of out_buffer already written
+    int closing;          // 'quit' or end of input, close once replied
+    int format;           // CLIENT_ text or binary requests and replies
+    struct client * next; // next client in the server's client list
+};
+
+//struct typedef declarations for ease of use
+typedef struct client client_t;
+
+//serve requests on a Unix domain socket until interrupted
+int run_server(inventory_t * invp, char * path);
+
+#endif // SERVER_H
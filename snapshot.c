@@ -0,0 +1,350 @@
+/*
+ * File: snapshot.c
+ *
+ * Description: Snapshots of an inventory. Taking one copies the handle and
+ *              starts a new epoch, which costs the same however large the
+ *              inventory is. After that, the first change a request makes
+ *              to a page of 'on_hand' values in an epoch copies the page
+ *              as it was, if a snapshot taken since the page last changed
+ *              is still out; readers find each value on the live page, or
+ *              if the page has changed since their epoch, in its version.
+ *              The catalog and the capacities cannot change while a
+ *              snapshot is out, so 'on_hand' is all that is versioned.
+ *
+ *              One thread carries out requests and takes the snapshots;
+ *              any thread can read and release them. A version is freed by
+ *              the request thread once every snapshot old enough to read
+ *              it has been released (its epoch is past), so readers never
+ *              take a lock or wait for a request to finish.
+ *
+ * @author: Frank Abbey (fra1489)
+ * @version: 10/19/2026
+ */
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "snapshot.h"
+
+/*
+ * Size the per-page arrays of an inventory's versions for the rows its
+ * 'on_hand' array can hold. Only done while no snapshot is out, or when
+ * the rows have not grown since the last one was taken (the catalog cannot
+ * change while one is out), so no reader is looking at the arrays moved.
+ *
+ * @param inventory_t* invp - the inventory
+ */
+static void size_pages(inventory_t* invp) {
+
+    struct versions* versions = invp -> versions;
+    int count = (invp -> assembly_size + SNAPSHOT_PAGE_ROWS - 1)
+    / SNAPSHOT_PAGE_ROWS;
+
+    if(count > versions -> page_count) {
+        versions -> written = realloc(versions -> written,
+        count * sizeof(unsigned long));
+        versions -> pages = realloc(versions -> pages,
+        count * sizeof(struct page_version*));
+        //new pages have not changed since any snapshot was taken
+        int page;
+        for(page = versions -> page_count; page < count; page++) {
+            versions -> written[page] = 0;
+            versions -> pages[page] = NULL;
+        }
+        versions -> page_count = count;
+    }
+}
+
+/*
+ * Free the versions no snapshot still out can read: those of epochs
+ * before the oldest snapshot's. Versions are retired in the order they
+ * were kept, so their epochs only go up, and a page's versions are
+ * reclaimed oldest first, which makes each one the last of its page's list.
+ *
+ * @param struct versions* versions - the inventory's versions
+ */
+static void reclaim(struct versions* versions) {
+
+    unsigned long oldest = __atomic_load_n(&(versions -> oldest),
+    __ATOMIC_ACQUIRE);
+
+    while(versions -> retired_first != NULL
+          && versions -> retired_first -> to < oldest) {
+
+        struct page_version* version = versions -> retired_first;
+        versions -> retired_first = version -> retired;
+
+        //a reader stops at a newer version of the page (one changed in an
+        //epoch no later than its own) before it could reach this one
+        struct page_version** link = &(versions -> pages[version -> page]);
+        while(*link != version) {
+            link = &((*link) -> next);
+        }
+        __atomic_store_n(link, NULL, __ATOMIC_RELEASE);
+        free(version);
+    }
+    if(versions -> retired_first == NULL) {
+        versions -> retired_last = NULL;
+    }
+}
+
+/*
+ * Keep a page of 'on_hand' values as it is before a request first changes
+ * it in the current epoch, if a snapshot still out was taken since the
+ * page last changed. The page is marked as changed before the caller
+ * changes it, so a reader that reads the live value while it changes sees
+ * the mark afterwards and reads the version instead.
+ *
+ * @param inventory_t* invp - the inventory (with versions)
+ * @param int handle - the handle of the assembly whose row will change
+ */
+void preserve_page(inventory_t* invp, int handle) {
+
+    struct versions* versions = invp -> versions;
+    int page = handle / SNAPSHOT_PAGE_ROWS;
+
+    //pages added since the last snapshot was taken no snapshot can read
+    if(page >= versions -> page_count
+       || versions -> written[page] == versions -> epoch) {
+        return;
+    }
+    reclaim(versions);
+
+    unsigned long oldest = __atomic_load_n(&(versions -> oldest),
+    __ATOMIC_ACQUIRE);
+    if(oldest != SNAPSHOT_NONE
+       && versions -> latest >= versions -> written[page]) {
+
+        int rows = invp -> assembly_size - page * SNAPSHOT_PAGE_ROWS;
+        rows = (rows < SNAPSHOT_PAGE_ROWS) ? rows : SNAPSHOT_PAGE_ROWS;
+        size_t count = (size_t)rows * invp -> site_size;
+
+        struct page_version* version = malloc(sizeof(struct page_version)
+        + count * sizeof(long long));
+        STATS_COUNT(invp, allocations);
+        version -> from = versions -> written[page];
+        version -> to = versions -> epoch - 1;
+        version -> page = page;
+        version -> retired = NULL;
+        memcpy(version -> values, invp -> on_hand
+        + (size_t)page * SNAPSHOT_PAGE_ROWS * invp -> site_size,
+        count * sizeof(long long));
+
+        version -> next = versions -> pages[page];
+        __atomic_store_n(&(versions -> pages[page]), version,
+        __ATOMIC_RELEASE);
+
+        if(versions -> retired_last != NULL) {
+            versions -> retired_last -> retired = version;
+        }
+        else {
+            versions -> retired_first = version;
+        }
+        versions -> retired_last = version;
+    }
+
+    //the mark is seen before any of the changes that follow it: they are
+    //atomic stores (see SET_ON_HAND), so a snapshot that reads one of them
+    //and then fences finds the mark too
+    __atomic_store_n(&(versions -> written[page]), versions -> epoch,
+    __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+/*
+ * Take a snapshot of an inventory as it is now. Only the thread carrying
+ * out the inventory's requests may take one.
+ *
+ * @param inventory_t* invp - the inventory
+ *
+ * @return snapshot_t* - the snapshot, to be released with release_snapshot
+ */
+snapshot_t* take_snapshot(inventory_t* invp) {
+
+    if(invp -> versions == NULL) {
+        struct versions* versions = calloc(1, sizeof(struct versions));
+        versions -> epoch = 1;
+        versions -> oldest = SNAPSHOT_NONE;
+        pthread_mutex_init(&(versions -> lock), NULL);
+        pthread_cond_init(&(versions -> released), NULL);
+        invp -> versions = versions;
+    }
+    struct versions* versions = invp -> versions;
+
+    pthread_mutex_lock(&(versions -> lock));
+    if(versions -> active == NULL) {
+        size_pages(invp);
+    }
+    pthread_mutex_unlock(&(versions -> lock));
+    reclaim(versions);
+
+    struct snapshot* snapshot = malloc(sizeof(struct snapshot));
+    snapshot -> epoch = versions -> epoch;
+    snapshot -> versions = versions;
+    snapshot -> found = calloc(versions -> page_count,
+    sizeof(struct page_version*));
+    snapshot -> view = *invp;
+    snapshot -> view.snapshot = snapshot;
+    snapshot -> view.record = NULL;
+    snapshot -> next = NULL;
+
+    pthread_mutex_lock(&(versions -> lock));
+    struct snapshot** link = &(versions -> active);
+    while(*link != NULL) {
+        link = &((*link) -> next);
+    }
+    *link = snapshot;
+    __atomic_store_n(&(versions -> oldest), versions -> active -> epoch,
+    __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&(versions -> lock));
+
+    //changes from here on are made in the next epoch
+    versions -> latest = versions -> epoch;
+    versions -> epoch++;
+
+    return snapshot;
+}
+
+/*
+ * Release a snapshot, from any thread. The versions only it could read are
+ * freed by the inventory's next request that changes the stock.
+ *
+ * @param snapshot_t* snapshot - the snapshot
+ */
+void release_snapshot(snapshot_t* snapshot) {
+
+    struct versions* versions = snapshot -> versions;
+
+    pthread_mutex_lock(&(versions -> lock));
+    struct snapshot** link = &(versions -> active);
+    while(*link != snapshot) {
+        link = &((*link) -> next);
+    }
+    *link = snapshot -> next;
+    __atomic_store_n(&(versions -> oldest), (versions -> active != NULL)
+    ? versions -> active -> epoch : SNAPSHOT_NONE, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&(versions -> released));
+    pthread_mutex_unlock(&(versions -> lock));
+
+    free(snapshot -> found);
+    free(snapshot);
+}
+
+/*
+ * Read an 'on_hand' value of an assembly as of a snapshot. The live value
+ * is good if its page has not changed since the snapshot's epoch, before
+ * and after it is read; otherwise the page's newest version from no later
+ * than the snapshot's epoch has it. That version is the one for as long
+ * as the snapshot is out, so it is only searched for once.
+ *
+ * @param snapshot_t* snapshot - the snapshot
+ * @param int handle - the handle of the assembly
+ * @param int site - the site
+ *
+ * @return long long - the value as of the snapshot
+ */
+long long snapshot_on_hand(snapshot_t* snapshot, int handle, int site) {
+
+    struct versions* versions = snapshot -> versions;
+    inventory_t* view = &(snapshot -> view);
+    int page = handle / SNAPSHOT_PAGE_ROWS;
+    unsigned long* written = &(versions -> written[page]);
+    struct page_version* version = snapshot -> found[page];
+
+    if(version == NULL) {
+        if(__atomic_load_n(written, __ATOMIC_ACQUIRE) <= snapshot -> epoch) {
+            long long value = __atomic_load_n(&(ON_HAND(view,
+            &(view -> assembly_table[handle]))[site]), __ATOMIC_RELAXED);
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if(__atomic_load_n(written, __ATOMIC_RELAXED)
+               <= snapshot -> epoch) {
+                return value;
+            }
+        }
+
+        version = __atomic_load_n(&(versions -> pages[page]),
+        __ATOMIC_ACQUIRE);
+        while(version -> from > snapshot -> epoch) {
+            version = __atomic_load_n(&(version -> next), __ATOMIC_ACQUIRE);
+        }
+        snapshot -> found[page] = version;
+    }
+    return version -> values[(size_t)(handle % SNAPSHOT_PAGE_ROWS)
+    * view -> site_size + site];
+}
+
+/*
+ * Wait until every snapshot of an inventory has been released, and free
+ * the versions kept for them. Anything that changes the catalog (or moves
+ * the arrays snapshots read) waits first.
+ *
+ * @param inventory_t* invp - the inventory
+ */
+void wait_snapshots(inventory_t* invp) {
+
+    struct versions* versions = invp -> versions;
+    if(versions == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&(versions -> lock));
+    while(versions -> active != NULL) {
+        pthread_cond_wait(&(versions -> released), &(versions -> lock));
+    }
+    pthread_mutex_unlock(&(versions -> lock));
+    reclaim(versions);
+}
+
+/*
+ * Add up the bytes an inventory's versions take: the per-page arrays and
+ * every page version kept (the versions are only freed by the thread
+ * carrying out requests, which is the one asking)
+ *
+ * @param inventory_t* invp - the inventory
+ * @param long long* count - set to the number of page versions kept
+ *
+ * @return size_t - the bytes
+ */
+size_t versions_bytes(inventory_t* invp, long long* count) {
+
+    struct versions* versions = invp -> versions;
+    *count = 0;
+    if(versions == NULL) {
+        return 0;
+    }
+
+    size_t bytes = sizeof(struct versions) + versions -> page_count
+    * (sizeof(unsigned long) + sizeof(struct page_version*));
+    struct page_version* version;
+    for(version = versions -> retired_first; version != NULL;
+        version = version -> retired) {
+        int rows = invp -> assembly_size - version -> page * SNAPSHOT_PAGE_ROWS;
+        rows = (rows < SNAPSHOT_PAGE_ROWS) ? rows : SNAPSHOT_PAGE_ROWS;
+        bytes += sizeof(struct page_version)
+        + (size_t)rows * invp -> site_size * sizeof(long long);
+        (*count)++;
+    }
+    return bytes;
+}
+
+/*
+ * Free the versions of an inventory, once its snapshots have been released
+ *
+ * @param inventory_t* invp - the inventory
+ */
+void free_versions(inventory_t* invp) {
+
+    struct versions* versions = invp -> versions;
+    if(versions == NULL) {
+        return;
+    }
+
+    wait_snapshots(invp);
+    pthread_mutex_destroy(&(versions -> lock));
+    pthread_cond_destroy(&(versions -> released));
+    free(versions -> written);
+    free(versions -> pages);
+    free(versions);
+    invp -> versions = NULL;
+}
@@ -0,0 +1,106 @@
+/*
+ * File: snapshot.h
+ *
+ * Description: Struct and function definitions for snapshots, read-only
+ *              views of an inventory as it was at one point in time. A
+ *              snapshot can be read by another thread while requests
+ *              carry on changing the stock; the 'on_hand' values they
+ *              change are kept a page at a time, as they were, for as long
+ *              as a snapshot may still read them.
+ *
+ * @author: Frank Abbey (fra1489)
+ * @version: 10/19/2026
+ */
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <pthread.h>
+#include "inventory.h"
+
+//assemblies whose rows of 'on_hand' values are kept together as one page
+//(the fuzz harness makes pages smaller, so its few assemblies span several)
+#ifndef SNAPSHOT_PAGE_ROWS
+#define SNAPSHOT_PAGE_ROWS 64
+#endif
+//'oldest' when there are no snapshots
+#define SNAPSHOT_NONE (~0UL)
+
+//Time is counted in epochs. Requests change the stock in the current
+//epoch, and a snapshot sees every change made up to the end of the epoch
+//it was taken in (the next epoch starts as it is taken).
+
+//a page of 'on_hand' values as it was from epoch 'from' to epoch 'to',
+//before a request changed it
+struct page_version {
+    unsigned long from;            // epoch the page was last changed in
+    unsigned long to;              // epoch before the one that changed it
+    int page;                      // the page
+    struct page_version * next;    // next older version of the same page
+    struct page_version * retired; // next version to be reclaimed
+    long long values[];            // the page's rows, 'site_size' values each
+};
+
+//the versions of an inventory's 'on_hand' pages kept for its snapshots
+//(everything but 'oldest' and 'active' is only changed by the thread
+//carrying out requests)
+struct versions {
+    unsigned long epoch;           // epoch requests change the stock in
+    unsigned long latest;          // epoch of the last snapshot taken
+    unsigned long oldest;          // epoch of the oldest snapshot not yet
+                                   // released, SNAPSHOT_NONE if there is none
+    unsigned long * written;       // epoch each page was last changed in
+    struct page_version ** pages;  // versions of each page, newest first
+    int page_count;                // pages 'written' and 'pages' hold
+    struct page_version * retired_first; // versions, oldest first
+    struct page_version * retired_last;
+    struct snapshot * active;      // snapshots not yet released, oldest
+                                   // first
+    pthread_mutex_t lock;          // guards 'active' and 'oldest'
+    pthread_cond_t released;       // signaled when a snapshot is released
+};
+
+//a read-only view of an inventory. 'view' is a copy of the inventory's
+//handle as it was, so requests carried out on it find the catalog as it
+//was (the catalog does not change while there are snapshots, see
+//wait_snapshots) and read 'on_hand' values through the snapshot.
+struct snapshot {
+    unsigned long epoch;           // epoch the snapshot was taken in
+    struct versions * versions;    // the versions it reads
+    struct page_version ** found;  // the version of each page it reads, by
+                                   // page, NULL until the page changes
+    struct inventory view;         // the inventory as it was
+    struct snapshot * next;        // next newer snapshot not yet released
+};
+
+//keep a page of 'on_hand' values as it is before a request first changes
+//it in an epoch, if a snapshot may still need it (only called when the
+//inventory has versions, see PRESERVE)
+void preserve_page(inventory_t * invp, int handle);
+//read an 'on_hand' value of an assembly as of a snapshot
+long long snapshot_on_hand(snapshot_t * snapshot, int handle, int site);
+//wait until every snapshot of an inventory has been released, and drop
+//the versions kept for them (never called with a snapshot held by the
+//same thread)
+void wait_snapshots(inventory_t * invp);
+//free an inventory's versions (after wait_snapshots)
+void free_versions(inventory_t * invp);
+//bytes an inventory's versions take, setting 'count' to the number of
+//page versions kept (only called by the thread carrying out requests)
+size_t versions_bytes(inventory_t * invp, long long * count);
+
+//keep the page holding an assembly's 'on_hand' row before it is changed
+#define PRESERVE(invp, assembly) \
+    do { \
+        if((invp) -> versions != NULL) { \
+            preserve_page(invp, (assembly) -> handle); \
+        } \
+    } while(0)
+
+//an 'on_hand' value of an assembly as the inventory (which may be the view
+//of a snapshot) sees it
+#define STOCK_AT(invp, assembly, site) \
+    (((invp) -> snapshot != NULL) \
+    ? snapshot_on_hand((invp) -> snapshot, (assembly) -> handle, site) \
+    : ON_HAND(invp, assembly)[site])
+
+#endif // SNAPSHOT_H
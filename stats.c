@@ -0,0 +1,226 @@
+/*
+ * File: stats.c
+ *
+ * Description: Request statistics. Each request's latency goes into a
+ *              histogram for its kind of request, where buckets double in
+ *              width every eight buckets, so any latency is kept to within
+ *              12.5% in a fixed amount of memory. The counters are bumped
+ *              in place by the STATS_ macros in stats.h.
+ *
+ * @author: Frank Abbey (fra1489)
+ * @version: 10/19/2026
+ */
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "inventory.h"
+#include "stats.h"
+
+#ifdef STATS
+
+/*
+ * Find the histogram bucket of a latency
+ *
+ * @param unsigned long long nanoseconds - the latency
+ *
+ * @return int - the bucket
+ */
+static int bucket_of(unsigned long long nanoseconds) {
+
+    if(nanoseconds < HISTOGRAM_SUB_COUNT) {
+        return nanoseconds;
+    }
+    //the highest bit picks the power of two, the bits below it the sub-bucket
+    int bit = 63 - __builtin_clzll(nanoseconds);
+    int shift = bit - HISTOGRAM_SUB_BITS;
+    return (shift + 1) * HISTOGRAM_SUB_COUNT
+    + ((nanoseconds >> shift) & (HISTOGRAM_SUB_COUNT - 1));
+}
+
+/*
+ * Find the largest latency that falls in a histogram bucket
+ *
+ * @param int bucket - the bucket
+ *
+ * @return unsigned long long - the latency, in nanoseconds
+ */
+static unsigned long long bucket_top(int bucket) {
+
+    if(bucket < HISTOGRAM_SUB_COUNT) {
+        return bucket;
+    }
+    int shift = bucket / HISTOGRAM_SUB_COUNT - 1;
+    unsigned long long low = (unsigned long long)(HISTOGRAM_SUB_COUNT
+    + bucket % HISTOGRAM_SUB_COUNT) << shift;
+    return low + ((1ULL << shift) - 1);
+}
+
+/*
+ * Find a percentile of a histogram
+ *
+ * @param histogram_t* histogram - the histogram
+ * @param double percent - the percentile, from 0 to 100
+ *
+ * @return unsigned long long - the latency, in nanoseconds (at most)
+ */
+static unsigned long long percentile(histogram_t* histogram, double percent) {
+
+    unsigned long target = (unsigned long)(histogram -> total * percent / 100);
+    unsigned long seen = 0;
+    int bucket;
+    for(bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++) {
+        seen += histogram -> counts[bucket];
+        if(seen > target) {
+            break;
+        }
+    }
+    if(bucket == HISTOGRAM_BUCKETS) {
+        bucket--;
+    }
+    unsigned long long top = bucket_top(bucket);
+    return (top < histogram -> max) ? top : histogram -> max;
+}
+
+/*
+ * Write the statistics of an inventory to its dump file
+ *
+ * @param inventory_t* invp - the inventory
+ */
+static void dump_stats(inventory_t* invp) {
+
+    FILE* fp = fopen(invp -> stats.dump_path, "w");
+    if(!fp) {
+        perror(invp -> stats.dump_path);
+        return;
+    }
+    print_stats(invp, fp);
+    fclose(fp);
+}
+
+/*
+ * Record the latency of a request, and dump the statistics if it is time
+ *
+ * @param inventory_t* invp - the inventory the request was carried out on
+ * @param int code - the REQUEST_ code of the request
+ * @param struct timespec* start - when the request started
+ */
+void stats_record(inventory_t* invp, int code, struct timespec* start) {
+
+    stats_t* stats = &(invp -> stats);
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    long long nanoseconds = (end.tv_sec - start -> tv_sec) * 1000000000LL
+    + (end.tv_nsec - start -> tv_nsec);
+    if(nanoseconds < 0) {
+        nanoseconds = 0;
+    }
+
+    histogram_t* histogram = &(stats -> requests[code]);
+    histogram -> counts[bucket_of(nanoseconds)]++;
+    histogram -> total++;
+    if((unsigned long long)nanoseconds > histogram -> max) {
+        histogram -> max = nanoseconds;
+    }
+
+    if(stats -> dump_path != NULL
+       && ++stats -> since_dump >= stats -> dump_every) {
+        stats -> since_dump = 0;
+        dump_stats(invp);
+    }
+}
+
+/*
+ * Print a table of an inventory's request latencies and counters
+ *
+ * @param inventory_t* invp - the inventory
+ * @param FILE* fp - the stream to print to
+ */
+void print_stats(inventory_t* invp, FILE* fp) {
+
+    stats_t* stats = &(invp -> stats);
+    fprintf(fp, "Request stats:\n");
+    fprintf(fp, "--------------\n");
+    fprintf(fp, "%-12s %9s %10s %10s %10s\n", "Command", "count",
+    "p50 usec", "p99 usec", "max usec");
+    fprintf(fp, "============ ========= ========== ========== ==========\n");
+
+    int code;
+    for(code = 0; code < REQUEST_COUNT; code++) {
+        histogram_t* histogram = &(stats -> requests[code]);
+        if(histogram -> total > 0) {
+            fprintf(fp, "%-12s %9lu %10.1f %10.1f %10.1f\n",
+            command_names[code], histogram -> total,
+            percentile(histogram, 50) / 1e3,
+            percentile(histogram, 99) / 1e3, histogram -> max / 1e3);
+        }
+    }
+
+    fprintf(fp, "Counters:\n");
+    fprintf(fp, "---------\n");
+    fprintf(fp, "make calls      %12lu\n", stats -> make_calls);
+    fprintf(fp, "deepest make    %12d\n", stats -> make_depth_max);
+    fprintf(fp, "add_item calls  %12lu\n", stats -> add_item_calls);
+    fprintf(fp, "lookups         %12lu\n", stats -> lookups);
+    fprintf(fp, "lookup probes   %12lu\n", stats -> lookup_probes);
+    fprintf(fp, "filter rejects  %12lu\n", stats -> filter_rejects);
+    fprintf(fp, "allocations     %12lu\n", stats -> allocations);
+}
+
+/*
+ * Dump an inventory's statistics to a file every so many requests
+ *
+ * @param inventory_t* invp - the inventory
+ * @param char* path - the file, NULL to stop dumping
+ * @param unsigned long every - the number of requests between dumps
+ */
+void stats_dump_to(inventory_t* invp, char* path, unsigned long every) {
+
+    stats_t* stats = &(invp -> stats);
+    free(stats -> dump_path);
+    stats -> dump_path = (path != NULL) ? strdup(path) : NULL;
+    stats -> dump_every = (every > 0) ? every : STATS_DUMP_EVERY;
+    stats -> since_dump = 0;
+}
+
+#else
+
+/*
+ * Statistics are not kept in this build
+ *
+ * @param inventory_t* invp - the inventory the request was carried out on
+ * @param int code - the REQUEST_ code of the request
+ * @param struct timespec* start - when the request started
+ */
+void stats_record(inventory_t* invp, int code, struct timespec* start) {
+    (void)invp;
+    (void)code;
+    (void)start;
+}
+
+/*
+ * Say that statistics are not kept in this build
+ *
+ * @param inventory_t* invp - the inventory whose error stream is used
+ * @param FILE* fp - the stream that would have been printed to
+ */
+void print_stats(inventory_t* invp, FILE* fp) {
+    (void)fp;
+    fprintf(invp -> err, "!!! stats: not compiled in (build with -DSTATS)\n");
+}
+
+/*
+ * Say that statistics are not kept in this build
+ *
+ * @param inventory_t* invp - the inventory whose error stream is used
+ * @param char* path - the file that would have been dumped to
+ * @param unsigned long every - the number of requests between dumps
+ */
+void stats_dump_to(inventory_t* invp, char* path, unsigned long every) {
+    (void)path;
+    (void)every;
+    fprintf(invp -> err, "!!! stats: not compiled in (build with -DSTATS)\n");
+}
+
+#endif // STATS
@@ -0,0 +1,97 @@
+/*
+ * File: stats.h
+ *
+ * Description: Function, struct and macro definitions for the request
+ *              statistics: a latency histogram for each kind of request
+ *              and counters for the work done inside them, kept for each
+ *              inventory separately
+ *
+ *              Statistics are only kept when built with -DSTATS. Otherwise
+ *              every STATS_ macro expands to nothing, so the rest of the
+ *              program compiles exactly as if they were not there.
+ *
+ * @author: Frank Abbey (fra1489)
+ * @version: 10/19/2026
+ */
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+#include <time.h>
+#include "libinventory.h"
+
+//sub-buckets per power of two (2^3 = 8, so a bucket is within 12.5%)
+#define HISTOGRAM_SUB_BITS 3
+#define HISTOGRAM_SUB_COUNT (1 << HISTOGRAM_SUB_BITS)
+//enough buckets for any 64-bit number of nanoseconds
+#define HISTOGRAM_BUCKETS ((64 - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_COUNT)
+//requests between dumps when no count is given
+#define STATS_DUMP_EVERY 1000
+
+//log-bucketed latencies of one kind of request
+struct histogram {
+    unsigned long counts[HISTOGRAM_BUCKETS];
+    unsigned long total;       // number of latencies recorded
+    unsigned long long max;    // slowest, in nanoseconds
+};
+
+//everything that is counted
+struct stats {
+    struct histogram requests[REQUEST_COUNT];
+    unsigned long make_calls;     // times an assembly was made (recursively)
+    int make_depth;               // current depth of make recursion
+    int make_depth_max;           // deepest make recursion seen
+    unsigned long add_item_calls;
+    unsigned long lookups;        // part/assembly/item list searches
+    unsigned long lookup_probes;  // list nodes looked at by those searches
+    unsigned long filter_rejects; // lookups turned away by an ID filter
+    unsigned long allocations;
+    unsigned long since_dump;     // requests since the last dump
+    char * dump_path;             // file dumped to, NULL if not dumping
+    unsigned long dump_every;     // requests between dumps
+};
+
+//struct typedef declarations for ease of use
+typedef struct histogram histogram_t;
+typedef struct stats stats_t;
+
+#ifdef STATS
+
+#define STATS_COUNT(invp, counter) ((invp) -> stats.counter++)
+#define STATS_ADD(invp, counter, n) ((invp) -> stats.counter += (n))
+#define STATS_ENTER_MAKE(invp) \
+    do { \
+        (invp) -> stats.make_calls++; \
+        if(++(invp) -> stats.make_depth > (invp) -> stats.make_depth_max) { \
+            (invp) -> stats.make_depth_max = (invp) -> stats.make_depth; \
+        } \
+    } while(0)
+#define STATS_LEAVE_MAKE(invp) ((invp) -> stats.make_depth--)
+#define STATS_START(start) \
+    struct timespec start; \
+    clock_gettime(CLOCK_MONOTONIC, &start)
+#define STATS_STOP(invp, code, start) stats_record(invp, code, &start)
+#define STATS_FREE(invp) stats_dump_to(invp, NULL, 0)
+
+#else
+
+//the inventory is still used, so functions that only pass it to the
+//counters compile without warnings
+#define STATS_COUNT(invp, counter) ((void)(invp))
+#define STATS_ADD(invp, counter, n) ((void)(invp))
+#define STATS_ENTER_MAKE(invp) ((void)(invp))
+#define STATS_LEAVE_MAKE(invp) ((void)(invp))
+#define STATS_START(start) ((void)0)
+#define STATS_STOP(invp, code, start) ((void)(invp))
+#define STATS_FREE(invp) ((void)(invp))
+
+#endif // STATS
+
+//record the latency of a request that started at a given time
+void stats_record(inventory_t * invp, int code, struct timespec * start);
+//print the statistics, or say they are not compiled in
+void print_stats(inventory_t * invp, FILE * fp);
+//dump the statistics to a file every so many requests (NULL to stop)
+void stats_dump_to(inventory_t * invp, char * path, unsigned long every);
+
+#endif // STATS_H
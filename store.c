@@ -0,0 +1,180 @@
+/*
+ * File: store.c
+ *
+ * Description: The catalog store. A store file is mapped into a range of
+ *              STORE_RESERVE bytes of address space set aside when it is
+ *              opened, shared with the file, so the pages of the file are
+ *              only read in when they are first touched and opening a store
+ *              takes the same time however large it is. Room is handed out
+ *              from the end of what is in use, and when the file runs out
+ *              it is made twice as long in place; nothing handed out is
+ *              ever moved or given back (an array that grows is handed out
+ *              again, which at most doubles the size of the file).
+ *
+ *              Changes reach the page cache as they are made and the file
+ *              whenever the system writes them back; store_sync() writes
+ *              them all out before it returns.
+ *
+ * @author: Frank Abbey (fra1489)
+ * @version: 10/19/2026
+ */
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "store.h"
+
+/*
+ * Round a size up to a multiple of STORE_ALIGN
+ *
+ * @param unsigned long long size - the size
+ *
+ * @return unsigned long long - the size rounded up
+ */
+static unsigned long long store_round(unsigned long long size) {
+    return (size + STORE_ALIGN - 1) & ~(unsigned long long)(STORE_ALIGN - 1);
+}
+
+/*
+ * Open a store file, creating it if it does not exist
+ *
+ * @param const char* path - the file
+ *
+ * @return store_t* - the open store, NULL if the file could not be opened
+ *                    or mapped (errno says why) or is not a store file
+ *                    (errno is EINVAL)
+ */
+store_t* store_open(const char* path) {
+
+    struct stat status;
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if(fd < 0) {
+        return NULL;
+    }
+    //a new file is given its initial size, which reads as zeros
+    if(fstat(fd, &status) != 0 || (status.st_size == 0
+       && ftruncate(fd, STORE_INITIAL_SIZE) != 0)) {
+        close(fd);
+        return NULL;
+    }
+    size_t size = (status.st_size == 0) ? STORE_INITIAL_SIZE
+    : (size_t)status.st_size;
+    if(size < sizeof(store_header_t) || size > STORE_RESERVE) {
+        close(fd);
+        errno = EINVAL;
+        return NULL;
+    }
+
+    char* base = mmap(NULL, STORE_RESERVE, PROT_READ | PROT_WRITE,
+    MAP_SHARED | MAP_NORESERVE, fd, 0);
+    if(base == MAP_FAILED) {
+        close(fd);
+        return NULL;
+    }
+
+    store_header_t* header = (store_header_t*)base;
+    if(status.st_size == 0) {
+        memcpy(header -> magic, STORE_MAGIC, sizeof(header -> magic));
+        header -> version = STORE_VERSION;
+        header -> used = store_round(sizeof(store_header_t));
+    }
+    else if(memcmp(header -> magic, STORE_MAGIC, sizeof(header -> magic))
+            != 0 || header -> version != STORE_VERSION
+            || header -> used > size) {
+        munmap(base, STORE_RESERVE);
+        close(fd);
+        errno = EINVAL;
+        return NULL;
+    }
+
+    store_t* store = calloc(1, sizeof(store_t));
+    store -> fd = fd;
+    store -> base = base;
+    store -> header = header;
+    store -> size = size;
+    return store;
+}
+
+/*
+ * Hand out room for an array at the end of a store, making the file
+ * longer if it has to
+ *
+ * @param store_t* store - the store
+ * @param size_t bytes - the size of the array
+ *
+ * @return void* - the array, aligned to STORE_ALIGN (not cleared)
+ */
+void* store_alloc(store_t* store, size_t bytes) {
+
+    unsigned long long offset = store_round(store -> header -> used);
+    unsigned long long end = offset + bytes;
+
+    if(end > store -> size) {
+        unsigned long long size = store -> size;
+        while(size < end) {
+            size *= 2;
+        }
+        if(size > STORE_RESERVE || ftruncate(store -> fd, size) != 0) {
+            fprintf(stderr, "!!! store: no room for %zu more bytes\n", bytes);
+            exit(EXIT_FAILURE);
+        }
+        store -> size = size;
+    }
+    store -> header -> used = end;
+    return store -> base + offset;
+}
+
+/*
+ * Find the offset of an address in a store
+ *
+ * @param store_t* store - the store
+ * @param const void* address - an address in the store, or NULL
+ *
+ * @return unsigned long long - its offset from the start of the file, 0
+ *                              for NULL (the header is at offset 0, so no
+ *                              array is)
+ */
+unsigned long long store_offset(store_t* store, const void* address) {
+    return (address == NULL) ? 0 : (unsigned long long)((const char*)address
+    - store -> base);
+}
+
+/*
+ * Find the address of an offset in a store
+ *
+ * @param store_t* store - the store
+ * @param unsigned long long offset - an offset from the start of the file
+ *
+ * @return void* - the address it is mapped at, NULL for offset 0
+ */
+void* store_address(store_t* store, unsigned long long offset) {
+    return (offset == 0) ? NULL : store -> base + offset;
+}
+
+/*
+ * Write every change made to a store to its file
+ *
+ * @param store_t* store - the store
+ *
+ * @return int - 1: the file is up to date, 0: it could not be written
+ */
+int store_sync(store_t* store) {
+    return msync(store -> base, store -> header -> used, MS_SYNC) == 0;
+}
+
+/*
+ * Unmap and close a store
+ *
+ * @param store_t* store - the store
+ */
+void store_close(store_t* store) {
+    munmap(store -> base, STORE_RESERVE);
+    close(store -> fd);
+    free(store);
+}
@@ -0,0 +1,122 @@
+/*
+ * File: store.h
+ *
+ * Description: Struct and function definitions for the catalog store, a
+ *              file an inventory's catalog and stock live in while it is
+ *              open. The file is mapped into memory and handed out to the
+ *              inventory's arrays from front to back, so everything in it
+ *              is found by its offset from the start of the file and the
+ *              file can be mapped anywhere the next time it is opened.
+ *
+ * @author: Frank Abbey (fra1489)
+ * @version: 10/19/2026
+ */
+#ifndef STORE_H
+#define STORE_H
+
+#include <stddef.h>
+
+//the first bytes of every store file
+#define STORE_MAGIC "INVSTORE"
+//changed whenever the header or what the offsets lead to changes
+#define STORE_VERSION 5
+//address space a store is mapped into, the most its file can ever grow to:
+//the mapping never has to move as the file grows, so pointers into it stay
+//good for as long as it is open
+#define STORE_RESERVE (1ULL << 36)
+//size of a new store file, which doubles whenever it runs out of room
+#define STORE_INITIAL_SIZE (1UL << 20)
+//what every array handed out is aligned to (a cache line)
+#define STORE_ALIGN 64
+//requests carried out between checkpoints
+#define STORE_CHECKPOINT 10000
+
+//the first bytes of the file: what it is, how much of it is in use, and
+//where the inventory was as of the last checkpoint
+struct store_header {
+    char magic[8];                   // STORE_MAGIC (without its NUL)
+    unsigned int version;            // STORE_VERSION
+    unsigned int layout;             // sizes of what the inventory keeps
+                                     // in the file, 0: nothing kept yet
+    unsigned long long used;         // bytes handed out, the header included
+    unsigned long long checkpoints;  // checkpoints written
+    //the inventory's counts
+    int part_count;
+    int part_size;
+    int part_list;
+    int assembly_count;
+    int assembly_size;
+    int assembly_list;
+    int bom_count;
+    int bom_size;
+    int bom_row_count;
+    int bom_row_size;
+    int bom_index_size;
+    int site_count;
+    int site_size;
+    int part_filter_blocks;
+    int part_filter_count;
+    int assembly_filter_blocks;
+    int assembly_filter_count;
+    int part_dict_count;
+    int part_dict_size;
+    int part_dict_byte_count;
+    int part_dict_byte_size;
+    int assembly_dict_count;
+    int assembly_dict_size;
+    int assembly_dict_byte_count;
+    int assembly_dict_byte_size;
+    unsigned long long order_count;
+    //offsets of the inventory's arrays in the file, 0: not allocated
+    unsigned long long part_table;
+    unsigned long long part_stock;
+    unsigned long long part_ids;
+    unsigned long long assembly_table;
+    unsigned long long assembly_ids;
+    unsigned long long on_hand;
+    unsigned long long bom_child;
+    unsigned long long bom_quantity;
+    unsigned long long bom_rows;
+    unsigned long long bom_index;
+    unsigned long long site_names;
+    unsigned long long part_filter;
+    unsigned long long assembly_filter;
+    unsigned long long part_dict_firsts;
+    unsigned long long part_dict_offsets;
+    unsigned long long part_dict_bytes;
+    unsigned long long part_dict_handles;
+    unsigned long long assembly_dict_firsts;
+    unsigned long long assembly_dict_offsets;
+    unsigned long long assembly_dict_bytes;
+    unsigned long long assembly_dict_handles;
+};
+
+//an open store file
+struct store {
+    int fd;                          // the file
+    char * base;                     // where it is mapped
+    struct store_header * header;    // at the start of the mapping
+    size_t size;                     // length of the file
+    unsigned long requests;          // requests since the last checkpoint
+};
+
+//struct typedef declarations for ease of use
+typedef struct store_header store_header_t;
+typedef struct store store_t;
+
+//open a store file, creating it if it does not exist, returns NULL (with
+//errno set) if it could not be opened or is not a store file
+store_t * store_open(const char * path);
+//hand out room for an array at the end of the store, aligned to
+//STORE_ALIGN (the program exits if the file cannot grow to hold it)
+void * store_alloc(store_t * store, size_t bytes);
+//find the offset of an address in the store (0 for NULL)
+unsigned long long store_offset(store_t * store, const void * address);
+//find the address of an offset in the store (NULL for 0)
+void * store_address(store_t * store, unsigned long long offset);
+//write every change to the file, returns 0 if it could not be written
+int store_sync(store_t * store);
+//unmap and close a store file (changes not synced may still be written)
+void store_close(store_t * store);
+
+#endif // STORE_H